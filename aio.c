@@ -0,0 +1,302 @@
+#define _GNU_SOURCE          // syscall, MUST be first line
+#define _FILE_OFFSET_BITS 64 // same off_t as fileio.c
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>         // struct iovec
+#include "aio.h"
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define AIO_HAVE_URING 1
+#endif
+
+/* ===================== COMPLETION LIST ===================== */
+static void push_done(AioRing *ring, AioOp *op)
+{
+    op->next = NULL;
+    if (ring->done_tail) ring->done_tail->next = op; else ring->done_head = op;
+    ring->done_tail = op;
+}
+
+/* ===================== FALLBACK: pread / pwrite ===================== */
+static void run_sync(AioOp *op)
+{
+    while (op->done < op->len)
+    {
+        ssize_t n = op->write ? pwrite(op->fd, op->buf + op->done, op->len - op->done, op->off + op->done)
+                              : pread(op->fd, op->buf + op->done, op->len - op->done, op->off + op->done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0)
+        {
+            op->res = -errno;
+            return;
+        }
+        if (n == 0) break;                       // EOF: short read
+        op->done += n;
+    }
+    op->res = op->done;
+}
+
+#ifdef AIO_HAVE_URING
+/* ===================== io_uring: RAW SYSCALLS ===================== */
+static int sys_setup(unsigned entries, struct io_uring_params *p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int sys_register(int fd, unsigned opcode, const void *arg, unsigned nr)
+{
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr);
+}
+
+static Status uring_setup(AioRing *ring)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+
+    int fd = sys_setup(AIO_DEPTH, &p);
+    if (fd < 0) return e_failure;                // ENOSYS, EPERM (io_uring_disabled, seccomp) ...
+
+    ring->fd = fd;
+    ring->entries = p.sq_entries;
+    ring->sq_ring_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_ring_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (ring->cq_ring_len > ring->sq_ring_len) ring->sq_ring_len = ring->cq_ring_len;
+        ring->cq_ring_len = 0;                   // shares the SQ mapping
+    }
+
+    void *sq = mmap(NULL, ring->sq_ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                    IORING_OFF_SQ_RING);
+    void *cq = MAP_FAILED;
+    if (sq != MAP_FAILED)
+        cq = ring->cq_ring_len ? mmap(NULL, ring->cq_ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                      fd, IORING_OFF_CQ_RING)
+                               : sq;
+    ring->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = MAP_FAILED;
+    if (cq != MAP_FAILED)
+        sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        if (cq != MAP_FAILED && ring->cq_ring_len) munmap(cq, ring->cq_ring_len);
+        if (sq != MAP_FAILED) munmap(sq, ring->sq_ring_len);
+        close(fd);
+        ring->fd = -1;
+        return e_failure;
+    }
+
+    ring->sq_ring = sq;
+    ring->cq_ring = cq;
+    ring->sqes = sqes;
+    ring->sq_head = (unsigned *)(ring->sq_ring + p.sq_off.head);
+    ring->sq_tail = (unsigned *)(ring->sq_ring + p.sq_off.tail);
+    ring->sq_mask = (unsigned *)(ring->sq_ring + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(ring->sq_ring + p.sq_off.array);
+    ring->cq_head = (unsigned *)(ring->cq_ring + p.cq_off.head);
+    ring->cq_tail = (unsigned *)(ring->cq_ring + p.cq_off.tail);
+    ring->cq_mask = (unsigned *)(ring->cq_ring + p.cq_off.ring_mask);
+    ring->cqes = ring->cq_ring + p.cq_off.cqes;
+    return e_success;
+}
+
+/* Hand every written SQE to the kernel; with wait, also block for one
+   completion. e_failure only if the ring itself is unusable. */
+static Status uring_enter(AioRing *ring, int wait)
+{
+    for (;;)
+    {
+        int n = sys_enter(ring->fd, ring->queued, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0);
+        ring->submits++;
+        if (n >= 0)
+        {
+            ring->queued -= n;
+            ring->inflight += n;
+            return e_success;
+        }
+        if (errno != EINTR && errno != EAGAIN && errno != EBUSY) return e_failure;
+    }
+}
+
+/* Write the SQE for what is left of op */
+static void uring_prep(AioRing *ring, AioOp *op)
+{
+    unsigned tail = *ring->sq_tail;
+    unsigned idx = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = (struct io_uring_sqe *)ring->sqes + idx;
+    unsigned char *addr = op->buf + op->done;
+    size_t len = op->len - op->done;
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = op->write ? IORING_OP_WRITE : IORING_OP_READ;
+    for (int i = 0; i < ring->nbufs; i++)
+    {
+        if (addr >= ring->buf_base[i] && addr + len <= ring->buf_base[i] + ring->buf_len[i])
+        {
+            sqe->opcode = op->write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+            sqe->buf_index = i;
+            break;
+        }
+    }
+    sqe->fd = op->fd;
+    sqe->off = op->off + op->done;
+    sqe->addr = (uintptr_t)addr;
+    sqe->len = len;
+    sqe->user_data = (uintptr_t)op;
+
+    ring->sq_array[idx] = idx;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->queued++;
+}
+
+/* Take one CQE, waiting for it: *done is its op if that is finished, NULL otherwise */
+static Status uring_reap(AioRing *ring, AioOp **done)
+{
+    unsigned head = *ring->cq_head;
+
+    *done = NULL;
+    while (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+    {
+        if (uring_enter(ring, 1) != e_success) return e_failure;
+    }
+
+    struct io_uring_cqe *cqe = (struct io_uring_cqe *)ring->cqes + (head & *ring->cq_mask);
+    AioOp *op = (AioOp *)(uintptr_t)cqe->user_data;
+    int res = cqe->res;
+    __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+    ring->inflight--;
+
+    if (res < 0)
+    {
+        op->res = res;
+        *done = op;
+        return e_success;
+    }
+    op->done += res;
+    if (res > 0 && op->done < op->len)
+    {
+        uring_prep(ring, op);                    // short transfer: queue the rest
+        return e_success;
+    }
+    op->res = op->done;                          // complete, or a read that hit EOF
+    *done = op;
+    return e_success;
+}
+#endif // AIO_HAVE_URING
+
+/* ===================== API ===================== */
+Status aio_init(AioRing *ring, AioMode mode)
+{
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+#ifdef AIO_HAVE_URING
+    if (mode != e_aio_pread) uring_setup(ring);
+#else
+    (void)mode;
+#endif
+    return e_success;                            // the fallback always works
+}
+
+const char *aio_backend_name(const AioRing *ring)
+{
+    return ring->fd >= 0 ? "io_uring" : "pread/pwrite";
+}
+
+void aio_register_buffers(AioRing *ring, unsigned char *const bases[], const size_t lens[], int count)
+{
+#ifdef AIO_HAVE_URING
+    struct iovec iov[AIO_MAX_BUFFERS];
+
+    if (ring->fd < 0 || count > AIO_MAX_BUFFERS) return;
+    for (int i = 0; i < count; i++)
+    {
+        iov[i].iov_base = bases[i];
+        iov[i].iov_len = lens[i];
+    }
+    if (sys_register(ring->fd, IORING_REGISTER_BUFFERS, iov, count) != 0) return;
+    for (int i = 0; i < count; i++)
+    {
+        ring->buf_base[i] = bases[i];
+        ring->buf_len[i] = lens[i];
+    }
+    ring->nbufs = count;
+#else
+    (void)ring;
+    (void)bases;
+    (void)lens;
+    (void)count;
+#endif
+}
+
+void aio_queue(AioRing *ring, AioOp *op)
+{
+    op->done = 0;
+    op->res = 0;
+#ifdef AIO_HAVE_URING
+    if (ring->fd >= 0)
+    {
+        /* keep queued + in flight within the ring so completions never overflow */
+        Status ret = e_success;
+        while (ret == e_success && ring->queued + ring->inflight >= ring->entries)
+        {
+            AioOp *done;
+            ret = uring_reap(ring, &done);
+            if (done) push_done(ring, done);
+        }
+        if (ret == e_success)
+        {
+            uring_prep(ring, op);
+            if (ring->queued == ring->entries) uring_enter(ring, 0);
+            return;
+        }
+    }
+#endif
+    run_sync(op);
+    push_done(ring, op);
+}
+
+AioOp *aio_next(AioRing *ring)
+{
+    for (;;)
+    {
+        AioOp *op = ring->done_head;
+        if (op)
+        {
+            ring->done_head = op->next;
+            if (!ring->done_head) ring->done_tail = NULL;
+            return op;
+        }
+#ifdef AIO_HAVE_URING
+        if (ring->fd < 0 || (!ring->queued && !ring->inflight)) return NULL;
+        if (uring_reap(ring, &op) != e_success) return NULL;    // ops still out are lost with the ring
+        if (op) return op;
+#else
+        return NULL;
+#endif
+    }
+}
+
+void aio_destroy(AioRing *ring)
+{
+    while (aio_next(ring)) ;                     // the kernel must be done with every buffer
+#ifdef AIO_HAVE_URING
+    if (ring->fd >= 0)
+    {
+        munmap(ring->sqes, ring->sqes_len);
+        if (ring->cq_ring_len) munmap(ring->cq_ring, ring->cq_ring_len);
+        munmap(ring->sq_ring, ring->sq_ring_len);
+        close(ring->fd);
+    }
+#endif
+    ring->fd = -1;
+}
@@ -0,0 +1,86 @@
+#ifndef AIO_H
+#define AIO_H
+
+#include <stdint.h>
+#include <sys/types.h>   // off_t
+#include "types.h"
+
+/*----------------------------------------------------------
+    Asynchronous file I/O for batches of whole-file jobs
+
+    One thread queues many reads and writes, then collects them
+    as they complete. On Linux with io_uring (raw syscalls, no
+    liburing) the queue is submitted in batches and the device
+    sees up to AIO_DEPTH requests at once; transfers into
+    registered buffers use the _FIXED opcodes, so the kernel
+    does not pin pages on every request. Where io_uring is
+    missing or disabled, the same calls fall back to
+    pread / pwrite, run synchronously at queue time.
+----------------------------------------------------------*/
+
+#define AIO_DEPTH 256                 // submission queue entries
+#define AIO_CHUNK (1 << 20)           // large transfers are split into requests of this size
+#define AIO_MAX_BUFFERS 2             // registered buffers (one per batch arena)
+
+typedef enum
+{
+    e_aio_off,                        // no batched I/O (zeroed options)
+    e_aio_auto,                       // io_uring if the kernel allows it, else pread / pwrite
+    e_aio_pread                       // always pread / pwrite
+} AioMode;
+
+/* One transfer. The ring only keeps the pointer until it completes. */
+typedef struct _AioOp
+{
+    int fd;
+    int write;                        // 1: pwrite, 0: pread
+    unsigned char *buf;
+    size_t len;
+    off_t off;
+    int64_t res;                      // after completion: bytes moved, or -errno
+    size_t done;                      // bytes moved so far (short transfers are resubmitted)
+    void *owner;                      // caller's data
+    struct _AioOp *next;              // completion list of the pread / pwrite fallback
+} AioOp;
+
+typedef struct _AioRing
+{
+    int fd;                           // io_uring instance, -1 on the fallback
+    unsigned char *sq_ring, *cq_ring; // mapped rings (cq_ring == sq_ring with a single mmap)
+    size_t sq_ring_len, cq_ring_len;
+    void *sqes;                       // struct io_uring_sqe[entries]
+    size_t sqes_len;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    void *cqes;                       // struct io_uring_cqe[]
+    unsigned entries;
+    unsigned queued;                  // SQEs written but not yet submitted
+    unsigned inflight;                // submitted, not yet completed
+    unsigned char *buf_base[AIO_MAX_BUFFERS];   // registered buffers
+    size_t buf_len[AIO_MAX_BUFFERS];
+    int nbufs;
+    AioOp *done_head, *done_tail;     // fallback: completed at queue time
+    int64_t submits;                  // io_uring_enter calls (statistics)
+} AioRing;
+
+/* Set up a ring; e_aio_pread, or a kernel without io_uring, gives the fallback */
+Status aio_init(AioRing *ring, AioMode mode);
+
+/* "io_uring" or "pread/pwrite" */
+const char *aio_backend_name(const AioRing *ring);
+
+/* Register up to AIO_MAX_BUFFERS long-lived buffers. Transfers inside them
+   use the fixed-buffer opcodes; failure (e.g. RLIMIT_MEMLOCK) is harmless. */
+void aio_register_buffers(AioRing *ring, unsigned char *const bases[], const size_t lens[], int count);
+
+/* Queue op (fd, write, buf, len, off, owner set by the caller). Transfers
+   above AIO_CHUNK must be split by the caller to keep the queue deep. */
+void aio_queue(AioRing *ring, AioOp *op);
+
+/* Next completed op (op->res set), waiting for one if needed; NULL once
+   nothing is queued or in flight */
+AioOp *aio_next(AioRing *ring);
+
+void aio_destroy(AioRing *ring);
+
+#endif // AIO_H
@@ -0,0 +1,433 @@
+#define _FILE_OFFSET_BITS 64 // pread / pwrite past 2 GB, MUST be first line
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>        // PRId64
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include "archive.h"
+#include "container.h"       // layout of the files, chunks and checksums
+#include "stego.h"           // where each container byte sits in the image
+#include "lsb.h"             // LSB_BLOCK_SIZE
+#include "crc32c.h"          // chunk checksums
+#include "fileio.h"          // mapping, pread / pwrite helpers
+#include "pool.h"            // parallel_for over chunks
+#include "progress.h"        // byte counter + background reporter
+#include "stream.h"          // STREAM_NAME
+#include "console.h"         // cprintf (silent in batch workers)
+
+#define GREEN  "\033[0;32m"
+#define RESET  "\033[0m"
+
+/* ===================== CONTAINER BYTES <-> IMAGE ===================== */
+/* Embed container bytes [k, k+n) into out_fd, a block at a time; *crc (if
+   given) is continued over the plain bytes while they are in cache */
+static Status embed_bytes(const StegoInfo *info, int64_t k, const unsigned char *src, int64_t n,
+                          const unsigned char *cover, int out_fd, uint32_t *crc)
+{
+    unsigned char block[STEGO_SPAN_MAX(LSB_BLOCK_SIZE)];
+
+    for (int64_t done = 0; done < n; done += LSB_BLOCK_SIZE)
+    {
+        size_t m = (n - done > LSB_BLOCK_SIZE) ? LSB_BLOCK_SIZE : (size_t)(n - done);
+        int64_t pos = stego_data_pos(info, k + done);
+        size_t span = stego_data_span(info, k + done, m);
+
+        stego_embed_data(info, k + done, src + done, m, cover + pos, block);
+        if (crc) *crc = crc32c(*crc, src + done, m);
+        if (write_all_at(out_fd, block, span, pos) != e_success) return e_failure;
+    }
+    return e_success;
+}
+
+/* Extract container bytes [k, k+n) from image_fd into out: e_failure on a
+   short read, e_bad_crc on a block the ECC parity cannot repair */
+static Status extract_bytes(const StegoInfo *info, int64_t k, int64_t n, int image_fd,
+                            unsigned char *out)
+{
+    unsigned char block[STEGO_SPAN_MAX(LSB_BLOCK_SIZE)];
+
+    for (int64_t done = 0; done < n; done += LSB_BLOCK_SIZE)
+    {
+        size_t m = (n - done > LSB_BLOCK_SIZE) ? LSB_BLOCK_SIZE : (size_t)(n - done);
+        if (read_all_at(image_fd, block, stego_data_span(info, k + done, m),
+                        stego_data_pos(info, k + done)) != e_success)
+            return e_failure;
+        if (stego_extract_data(info, k + done, block, m, out + done) != e_success)
+            return e_bad_crc;                 // beyond what the parity repairs
+    }
+    return e_success;
+}
+
+/* ===================== EMBED ONE CHUNK PER TASK ===================== */
+typedef struct
+{
+    const StegoInfo *stego;          // layout from stego_plan
+    Container *container;            // chunk CRCs are filled in here
+    const unsigned char *cover;      // mapped source image
+    MappedFile *files;               // mapped input files
+    int out_fd;                      // stego image, written with pwrite
+    Progress *progress;              // shared byte counter
+} EmbedChunkCtx;
+
+static Status embed_chunks(void *arg, int64_t begin, int64_t end)
+{
+    EmbedChunkCtx *ctx = arg;
+
+    for (int64_t i = begin; i < end; i++)
+    {
+        ContainerChunk *ch = &ctx->container->chunks[i];
+        const ContainerFile *file = &ctx->container->files[ch->file];
+        const unsigned char *src = ctx->files[ch->file].data +
+                                   (ch->offset - ctx->container->data_start - file->offset);
+        uint32_t crc = 0;
+
+        if (embed_bytes(ctx->stego, ch->offset, src, ch->length, ctx->cover, ctx->out_fd, &crc) != e_success)
+            return e_failure;
+        ch->crc = crc;                       // each task owns its own chunks
+        progress_add(ctx->progress, ch->length);
+    }
+    return e_success;
+}
+
+/* ===================== -c: MANY FILES, ONE COVER ===================== */
+Status do_container_encoding(EncodeInfo *encInfo, char *files[], int count)
+{
+    MappedFile cover;
+    MappedFile *maps = calloc(count, sizeof(*maps));
+    const char **names = calloc(count, sizeof(*names));
+    int64_t *sizes = calloc(count, sizeof(*sizes));
+    Container container = { 0 };
+    PixelView view;
+    size_t need;
+    int mapped = 0, out_fd = -1, cloned = 0;
+    Status ret = (maps && names && sizes) ? e_success : e_failure;
+
+    cprintf("\n───────────────────────────────────────────────\n");
+    cprintf("🕵️  STEGANOGRAPHY TOOL - CONTAINER ENCODING STARTED\n");
+    cprintf("───────────────────────────────────────────────\n");
+    cprintf("📁 Cover Image : %s\n", encInfo->src_image_fname);
+    cprintf("📁 Output Image: %s\n", encInfo->stego_image_fname);
+    cprintf("📦 Files       : %d\n\n", count);
+
+    /* Step 1: Map the cover and every file; names are stored without their directories */
+    cprintf("   1️⃣  Mapping %d file(s) ................ ", count + 1);
+    if (ret == e_success && map_file(encInfo->src_image_fname, &cover) != e_success)
+    {
+        cprintf("✖️\n\n🎯 STATUS: FAILED — Cannot map image: %s\n", encInfo->src_image_fname);
+        ret = e_failure;
+    }
+    for (; ret == e_success && mapped < count; mapped++)
+    {
+        if (map_file(files[mapped], &maps[mapped]) != e_success)
+        {
+            cprintf("✖️\n\n🎯 STATUS: FAILED — Cannot map file: %s\n", files[mapped]);
+            ret = e_failure;
+            unmap_file(&cover);
+            break;
+        }
+        const char *slash = strrchr(files[mapped], '/');
+        names[mapped] = slash ? slash + 1 : files[mapped];
+        sizes[mapped] = maps[mapped].size;
+    }
+    if (ret == e_success) cprintf("✔️\n");
+
+    /* Step 2: Lay out the container and check it fits */
+    if (ret == e_success)
+    {
+        cprintf("   2️⃣  Checking image capacity ........... ");
+        StegoOptions opts = { .depth = encInfo->depth, .flags = STEGO_FLAG_CONTAINER };
+        if (encInfo->passphrase)
+        {
+            opts.flags |= STEGO_FLAG_CHACHA;
+            opts.passphrase = encInfo->passphrase;
+        }
+
+        if (container_plan(&container, names, sizes, count, CONTAINER_CHUNK_DEFAULT) != e_success)
+        {
+            cprintf("✖️\n\n🎯 STATUS: FAILED — File names must be unique and at most %d characters.\n",
+                    CONTAINER_NAME_MAX);
+            ret = e_failure;
+        }
+        else
+        {
+            ret = stego_parse_bmp(cover.data, cover.size, cover.size, &view, &need);
+            if (ret == e_success)
+                ret = stego_plan(&view, "", container.total, &opts, &encInfo->stego);
+            if (ret != e_success)
+                cprintf("✖️\n\n🎯 STATUS: FAILED — %s\n", stego_strerror(ret));
+            else
+                cprintf("✔️  (%" PRId64 " bytes in %" PRId64 " chunk(s)%s)\n", container.total,
+                        container.chunk_count, encInfo->passphrase ? ", ChaCha20 key derived" : "");
+        }
+        if (ret != e_success) unmap_file(&cover);
+    }
+
+    /* Step 3: Output image, sharing the cover's blocks when the filesystem can reflink */
+    if (ret == e_success)
+    {
+        cprintf("   3️⃣  Creating output image ............. ");
+        out_fd = open(encInfo->stego_image_fname, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out_fd < 0)
+        {
+            cprintf("✖️\n\n🎯 STATUS: FAILED — Cannot create output image: %s\n", encInfo->stego_image_fname);
+            unmap_file(&cover);
+            ret = e_failure;
+        }
+        else
+        {
+            cloned = (clone_file(cover.fd, out_fd) == e_success);
+            cprintf("✔️  (%s)\n", cloned ? "reflink" : "header + tail copied");
+        }
+    }
+
+    /* Step 4: Chunks in parallel, then header fields, table and index (the index needs their CRCs) */
+    if (ret == e_success)
+    {
+        const StegoInfo *layout = &encInfo->stego;
+        unsigned char fields[STEGO_HEADER_MAX];
+        unsigned char *meta = malloc(container.data_start);
+        Progress progress;
+        EmbedChunkCtx ctx = { layout, &container, cover.data, maps, out_fd, &progress };
+
+        cprintf("   4️⃣  Embedding chunks and index ........ ⏳\n\n");
+        cprintf("⚙️  Encoding Secret Data...\n");
+        progress_start(&progress, encInfo->progress, "encode", container.total - container.data_start);
+        ret = meta ? parallel_for(encInfo->threads > 1 ? encInfo->threads : 1, container.chunk_count, 1,
+                                  embed_chunks, &ctx)
+                   : e_failure;
+        progress_finish(&progress);
+
+        if (ret == e_success)
+        {
+            container_write_meta(&container, meta);
+            stego_embed_header(layout, cover.data + layout->header_offset, fields);
+            if (write_all_at(out_fd, fields, layout->data_offset - layout->header_offset,
+                             layout->header_offset) != e_success ||
+                embed_bytes(layout, 0, meta, container.data_start, cover.data, out_fd, NULL) != e_success)
+                ret = e_failure;
+        }
+        if (ret == e_success && !cloned &&
+            (write_all_at(out_fd, cover.data, layout->header_offset, 0) != e_success ||
+             copy_file_tail(cover.fd, out_fd, layout->end_offset, cover.size - layout->end_offset) != e_success))
+            ret = e_failure;
+        free(meta);
+
+        if (close(out_fd) != 0) ret = e_failure;
+        unmap_file(&cover);
+        if (ret != e_success)
+            cprintf("\n🎯 STATUS: FAILED — Error while encoding the container.\n");
+        else
+            cprintf(GREEN "✔ Encoding Completed Successfully!" RESET "\n");
+    }
+
+    for (int i = 0; i < mapped; i++) unmap_file(&maps[i]);
+    container_free(&container);
+    free(maps);
+    free(names);
+    free(sizes);
+    if (ret != e_success)
+    {
+        cprintf("───────────────────────────────────────────────\n");
+        return e_failure;
+    }
+
+    cprintf("\n🎯 STATUS: SUCCESS — %d file(s) hidden safely!\n", count);
+    cprintf("📌 Output Saved: %s\n", encInfo->stego_image_fname);
+    cprintf("───────────────────────────────────────────────\n");
+    return e_success;
+}
+
+/* ===================== EXTRACT ONE CHUNK PER TASK ===================== */
+typedef struct
+{
+    const StegoInfo *stego;          // layout read from the hidden header
+    const Container *container;
+    const int64_t *order;            // chunk indexes to extract
+    const int *fds;                  // output file of each container file (-1: not wanted)
+    int image_fd;                    // encoded image, read with pread
+    int resume;                      // keep chunks already on disk with the right CRC
+    Progress *progress;              // shared byte counter
+    atomic_int reused;               // chunks kept from an earlier run
+    _Atomic int64_t bad_chunk;       // first chunk that failed its CRC (-1: none)
+} ExtractChunkCtx;
+
+static Status extract_chunks(void *arg, int64_t begin, int64_t end)
+{
+    ExtractChunkCtx *ctx = arg;
+    unsigned char *data = malloc(ctx->container->chunk_size);
+    Status ret = data ? e_success : e_failure;
+
+    for (int64_t i = begin; i < end && ret == e_success; i++)
+    {
+        int64_t index = ctx->order[i];
+        const ContainerChunk *ch = &ctx->container->chunks[index];
+        const ContainerFile *file = &ctx->container->files[ch->file];
+        int fd = ctx->fds[ch->file];
+        off_t at = ch->offset - ctx->container->data_start - file->offset;
+
+        /* --resume: a chunk already written with the right checksum stays */
+        if (ctx->resume && read_all_at(fd, data, ch->length, at) == e_success &&
+            crc32c(0, data, ch->length) == ch->crc)
+        {
+            atomic_fetch_add(&ctx->reused, 1);
+        }
+        else
+        {
+            ret = extract_bytes(ctx->stego, ch->offset, ch->length, ctx->image_fd, data);
+            if (ret == e_bad_crc || (ret == e_success && crc32c(0, data, ch->length) != ch->crc))
+            {
+                int64_t none = -1;
+                atomic_compare_exchange_strong(&ctx->bad_chunk, &none, index);
+                ret = e_bad_crc;
+            }
+            if (ret == e_success) ret = write_all_at(fd, data, ch->length, at);
+        }
+        progress_add(ctx->progress, ch->length);
+    }
+    free(data);
+    return ret;
+}
+
+/* ===================== READ TABLE AND INDEX ===================== */
+static Status read_container(const StegoInfo *stego, int image_fd, Container *c)
+{
+    unsigned char header[CONTAINER_HEADER_SIZE];
+
+    Status ret = extract_bytes(stego, 0, CONTAINER_HEADER_SIZE, image_fd, header);
+    if (ret != e_success) return ret == e_bad_crc ? e_bad_header : e_bad_image;
+    ret = container_read_header(c, header, stego->size);
+    if (ret != e_success) return ret;
+
+    unsigned char *meta = malloc(c->data_start);
+    if (!meta) return e_failure;
+    ret = extract_bytes(stego, 0, c->data_start, image_fd, meta);
+    if (ret != e_success) ret = (ret == e_bad_crc) ? e_bad_header : e_bad_image;
+    if (ret == e_success) ret = container_read_meta(c, meta, stego->size);
+    free(meta);
+    return ret;
+}
+
+/* ===================== EXTRACT A CONTAINER ===================== */
+Status decode_container(DecodeInfo *decInfo)
+{
+    Container container = { 0 };
+    const char *dir = decInfo->secret_fname;
+
+    cprintf("   3️⃣  Reading container index ........... ");
+    if (!strcmp(decInfo->out_image_fname, STREAM_NAME) || !strcmp(dir, STREAM_NAME))
+    {
+        cprintf("✖️\n\n🎯 STATUS: FAILED — Containers need real files, not stdin/stdout.\n");
+        cprintf("───────────────────────────────────────────────\n");
+        return e_failure;
+    }
+    int image_fd = fileno(decInfo->fptr_out_image);
+    Status ret = read_container(&decInfo->stego, image_fd, &container);
+    if (ret != e_success)
+    {
+        cprintf("✖️\n\n🎯 STATUS: FAILED — Container index: %s.\n", stego_strerror(ret));
+        cprintf("───────────────────────────────────────────────\n");
+        container_free(&container);
+        return e_failure;
+    }
+    cprintf("✔️  (%d file(s), %" PRId64 " chunk(s) of %u bytes)\n", container.file_count,
+            container.chunk_count, container.chunk_size);
+
+    /* Step 4: Pick the files and open their outputs inside the directory */
+    int wanted = decInfo->only_file ? container_find(&container, decInfo->only_file) : -1;
+    if (decInfo->only_file && wanted < 0)
+    {
+        cprintf("\n🎯 STATUS: FAILED — No file named %s in the container.\n", decInfo->only_file);
+        cprintf("───────────────────────────────────────────────\n");
+        container_free(&container);
+        return e_failure;
+    }
+
+    cprintf("   4️⃣  Creating output files in %s/ ... ", dir);
+    int *fds = malloc(container.file_count * sizeof(*fds));
+    int64_t *order = malloc((container.chunk_count ? container.chunk_count : 1) * sizeof(*order));
+    int64_t chunks = 0, bytes = 0;
+    ret = (fds && order && (mkdir(dir, 0755) == 0 || errno == EEXIST)) ? e_success : e_failure;
+    for (int f = 0; fds && f < container.file_count; f++) fds[f] = -1;
+    for (int f = 0; ret == e_success && f < container.file_count; f++)
+    {
+        const ContainerFile *file = &container.files[f];
+        if (wanted >= 0 && f != wanted) continue;
+
+        size_t len = strlen(dir) + strlen(file->name) + 2;
+        char *path = malloc(len);
+        if (path)
+        {
+            snprintf(path, len, "%s/%s", dir, file->name);
+            fds[f] = open(path, O_RDWR | O_CREAT | (decInfo->resume ? 0 : O_TRUNC), 0644);
+        }
+        if (!path || fds[f] < 0)
+        {
+            cprintf("✖️ Cannot create %s\n", path ? path : file->name);
+            ret = e_failure;
+        }
+        free(path);
+
+        for (int64_t i = 0; i < file->chunks; i++) order[chunks++] = file->first_chunk + i;
+        bytes += file->size;
+    }
+    if (ret == e_success) cprintf("✔️\n");
+
+    /* Step 5: Every chunk on its own: pread, extract, check, pwrite */
+    if (ret == e_success)
+    {
+        Progress progress;
+        ExtractChunkCtx ctx = { .stego = &decInfo->stego, .container = &container, .order = order,
+                                .fds = fds, .image_fd = image_fd, .resume = decInfo->resume,
+                                .progress = &progress };
+        atomic_init(&ctx.reused, 0);
+        atomic_init(&ctx.bad_chunk, -1);
+
+        cprintf("   5️⃣  Extracting %" PRId64 " chunk(s) ........ ⏳\n", chunks);
+        cprintf("\n⚙️  Extracting Secret Data...\n");
+        progress_start(&progress, decInfo->progress, "decode", bytes);
+        ret = parallel_for(decInfo->threads > 1 ? decInfo->threads : 1, chunks, 1, extract_chunks, &ctx);
+        progress_finish(&progress);
+
+        int64_t bad = atomic_load(&ctx.bad_chunk);
+        if (bad >= 0)
+            cprintf("[ERROR] Chunk %" PRId64 " of %s failed its CRC32C or ECC check.\n", bad,
+                    container.files[container.chunks[bad].file].name);
+        else if (ret != e_success)
+            cprintf("[ERROR] Unexpected EOF while reading encoded data.\n");
+        else
+            cprintf(GREEN "✔ Secret Data Extracted Successfully!" RESET " (%d chunk(s) kept from an earlier run)\n",
+                    atomic_load(&ctx.reused));
+    }
+
+    /* files that were longer from an earlier run are cut to size */
+    for (int f = 0; fds && f < container.file_count; f++)
+    {
+        if (fds[f] < 0) continue;
+        if (ret == e_success && ftruncate(fds[f], container.files[f].size) != 0) ret = e_failure;
+        if (close(fds[f]) != 0) ret = e_failure;
+    }
+
+    if (ret == e_success)
+    {
+        cprintf("\n🎯 STATUS: SUCCESS — Secret restored!\n");
+        for (int f = 0; f < container.file_count; f++)
+            if (wanted < 0 || f == wanted)
+                cprintf("📌 Extracted File: %s/%s (%" PRId64 " bytes)\n", dir, container.files[f].name,
+                        container.files[f].size);
+    }
+    else
+    {
+        cprintf("\n🎯 STATUS: FAILED — Container data is corrupt or incomplete%s.\n",
+                decInfo->resume ? "" : " (run again with --resume to keep the good chunks)");
+    }
+    cprintf("───────────────────────────────────────────────\n\n");
+
+    free(fds);
+    free(order);
+    container_free(&container);
+    return ret == e_success ? e_success : e_failure;
+}
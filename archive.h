@@ -0,0 +1,29 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include "types.h"
+#include "encode.h"
+#include "decode.h"
+
+/*----------------------------------------------------------
+    Multi-file containers (format v2, container.h) on the CLI
+
+    -c hides several files in one cover; decoding an image that
+    holds a container writes every file (or one, with --file)
+    into a directory. Chunks are fetched with pread on -j threads
+    and checked against their CRC32C. With --resume a chunk that
+    is already on disk with the right checksum is not extracted
+    again, so an interrupted run picks up where it stopped.
+----------------------------------------------------------*/
+
+/* Hide files[0..count) in encInfo->src_image_fname, writing
+   encInfo->stego_image_fname (depth, passphrase, threads and
+   progress are taken from encInfo as well) */
+Status do_container_encoding(EncodeInfo *encInfo, char *files[], int count);
+
+/* Extract the container of an image whose header decode_steps has read
+   (decInfo->stego has STEGO_FLAG_CONTAINER); secret_fname is the
+   output directory */
+Status decode_container(DecodeInfo *decInfo);
+
+#endif // ARCHIVE_H
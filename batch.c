@@ -0,0 +1,505 @@
+#define _XOPEN_SOURCE 700   // getline, strtok_r
+#define _DEFAULT_SOURCE      // MAP_ANONYMOUS
+#define _FILE_OFFSET_BITS 64 // same off_t as fileio.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "batch.h"
+#include "console.h"
+#include "pool.h"
+#include "stream.h"
+#include "aio.h"
+
+/* ===================== ONE MANIFEST ROW ===================== */
+typedef struct
+{
+    int line;                            // manifest line number, for reports
+    char *text;                          // row as written, for reports
+    char *fields;                        // tokenized copy the args point into
+    char *args[BATCH_MAX_FIELDS + 4];    // argv-style: program, operation, files, NULLs
+    OperationType op;
+    EncodeInfo enc;
+    DecodeInfo dec;
+    Status status;
+} BatchJob;
+
+typedef struct
+{
+    BatchJob *jobs;
+    atomic_int failed;
+    int quiet;                  // --quiet: no per-job status lines either
+} BatchRun;
+
+/* ===================== TURN ONE ROW INTO A VALIDATED JOB ===================== */
+static Status parse_row(BatchJob *job, const EncodeInfo *enc_defaults,
+                        const DecodeInfo *dec_defaults)
+{
+    char *save = NULL;
+    int n = 1;
+
+    memset(job->args, 0, sizeof(job->args));
+    job->args[0] = "stego";
+    for (char *tok = strtok_r(job->fields, " \t\r\n", &save); tok;
+         tok = strtok_r(NULL, " \t\r\n", &save))
+    {
+        if (n > BATCH_MAX_FIELDS)
+        {
+            cprintf("[ERROR] Too many fields\n");
+            return e_failure;
+        }
+        if (!strcmp(tok, STREAM_NAME))
+        {
+            cprintf("[ERROR] stdin/stdout (-) cannot be used inside a batch\n");
+            return e_failure;
+        }
+        job->args[n++] = tok;
+    }
+
+    if (n < 3)
+    {
+        cprintf("[ERROR] Missing arguments.\n");
+        return e_failure;
+    }
+
+    if (!strcmp(job->args[1], "-e"))
+    {
+        job->op = e_encode;
+        job->enc = *enc_defaults;
+        return read_and_validate_encode_args(job->args, &job->enc);
+    }
+    if (!strcmp(job->args[1], "-d"))
+    {
+        job->op = e_decode;
+        job->dec = *dec_defaults;
+        return read_and_validate_decode_args(job->args, &job->dec);
+    }
+
+    cprintf("[ERROR] Unsupported operation: %s (use -e or -d)\n", job->args[1]);
+    return e_failure;
+}
+
+/* ===================== READ THE WHOLE MANIFEST ===================== */
+static int read_manifest(FILE *fp, BatchJob **out)
+{
+    BatchJob *jobs = NULL;
+    int count = 0, cap = 0, line_no = 0;
+    char *line = NULL;
+    size_t line_cap = 0;
+    ssize_t len;
+
+    while ((len = getline(&line, &line_cap, fp)) >= 0)
+    {
+        line_no++;
+
+        char *start = line + strspn(line, " \t\r\n");
+        if (*start == '\0' || *start == '#') continue;    // blank or comment
+        start[strcspn(start, "\r\n")] = '\0';
+
+        if (count == cap)
+        {
+            cap = cap ? cap * 2 : 64;
+            BatchJob *grown = realloc(jobs, cap * sizeof(*jobs));
+            if (!grown) break;
+            jobs = grown;
+        }
+
+        BatchJob *job = &jobs[count++];
+        memset(job, 0, sizeof(*job));
+        job->line = line_no;
+        job->text = strdup(start);
+        job->fields = strdup(start);
+    }
+
+    free(line);
+    *out = jobs;
+    return count;
+}
+
+/* ===================== RUN ONE JOB ON A POOL THREAD ===================== */
+static void report_job(BatchRun *run, BatchJob *job)
+{
+    if (job->status != e_success) atomic_fetch_add(&run->failed, 1);
+    if (!run->quiet)
+        printf("[%s] line %d: %s\n", job->status == e_success ? " OK " : "FAIL",
+               job->line, job->text);
+}
+
+static void run_job(void *ctx, int index)
+{
+    BatchRun *run = ctx;
+    BatchJob *job = &run->jobs[index];
+
+    console_quiet = 1;           // this thread's step output would interleave with others
+    if (job->op == e_encode)
+        job->status = do_encoding(&job->enc);
+    else
+        job->status = do_decoding(&job->dec);
+    report_job(run, job);
+}
+
+/* ===================== BATCHED I/O (--aio) ===================== */
+/* Jobs are taken in waves that fit one arena: all their input files are
+   read at once, the jobs run in memory on the pool, then all their outputs
+   are written while the next wave is read into the other arena. */
+typedef struct
+{
+    BatchJob *job;
+    int wave;                            // arena it was read into (0 / 1)
+    int in_fd[2];                        // cover or image; secret (encode only)
+    int64_t in_len[2];
+    unsigned char *in[2];                // where the inputs were read to
+    unsigned char *own;                  // inputs too big for an arena: own allocation
+    unsigned char *out;                  // decode: the secret
+    int64_t out_len;
+    int out_fd;
+    AioOp *ops;                          // this phase's transfers
+    int pending;                         // transfers not completed yet
+    int writing;                         // ops are the output writes
+    int opened;
+} AioJob;
+
+typedef struct
+{
+    BatchRun *run;
+    AioRing ring;
+    AioJob *jobs;
+    unsigned char *arena[2];
+    int pending[2];                      // transfers in flight per arena
+    int first, last;                     // wave being run on the pool
+} AioBatch;
+
+static void close_inputs(AioJob *j)
+{
+    for (int k = 0; k < 2; k++)
+    {
+        if (j->in_fd[k] >= 0) close(j->in_fd[k]);
+        j->in_fd[k] = -1;
+    }
+}
+
+/* Done with the job, whichever way it ended */
+static void finish_aio_job(AioBatch *b, AioJob *j)
+{
+    close_inputs(j);
+    if (j->out_fd >= 0 && close(j->out_fd) != 0) j->job->status = e_failure;
+    j->out_fd = -1;
+    free(j->ops);
+    free(j->own);
+    free(j->out);
+    j->ops = NULL;
+    j->own = j->out = NULL;
+    report_job(b->run, j->job);
+}
+
+static Status open_aio_inputs(AioJob *j)
+{
+    BatchJob *job = j->job;
+    const char *names[2] = { job->op == e_encode ? job->enc.src_image_fname : job->dec.out_image_fname,
+                             job->op == e_encode ? job->enc.secret_fname : NULL };
+    struct stat st;
+
+    j->opened = 1;
+    for (int k = 0; k < 2 && names[k]; k++)
+    {
+        j->in_fd[k] = open(names[k], O_RDONLY | O_CLOEXEC);
+        if (j->in_fd[k] < 0 || fstat(j->in_fd[k], &st) != 0 || !S_ISREG(st.st_mode)) return e_failure;
+        j->in_len[k] = st.st_size;
+    }
+    return e_success;
+}
+
+/* Split [buf, buf + len) at off into AIO_CHUNK transfers; returns the next free op */
+static AioOp *queue_chunks(AioBatch *b, AioJob *j, AioOp *op, int fd, int write,
+                           unsigned char *buf, int64_t len)
+{
+    for (int64_t pos = 0; pos < len; pos += AIO_CHUNK, op++)
+    {
+        op->fd = fd;
+        op->write = write;
+        op->buf = buf + pos;
+        op->len = (len - pos > AIO_CHUNK) ? AIO_CHUNK : (size_t)(len - pos);
+        op->off = pos;
+        op->owner = j;
+        j->pending++;
+        b->pending[j->wave]++;
+        aio_queue(&b->ring, op);
+    }
+    return op;
+}
+
+static int64_t chunks(int64_t len)
+{
+    return (len + AIO_CHUNK - 1) / AIO_CHUNK;
+}
+
+static void on_complete(AioBatch *b, AioOp *op)
+{
+    AioJob *j = op->owner;
+    if (op->res != (int64_t)op->len) j->job->status = e_failure;    // error or short file
+    b->pending[j->wave]--;
+    if (--j->pending == 0 && j->writing) finish_aio_job(b, j);
+}
+
+/* Collect completions (of both arenas) until nothing is in flight in arena w */
+static void drain_wave(AioBatch *b, int w)
+{
+    while (b->pending[w] > 0)
+    {
+        AioOp *op = aio_next(&b->ring);
+        if (!op)
+        {
+            /* the ring broke: whatever is still out will not come back */
+            for (AioJob *j = b->jobs; j < b->jobs + b->last; j++)
+            {
+                if (j->pending == 0) continue;
+                b->pending[j->wave] -= j->pending;
+                j->pending = 0;
+                j->job->status = e_failure;
+                if (j->writing) finish_aio_job(b, j);
+            }
+            return;
+        }
+        on_complete(b, op);
+    }
+}
+
+/* Run one job of the wave on a pool thread: the inputs are in memory */
+static void run_aio_job(void *ctx, int index)
+{
+    AioBatch *b = ctx;
+    AioJob *j = &b->jobs[b->first + index];
+    BatchJob *job = j->job;
+
+    console_quiet = 1;
+    if (job->status != e_success) return;
+    close_inputs(j);
+
+    if (job->op == e_encode)
+    {
+        StegoOptions opts = { .depth = job->enc.depth };
+        if (job->enc.compress) opts.flags |= STEGO_FLAG_LZ;
+        if (job->enc.crc) opts.flags |= STEGO_FLAG_CRC;
+        if (job->enc.scatter) opts.flags |= STEGO_FLAG_SCATTER;
+        if (job->enc.ecc) opts.flags |= STEGO_FLAG_RS;
+        opts.ecc = job->enc.ecc;
+        if (job->enc.passphrase)
+        {
+            opts.flags |= STEGO_FLAG_CHACHA;
+            opts.passphrase = job->enc.passphrase;
+        }
+        /* in place: the cover buffer becomes the stego image */
+        job->status = stego_encode(j->in[0], j->in[0], j->in_len[0], j->in[1], j->in_len[1],
+                                   job->enc.extn_secret_file, &opts);
+        j->out = NULL;
+        j->out_len = j->in_len[0];
+        if (job->status == e_success)
+            j->out_fd = open(job->enc.stego_image_fname, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    else
+    {
+        StegoInfo info;
+        job->status = stego_probe(j->in[0], j->in_len[0], &info);
+        if (job->status == e_success && (info.flags & (STEGO_FLAG_CONTAINER | STEGO_FLAG_SEGMENT)))
+        {
+            job->status = do_decoding(&job->dec);    // many files: the regular decoder writes those
+            j->out_len = -1;
+            return;
+        }
+        if (job->status == e_success && !(j->out = malloc(info.original_size ? info.original_size : 1)))
+            job->status = e_failure;
+        if (job->status == e_success)
+            job->status = stego_decode(j->in[0], j->in_len[0], j->out, info.original_size,
+                                       job->dec.passphrase, &info);
+        j->out_len = info.original_size;
+        if (job->status == e_success)
+        {
+            char name[4096];
+            snprintf(name, sizeof(name), "%s%s", job->dec.secret_fname, info.extn);
+            j->out_fd = open(name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        }
+    }
+    if (job->status == e_success && j->out_fd < 0) job->status = e_failure;
+}
+
+static Status run_batch_aio(BatchRun *run, int count, int workers, AioMode mode)
+{
+    AioBatch b = { .run = run };
+    size_t arena_len[2] = { BATCH_AIO_ARENA, BATCH_AIO_ARENA };
+
+    b.jobs = calloc(count ? count : 1, sizeof(*b.jobs));
+    for (int w = 0; w < 2; w++)
+    {
+        void *p = mmap(NULL, BATCH_AIO_ARENA, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        b.arena[w] = (p == MAP_FAILED) ? NULL : p;
+    }
+    if (!b.jobs || !b.arena[0] || !b.arena[1])
+    {
+        cprintf("[ERROR] Out of memory for batched I/O\n");
+        for (int w = 0; w < 2; w++) if (b.arena[w]) munmap(b.arena[w], BATCH_AIO_ARENA);
+        free(b.jobs);
+        return e_failure;
+    }
+    aio_init(&b.ring, mode);
+    aio_register_buffers(&b.ring, b.arena, arena_len, 2);
+    cprintf("[INFO] Batched I/O: %s, %d request(s) deep, 2 x %d MB buffers%s\n", aio_backend_name(&b.ring),
+            AIO_DEPTH, (int)(BATCH_AIO_ARENA >> 20), b.ring.nbufs ? " (registered)" : "");
+    if (!console_quiet) fflush(stdout);
+
+    for (int i = 0; i < count; i++)
+    {
+        b.jobs[i].job = &run->jobs[i];
+        b.jobs[i].in_fd[0] = b.jobs[i].in_fd[1] = b.jobs[i].out_fd = -1;
+    }
+
+    for (int next = 0, w = 0; next < count; w ^= 1)
+    {
+        /* 1. the arena is free once the writes from two waves ago are done */
+        drain_wave(&b, w);
+        b.first = next;
+
+        /* 2. take jobs until the arena is full; one too big for it goes alone in its own buffer */
+        int64_t used = 0;
+        while (next < count)
+        {
+            AioJob *j = &b.jobs[next];
+            if (!j->opened && open_aio_inputs(j) != e_success)
+            {
+                j->job->status = e_failure;
+                j->wave = w;
+                next++;
+                continue;
+            }
+            int64_t need = j->in_len[0] + j->in_len[1];
+            if (need > BATCH_AIO_ARENA && next == b.first)
+            {
+                j->own = malloc(need ? need : 1);
+                if (!j->own) j->job->status = e_failure;
+                j->in[0] = j->own;
+            }
+            else if (used + need > BATCH_AIO_ARENA)
+                break;
+            else
+            {
+                j->in[0] = b.arena[w] + used;
+                used += need;
+            }
+            j->in[1] = j->in[0] ? j->in[0] + j->in_len[0] : NULL;
+            j->wave = w;
+            next++;
+            if (j->own) break;
+        }
+        b.last = next;
+
+        /* 3. read every input of the wave, then run the jobs */
+        for (AioJob *j = b.jobs + b.first; j < b.jobs + b.last; j++)
+        {
+            if (j->job->status != e_success) continue;
+            AioOp *op = j->ops = calloc(chunks(j->in_len[0]) + chunks(j->in_len[1]) + 1, sizeof(AioOp));
+            if (!op)
+            {
+                j->job->status = e_failure;
+                continue;
+            }
+            op = queue_chunks(&b, j, op, j->in_fd[0], 0, j->in[0], j->in_len[0]);
+            if (j->in_fd[1] >= 0) queue_chunks(&b, j, op, j->in_fd[1], 0, j->in[1], j->in_len[1]);
+        }
+        drain_wave(&b, w);
+        run_tasks(workers, b.last - b.first, run_aio_job, &b);
+        console_quiet = run->quiet;      // the calling thread is one of the workers
+
+        /* 4. write the outputs; the next wave is read while they drain */
+        for (AioJob *j = b.jobs + b.first; j < b.jobs + b.last; j++)
+        {
+            free(j->ops);
+            j->ops = NULL;
+            if (j->job->status != e_success || j->out_len <= 0)
+            {
+                finish_aio_job(&b, j);   // failed, empty, or written by do_decoding
+                continue;
+            }
+            unsigned char *out = j->out ? j->out : j->in[0];
+            j->writing = 1;
+            if (!(j->ops = calloc(chunks(j->out_len), sizeof(AioOp))))
+            {
+                j->job->status = e_failure;
+                finish_aio_job(&b, j);
+                continue;
+            }
+            queue_chunks(&b, j, j->ops, j->out_fd, 1, out, j->out_len);
+        }
+    }
+    drain_wave(&b, 0);
+    drain_wave(&b, 1);
+
+    aio_destroy(&b.ring);
+    for (int w = 0; w < 2; w++) munmap(b.arena[w], BATCH_AIO_ARENA);
+    free(b.jobs);
+    return e_success;
+}
+
+/* ===================== RUN A MANIFEST ===================== */
+Status run_batch(const char *manifest, int workers, AioMode aio,
+                 const EncodeInfo *enc_defaults, const DecodeInfo *dec_defaults)
+{
+    FILE *fp = !strcmp(manifest, STREAM_NAME) ? stdin : fopen(manifest, "r");
+    if (!fp)
+    {
+        cprintf("[ERROR] Cannot open manifest: %s\n", manifest);
+        return e_failure;
+    }
+
+    BatchJob *jobs;
+    int count = read_manifest(fp, &jobs);
+    if (fp != stdin) fclose(fp);
+
+    /* Validate every row before starting anything; bad rows are reported and skipped */
+    BatchJob *valid = malloc((count ? count : 1) * sizeof(*valid));
+    int valid_count = 0, invalid = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (jobs[i].fields && parse_row(&jobs[i], enc_defaults, dec_defaults) == e_success)
+        {
+            valid[valid_count++] = jobs[i];
+        }
+        else
+        {
+            cprintf("[FAIL] line %d: %s (invalid row)\n", jobs[i].line, jobs[i].text);
+            invalid++;
+        }
+    }
+
+    if (workers < 1) workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    cprintf("[INFO] Batch: %d job(s) on %d worker(s)\n", valid_count, workers);
+    if (!console_quiet) fflush(stdout);
+
+    BatchRun run = { .jobs = valid, .quiet = console_quiet };
+    atomic_init(&run.failed, 0);
+    if (aio != e_aio_off && run_batch_aio(&run, valid_count, workers, aio) == e_success)
+    {
+        /* every job was run and reported */
+    }
+    else
+    {
+        run_tasks(workers, valid_count, run_job, &run);
+        console_quiet = run.quiet;   // the calling thread is one of the workers
+    }
+
+    int failed = atomic_load(&run.failed) + invalid;
+    cprintf("[INFO] Batch done: %d job(s), %d succeeded, %d failed\n",
+           count, count - failed, failed);
+
+    for (int i = 0; i < count; i++)
+    {
+        free(jobs[i].text);
+        free(jobs[i].fields);
+    }
+    free(valid);
+    free(jobs);
+
+    return failed ? e_failure : e_success;
+}
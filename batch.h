@@ -0,0 +1,29 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+#include "types.h"
+#include "encode.h"
+#include "decode.h"
+#include "aio.h"        // AioMode
+
+/* Longest manifest row we accept: operation + 3 file names */
+#define BATCH_MAX_FIELDS 4
+
+/* --aio: input bytes read per wave of jobs (two such buffers) */
+#define BATCH_AIO_ARENA (64LL << 20)
+
+/* Run every job listed in a manifest (file name or "-" for stdin).
+   Each row looks like the single job command line without the program:
+       -e <source.bmp> <secret.txt> [output.bmp]
+       -d <encoded.bmp> [output_basename]
+   Blank lines and lines starting with '#' are skipped. Rows are validated
+   up front, then run on `workers` threads; every job gets one status line.
+   The defaults carry the global options (e.g. --mmap) into each job.
+   With aio set, whole files are read and written through aio.h in waves
+   and every job runs in memory; containers still decode file by file.
+   Returns e_success only if every row was valid and every job succeeded. */
+Status run_batch(const char *manifest, int workers, AioMode aio,
+                 const EncodeInfo *enc_defaults, const DecodeInfo *dec_defaults);
+
+#endif // BATCH_H
@@ -0,0 +1,719 @@
+/************************************************************
+ * Steganography Tool - Benchmark
+ *
+ * Generates synthetic 24-bit BMP covers and random payloads,
+ * runs every encode / decode / probe path on them and prints
+ * one JSON object per line:
+ *   {"case":..,"payload":..,"bytes":..,"seconds":..,"mb_s":..,
+ *    "ns_per_byte":..,"peak_rss_kb":..,"impl":..}
+ * Save the output as a baseline and pass it back with
+ * --baseline to flag regressions.
+ ************************************************************/
+
+#define _GNU_SOURCE          // wait4, MUST be first line
+#define _FILE_OFFSET_BITS 64 // same off_t as fileio.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "types.h"
+#include "encode.h"
+#include "decode.h"
+#include "stego.h"
+#include "lsb.h"            // lsb_impl_name
+#include "fileio.h"         // read_all_at / write_all_at
+#include "console.h"        // console_quiet
+
+#define BENCH_WIDTH 4096                  // cover width in pixels (row = 12288 bytes, no padding)
+#define BENCH_CHUNK (1 << 20)             // generator write size
+#define BENCH_LIB_MAX (1L << 30)          // skip in-memory cases above this cover size
+#define BENCH_PROBES 1000                 // probes per timed run
+#define BENCH_MAX_SIZES 16
+#define BENCH_MAX_BASELINE 256
+
+/* ===================== FILES OF ONE PAYLOAD SIZE ===================== */
+typedef struct
+{
+    long payload;                         // secret size in bytes
+    off_t cover_size;                     // generated BMP size in bytes
+    char cover[512];                      // synthetic cover
+    char secret[512];                     // random payload (.txt)
+    char stego[512];                      // cover with payload, made once in setup
+    char out[512];                        // scratch output image
+    char decoded[512];                    // decode base name (".txt" is appended)
+    int threads;                          // -j for the threaded cases
+} BenchFiles;
+
+/* One timed path. Returns bytes processed, or -1 on failure */
+typedef long (*BenchFn)(const BenchFiles *f, double *seconds);
+
+typedef struct
+{
+    const char *name;
+    BenchFn fn;
+} BenchCase;
+
+/* ===================== TIMING ===================== */
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* ===================== SYNTHETIC DATA ===================== */
+static void fill_random(unsigned char *buf, size_t len, uint64_t *state)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        uint64_t x = *state;              // xorshift64: fast, good enough for pixels
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        *state = x;
+        buf[i] = (unsigned char)(x >> 32);
+    }
+}
+
+/* Log-like text (what --compress is for): random picks from a few fields */
+static void fill_text(unsigned char *buf, size_t len, uint64_t *state)
+{
+    static const char *words[] = { "INFO ", "WARN ", "request ", "done ", "user=", "id=",
+                                   "path=/api/v1/items ", "status=200 ", "ms=", "\n" };
+    size_t i = 0;
+    unsigned char pick[2];
+
+    while (i < len)
+    {
+        fill_random(pick, sizeof(pick), state);
+        const char *w = words[pick[0] % (sizeof(words) / sizeof(words[0]))];
+        char num[8];
+        int n = snprintf(num, sizeof(num), "%u ", pick[1]);
+        for (; *w && i < len; w++) buf[i++] = *w;
+        for (int k = 0; k < n && i < len; k++) buf[i++] = num[k];
+    }
+}
+
+static void put_le(unsigned char *p, uint32_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) p[i] = (v >> (i * 8)) & 0xFF;
+}
+
+/* Write len random bytes to fname, optionally after a header */
+static Status write_random_file(const char *fname, const unsigned char *header,
+                                size_t header_len, off_t len, uint64_t seed)
+{
+    unsigned char *chunk = malloc(BENCH_CHUNK);
+    int fd = open(fname, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    off_t pos = 0;
+    Status ret = e_success;
+
+    if (!chunk || fd < 0)
+    {
+        free(chunk);
+        if (fd >= 0) close(fd);
+        return e_failure;
+    }
+
+    if (header_len) ret = write_all_at(fd, header, header_len, 0);
+    pos = header_len;
+    while (ret == e_success && pos < len)
+    {
+        size_t n = (len - pos > BENCH_CHUNK) ? BENCH_CHUNK : (size_t)(len - pos);
+        fill_random(chunk, n, &seed);
+        ret = write_all_at(fd, chunk, n, pos);
+        pos += n;
+    }
+
+    if (close(fd) != 0) ret = e_failure;
+    free(chunk);
+    return ret;
+}
+
+/* 24-bit bottom-up BMP just big enough for payload bytes (plus one spare row) */
+static Status make_cover(BenchFiles *f)
+{
+    unsigned char header[STEGO_BMP_HEADER] = { 'B', 'M' };
+    long row = BENCH_WIDTH * 3;
+    long needed = 8 * (f->payload + STEGO_HEADER_MAX / 8);
+    long height = (needed + row - 1) / row + 1;
+    long pixels = row * height;
+
+    f->cover_size = STEGO_BMP_HEADER + pixels;
+    put_le(header + 2, (uint32_t)f->cover_size, 4);   // bfSize
+    put_le(header + 10, STEGO_BMP_HEADER, 4);         // bfOffBits
+    put_le(header + 14, 40, 4);                       // BITMAPINFOHEADER
+    put_le(header + 18, BENCH_WIDTH, 4);
+    put_le(header + 22, (uint32_t)height, 4);
+    put_le(header + 26, 1, 2);                        // planes
+    put_le(header + 28, 24, 2);                       // bits per pixel
+    put_le(header + 34, (uint32_t)pixels, 4);         // biSizeImage
+
+    return write_random_file(f->cover, header, sizeof(header), f->cover_size, 0x9E3779B97F4A7C15ULL);
+}
+
+/* ===================== CASES: CLI CODE PATHS ===================== */
+static void encode_info(const BenchFiles *f, EncodeInfo *info)
+{
+    memset(info, 0, sizeof(*info));
+    info->src_image_fname = (char *)f->cover;
+    info->secret_fname = (char *)f->secret;
+    info->extn_secret_file = ".txt";
+    info->stego_image_fname = (char *)f->out;
+    info->crc = 1;                                    // the CLI default
+    info->progress = e_progress_none;
+}
+
+static void decode_info(const BenchFiles *f, DecodeInfo *info)
+{
+    memset(info, 0, sizeof(*info));
+    info->out_image_fname = (char *)f->stego;
+    info->secret_fname = (char *)f->decoded;
+    info->progress = e_progress_none;
+}
+
+static long timed_encode(EncodeInfo *info, long payload, double *seconds)
+{
+    double start = now_seconds();
+    Status ret = do_encoding(info);
+    *seconds = now_seconds() - start;
+    return ret == e_success ? payload : -1;
+}
+
+static long timed_decode(DecodeInfo *info, long payload, double *seconds)
+{
+    double start = now_seconds();
+    Status ret = do_decoding(info);
+    *seconds = now_seconds() - start;
+    return ret == e_success ? payload : -1;
+}
+
+static long bench_encode(const BenchFiles *f, double *seconds)
+{
+    EncodeInfo info;
+    encode_info(f, &info);
+    return timed_encode(&info, f->payload, seconds);
+}
+
+static long bench_encode_mmap(const BenchFiles *f, double *seconds)
+{
+    EncodeInfo info;
+    encode_info(f, &info);
+    info.use_mmap = 1;
+    return timed_encode(&info, f->payload, seconds);
+}
+
+static long bench_encode_threads(const BenchFiles *f, double *seconds)
+{
+    EncodeInfo info;
+    encode_info(f, &info);
+    info.threads = f->threads;
+    return timed_encode(&info, f->payload, seconds);
+}
+
+static long bench_decode(const BenchFiles *f, double *seconds)
+{
+    DecodeInfo info;
+    decode_info(f, &info);
+    return timed_decode(&info, f->payload, seconds);
+}
+
+static long bench_decode_threads(const BenchFiles *f, double *seconds)
+{
+    DecodeInfo info;
+    decode_info(f, &info);
+    info.threads = f->threads;
+    return timed_decode(&info, f->payload, seconds);
+}
+
+/* Open + one read + parse both headers + close, BENCH_PROBES times; bytes = bytes read */
+static long bench_probe(const BenchFiles *f, double *seconds)
+{
+    unsigned char region[STEGO_BMP_HEADER_MAX + STEGO_HEADER_MAX];
+    PixelView view;
+    StegoInfo info;
+    size_t need;
+    ssize_t got = 0;
+
+    double start = now_seconds();
+    for (int i = 0; i < BENCH_PROBES; i++)
+    {
+        int fd = open(f->stego, O_RDONLY);
+        if (fd < 0) return -1;
+        got = pread(fd, region, sizeof(region), 0);
+        close(fd);
+        if (got <= 0 ||
+            stego_parse_bmp(region, got, STEGO_LEN_UNKNOWN, &view, &need) != e_success ||
+            view.offset > got ||
+            stego_read_header(&view, region + view.offset, got - view.offset, &info, &need) != e_success)
+            return -1;
+    }
+    *seconds = (now_seconds() - start) / BENCH_PROBES;
+    return got;
+}
+
+/* ===================== CASES: IN-MEMORY LIBRARY ===================== */
+static unsigned char *load_file(const char *fname, off_t *size)
+{
+    struct stat st;
+    int fd = open(fname, O_RDONLY);
+    unsigned char *buf = NULL;
+
+    if (fd >= 0 && fstat(fd, &st) == 0 && (buf = malloc(st.st_size ? st.st_size : 1)) &&
+        read_all_at(fd, buf, st.st_size, 0) == e_success)
+    {
+        *size = st.st_size;
+    }
+    else
+    {
+        free(buf);
+        buf = NULL;
+    }
+    if (fd >= 0) close(fd);
+    return buf;
+}
+
+static long lib_encode_depth(const BenchFiles *f, int depth, double *seconds)
+{
+    off_t cover_len, secret_len;
+    unsigned char *cover = load_file(f->cover, &cover_len);
+    unsigned char *secret = load_file(f->secret, &secret_len);
+    long ret = -1;
+
+    if (cover && secret)
+    {
+        double start = now_seconds();
+        StegoOptions opts = { .depth = depth };
+        if (stego_encode(cover, cover, cover_len, secret, secret_len, ".txt", &opts) == e_success)
+            ret = f->payload;
+        *seconds = now_seconds() - start;
+    }
+    free(cover);
+    free(secret);
+    return ret;
+}
+
+static long bench_lib_encode(const BenchFiles *f, double *seconds)
+{
+    return lib_encode_depth(f, 1, seconds);
+}
+
+static long bench_lib_encode_d2(const BenchFiles *f, double *seconds)
+{
+    return lib_encode_depth(f, 2, seconds);
+}
+
+static long bench_lib_encode_d4(const BenchFiles *f, double *seconds)
+{
+    return lib_encode_depth(f, 4, seconds);
+}
+
+static long bench_lib_decode(const BenchFiles *f, double *seconds)
+{
+    off_t image_len;
+    unsigned char *image = load_file(f->stego, &image_len);
+    unsigned char *out = malloc(f->payload);
+    StegoInfo info;
+    long ret = -1;
+
+    if (image && out)
+    {
+        double start = now_seconds();
+        if (stego_decode(image, image_len, out, f->payload, NULL, &info) == e_success)
+            ret = f->payload;
+        *seconds = now_seconds() - start;
+    }
+    free(image);
+    free(out);
+    return ret;
+}
+
+/* Depth 4 image made in memory first (untimed), then decoded */
+static long bench_lib_decode_d4(const BenchFiles *f, double *seconds)
+{
+    off_t cover_len, secret_len;
+    unsigned char *image = load_file(f->cover, &cover_len);
+    unsigned char *secret = load_file(f->secret, &secret_len);
+    unsigned char *out = malloc(f->payload);
+    StegoInfo info;
+    long ret = -1;
+
+    if (image && secret && out &&
+        stego_encode(image, image, cover_len, secret, secret_len, ".txt",
+                     &(StegoOptions){ .depth = 4 }) == e_success)
+    {
+        double start = now_seconds();
+        Status st = stego_decode(image, cover_len, out, f->payload, NULL, &info);
+        *seconds = now_seconds() - start;
+        if (st == e_success && memcmp(out, secret, f->payload) == 0)
+            ret = f->payload;
+    }
+    free(image);
+    free(secret);
+    free(out);
+    return ret;
+}
+
+/* LZ packed text: encode (packing included) and decode (unpacking included) */
+static long lib_lz(const BenchFiles *f, int decode, double *seconds)
+{
+    off_t cover_len;
+    unsigned char *image = load_file(f->cover, &cover_len);
+    unsigned char *text = malloc(f->payload);
+    unsigned char *out = malloc(f->payload);
+    StegoOptions opts = { .flags = STEGO_FLAG_LZ };
+    StegoInfo info;
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    long ret = -1;
+
+    if (image && text && out)
+    {
+        fill_text(text, f->payload, &seed);
+        double start = now_seconds();
+        Status st = stego_encode(image, image, cover_len, text, f->payload, ".txt", &opts);
+        if (decode)
+        {
+            start = now_seconds();
+            if (st == e_success) st = stego_decode(image, cover_len, out, f->payload, NULL, &info);
+        }
+        *seconds = now_seconds() - start;
+        if (st == e_success && (!decode || memcmp(out, text, f->payload) == 0))
+            ret = f->payload;
+    }
+    free(image);
+    free(text);
+    free(out);
+    return ret;
+}
+
+static long bench_lib_encode_lz(const BenchFiles *f, double *seconds)
+{
+    return lib_lz(f, 0, seconds);
+}
+
+static long bench_lib_decode_lz(const BenchFiles *f, double *seconds)
+{
+    return lib_lz(f, 1, seconds);
+}
+
+/* ChaCha20 fused into embed / extract. The key derivation (PBKDF2, a fixed
+   cost per image) is left out of the time, like the file loads. */
+static long lib_chacha(const BenchFiles *f, int decode, double *seconds)
+{
+    off_t cover_len, secret_len;
+    unsigned char *image = load_file(f->cover, &cover_len);
+    unsigned char *secret = load_file(f->secret, &secret_len);
+    unsigned char *out = malloc(f->payload);
+    StegoOptions opts = { .flags = STEGO_FLAG_CHACHA, .passphrase = "bench" };
+    PixelView view;
+    StegoInfo info, read;
+    size_t need;
+    long ret = -1;
+
+    if (image && secret && out &&
+        stego_parse_bmp(image, cover_len, cover_len, &view, &need) == e_success &&
+        stego_plan(&view, ".txt", secret_len, &opts, &info) == e_success)
+    {
+        double start = now_seconds();
+        stego_embed_header(&info, image + info.header_offset, image + info.header_offset);
+        stego_embed_data(&info, 0, secret, secret_len, image + info.data_offset, image + info.data_offset);
+        int ok = 1;
+        if (decode)
+        {
+            ok = stego_read_header(&view, image + view.offset, cover_len - view.offset, &read,
+                                   &need) == e_success && stego_unlock(&read, opts.passphrase) == e_success;
+            start = now_seconds();
+            if (ok) ok = stego_extract_data(&read, 0, image + read.data_offset, read.size, out) == e_success;
+        }
+        *seconds = now_seconds() - start;
+        if (ok && (!decode || memcmp(out, secret, f->payload) == 0)) ret = f->payload;
+    }
+    free(image);
+    free(secret);
+    free(out);
+    return ret;
+}
+
+static long bench_lib_encode_chacha(const BenchFiles *f, double *seconds)
+{
+    return lib_chacha(f, 0, seconds);
+}
+
+static long bench_lib_decode_chacha(const BenchFiles *f, double *seconds)
+{
+    return lib_chacha(f, 1, seconds);
+}
+
+static const BenchCase cases[] =
+{
+    { "encode",         bench_encode },
+    { "encode_mmap",    bench_encode_mmap },
+    { "encode_threads", bench_encode_threads },
+    { "decode",         bench_decode },
+    { "decode_threads", bench_decode_threads },
+    { "probe",          bench_probe },
+    { "lib_encode",     bench_lib_encode },
+    { "lib_decode",     bench_lib_decode },
+    { "lib_encode_d2",  bench_lib_encode_d2 },
+    { "lib_encode_d4",  bench_lib_encode_d4 },
+    { "lib_decode_d4",  bench_lib_decode_d4 },
+    { "lib_encode_lz",  bench_lib_encode_lz },
+    { "lib_decode_lz",  bench_lib_decode_lz },
+    { "lib_encode_chacha", bench_lib_encode_chacha },
+    { "lib_decode_chacha", bench_lib_decode_chacha },
+};
+
+/* ===================== RUN ONE CASE IN A CHILD (own peak RSS) ===================== */
+static Status run_case(const BenchCase *c, const BenchFiles *f,
+                       double *seconds, long *bytes, long *rss_kb)
+{
+    struct { double seconds; long bytes; } result = { 0, -1 };
+    struct rusage ru;
+    int fds[2], status;
+
+    fflush(stdout);
+    if (pipe(fds) != 0) return e_failure;
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return e_failure;
+    }
+    if (pid == 0)
+    {
+        close(fds[0]);
+        console_quiet = 1;                 // step banners would only cost time
+        result.bytes = c->fn(f, &result.seconds);
+        if (write(fds[1], &result, sizeof(result)) != (ssize_t)sizeof(result)) _exit(2);
+        _exit(result.bytes < 0);
+    }
+
+    close(fds[1]);
+    ssize_t got = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+    if (wait4(pid, &status, 0, &ru) != pid) return e_failure;
+    if (got != (ssize_t)sizeof(result) || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return e_failure;
+
+    *seconds = result.seconds;
+    *bytes = result.bytes;
+    *rss_kb = ru.ru_maxrss;                // Linux reports kilobytes
+    return e_success;
+}
+
+/* ===================== BASELINE ===================== */
+typedef struct
+{
+    char name[32];
+    long payload;
+    double mb_s;
+} BaselineEntry;
+
+static int load_baseline(const char *fname, BaselineEntry *entries, int max)
+{
+    FILE *fp = fopen(fname, "r");
+    char line[512];
+    int count = 0;
+
+    if (!fp) return -1;
+    while (count < max && fgets(line, sizeof(line), fp))
+    {
+        BaselineEntry *e = &entries[count];
+        const char *mb = strstr(line, "\"mb_s\":");
+        if (sscanf(line, "{\"case\":\"%31[^\"]\",\"payload\":%ld", e->name, &e->payload) == 2 &&
+            mb && sscanf(mb + 7, "%lf", &e->mb_s) == 1)
+            count++;
+    }
+    fclose(fp);
+    return count;
+}
+
+static const BaselineEntry *find_baseline(const BaselineEntry *entries, int count,
+                                          const char *name, long payload)
+{
+    for (int i = 0; i < count; i++)
+        if (entries[i].payload == payload && !strcmp(entries[i].name, name))
+            return &entries[i];
+    return NULL;
+}
+
+/* ===================== OPTIONS ===================== */
+static long parse_size(const char *text)
+{
+    char *end;
+    long value = strtol(text, &end, 10);
+
+    if (*end == 'K' || *end == 'k') value <<= 10, end++;
+    else if (*end == 'M' || *end == 'm') value <<= 20, end++;
+    else if (*end == 'G' || *end == 'g') value <<= 30, end++;
+    return (*end == '\0' && value > 0) ? value : -1;
+}
+
+static int parse_sizes(char *list, long *sizes)
+{
+    int count = 0;
+    for (char *tok = strtok(list, ","); tok && count < BENCH_MAX_SIZES; tok = strtok(NULL, ","))
+    {
+        sizes[count] = parse_size(tok);
+        if (sizes[count] < 0) return -1;
+        count++;
+    }
+    return count;
+}
+
+static void usage(void)
+{
+    printf("Usage: ./stego_bench [--sizes 1K,64K,1M,16M,64M] [--reps N] [--dir DIR]\n");
+    printf("                     [--cases encode,decode,...] [-j N]\n");
+    printf("                     [--baseline FILE] [--tolerance PCT]\n");
+    printf("Sizes take K/M/G suffixes (1K .. 1G). Output: one JSON line per case.\n");
+    printf("With --baseline, a case slower than baseline by more than PCT%% (default 10)\n");
+    printf("is reported on stderr and the exit code is 1.\n");
+}
+
+static int case_selected(const char *list, const char *name)
+{
+    if (!list) return 1;
+    size_t len = strlen(name);
+    for (const char *p = strstr(list, name); p; p = strstr(p + 1, name))
+        if ((p == list || p[-1] == ',') && (p[len] == ',' || p[len] == '\0'))
+            return 1;
+    return 0;
+}
+
+/************************************************************
+ * Function: main
+ ************************************************************/
+int main(int argc, char *argv[])
+{
+    char default_sizes[] = "1K,64K,1M,16M,64M";
+    char *size_list = default_sizes;
+    const char *dir = "/tmp", *baseline = NULL, *case_list = NULL;
+    int reps = 3, threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    double tolerance = 10.0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!val) { usage(); return 1; }
+        if (!strcmp(argv[i], "--sizes")) size_list = argv[++i];
+        else if (!strcmp(argv[i], "--reps")) reps = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--dir")) dir = argv[++i];
+        else if (!strcmp(argv[i], "--cases")) case_list = argv[++i];
+        else if (!strcmp(argv[i], "-j")) threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--baseline")) baseline = argv[++i];
+        else if (!strcmp(argv[i], "--tolerance")) tolerance = atof(argv[++i]);
+        else { usage(); return 1; }
+    }
+
+    long sizes[BENCH_MAX_SIZES];
+    int size_count = parse_sizes(size_list, sizes);
+    if (size_count <= 0 || reps < 1 || threads < 1)
+    {
+        usage();
+        return 1;
+    }
+
+    BaselineEntry base[BENCH_MAX_BASELINE];
+    int base_count = 0;
+    if (baseline && (base_count = load_baseline(baseline, base, BENCH_MAX_BASELINE)) < 0)
+    {
+        fprintf(stderr, "[ERROR] Cannot read baseline: %s\n", baseline);
+        return 1;
+    }
+
+    int failed = 0, regressions = 0;
+    console_quiet = 1;                     // setup encodes run in this process
+
+    for (int s = 0; s < size_count; s++)
+    {
+        BenchFiles f;
+        memset(&f, 0, sizeof(f));
+        f.payload = sizes[s];
+        f.threads = threads;
+        int pid = (int)getpid();
+        snprintf(f.cover, sizeof(f.cover), "%s/stego_bench_%d_cover.bmp", dir, pid);
+        snprintf(f.secret, sizeof(f.secret), "%s/stego_bench_%d_secret.txt", dir, pid);
+        snprintf(f.stego, sizeof(f.stego), "%s/stego_bench_%d_stego.bmp", dir, pid);
+        snprintf(f.out, sizeof(f.out), "%s/stego_bench_%d_out.bmp", dir, pid);
+        snprintf(f.decoded, sizeof(f.decoded), "%s/stego_bench_%d_decoded", dir, pid);
+
+        /* setup: cover, payload and one stego image for the decode cases */
+        EncodeInfo setup;
+        encode_info(&f, &setup);
+        setup.stego_image_fname = f.stego;
+        if (make_cover(&f) != e_success ||
+            write_random_file(f.secret, NULL, 0, f.payload, 0xD1B54A32D192ED03ULL + s) != e_success ||
+            do_encoding(&setup) != e_success)
+        {
+            fprintf(stderr, "[ERROR] Cannot create benchmark files for %ld bytes in %s\n",
+                    f.payload, dir);
+            failed++;
+        }
+        else
+        {
+            for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+            {
+                const BenchCase *bc = &cases[c];
+                if (!case_selected(case_list, bc->name)) continue;
+                if (!strncmp(bc->name, "lib_", 4) && f.cover_size > BENCH_LIB_MAX) continue;
+
+                double best = 0, seconds;
+                long bytes = 0, rss_kb, peak_kb = 0;
+                Status ret = e_success;
+
+                for (int r = 0; r < reps && ret == e_success; r++)   // best of reps
+                {
+                    ret = run_case(bc, &f, &seconds, &bytes, &rss_kb);
+                    if (ret == e_success && (r == 0 || seconds < best)) best = seconds;
+                    if (rss_kb > peak_kb) peak_kb = rss_kb;
+                }
+                if (ret != e_success)
+                {
+                    fprintf(stderr, "[ERROR] %s failed for %ld bytes\n", bc->name, f.payload);
+                    failed++;
+                    continue;
+                }
+                if (best <= 0) best = 1e-9;
+
+                double mb_s = bytes / best / 1e6;
+                printf("{\"case\":\"%s\",\"payload\":%ld,\"bytes\":%ld,\"seconds\":%.6f,"
+                       "\"mb_s\":%.2f,\"ns_per_byte\":%.3f,\"peak_rss_kb\":%ld,\"impl\":\"%s\"",
+                       bc->name, f.payload, bytes, best, mb_s, best * 1e9 / bytes, peak_kb,
+                       lsb_impl_name());
+
+                const BaselineEntry *b = find_baseline(base, base_count, bc->name, f.payload);
+                if (b && b->mb_s > 0)
+                {
+                    double change = (mb_s - b->mb_s) * 100.0 / b->mb_s;
+                    printf(",\"baseline_mb_s\":%.2f,\"change_pct\":%.1f", b->mb_s, change);
+                    if (change < -tolerance)
+                    {
+                        fprintf(stderr, "[REGRESSION] %s %ld bytes: %.2f MB/s vs %.2f MB/s (%.1f%%)\n",
+                                bc->name, f.payload, mb_s, b->mb_s, change);
+                        regressions++;
+                    }
+                }
+                printf("}\n");
+            }
+        }
+
+        char decoded[600];
+        snprintf(decoded, sizeof(decoded), "%s.txt", f.decoded);
+        unlink(f.cover);
+        unlink(f.secret);
+        unlink(f.stego);
+        unlink(f.out);
+        unlink(decoded);
+    }
+
+    return (failed || regressions) ? 1 : 0;
+}
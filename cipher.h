@@ -0,0 +1,49 @@
+#ifndef CIPHER_H
+#define CIPHER_H
+
+#include <stddef.h>   // size_t
+#include <stdint.h>   // uint32_t, uint64_t
+#include "types.h"    // Status
+
+/*----------------------------------------------------------
+    Passphrase encryption of the hidden data (part of libstego)
+
+    ChaCha20 (RFC 8439, block counter from 0) with a key derived
+    by PBKDF2-HMAC-SHA256. The keystream of any byte can be made
+    directly, so every block and every thread encrypts its own
+    part of the secret. The keystream kernel (avx2: 8 blocks at a
+    time, sse2: 4, or scalar) is picked once at startup from CPUID.
+    Setting STEGO_CIPHER=<name> in the environment forces one.
+----------------------------------------------------------*/
+
+#define CIPHER_KEY_SIZE 32
+#define CIPHER_NONCE_SIZE 12
+#define CIPHER_SALT_SIZE 16
+#define CIPHER_KDF_ROUNDS 100000              // PBKDF2 iterations, part of the format
+
+/* Most bytes one key and nonce can encrypt (the 32-bit block counter) */
+#define CIPHER_MAX_BYTES ((int64_t)64 << 32)
+
+/* Derive the ChaCha20 key from a passphrase and salt */
+void cipher_derive_key(const char *passphrase, const unsigned char *salt,
+                       unsigned char key[CIPHER_KEY_SIZE]);
+
+/* 32 bits that tell a wrong passphrase from the right one (a hash of the key) */
+uint32_t cipher_key_check(const unsigned char key[CIPHER_KEY_SIZE]);
+
+/* out = in XOR keystream for the n bytes from stream offset pos.
+   in and out may be the same buffer. */
+void cipher_xor(const unsigned char key[CIPHER_KEY_SIZE], const unsigned char nonce[CIPHER_NONCE_SIZE],
+                uint64_t pos, const unsigned char *in, unsigned char *out, size_t n);
+
+/* Fill buf with n bytes from the OS random source (salts and nonces) */
+Status cipher_random(unsigned char *buf, size_t n);
+
+/* Name of the keystream kernel currently in use */
+const char *cipher_impl_name(void);
+
+/* Check SHA-256 and ChaCha20 against known answers and the kernel in use
+   against the scalar one (also run at startup unless built with -DNDEBUG) */
+Status cipher_self_check(void);
+
+#endif // CIPHER_H
@@ -0,0 +1,3 @@
+#include "console.h"
+
+_Thread_local int console_quiet = 0;    // every thread starts out printing
@@ -0,0 +1,13 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdio.h>
+
+/* Step banners, progress bars and error lines of the encode/decode modules
+   go through cprintf. A thread that sets console_quiet prints nothing, which
+   lets batch workers run many jobs at once without mixing their output. */
+extern _Thread_local int console_quiet;
+
+#define cprintf(...) do { if (!console_quiet) printf(__VA_ARGS__); } while (0)
+
+#endif // CONSOLE_H
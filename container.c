@@ -0,0 +1,220 @@
+#include <stdlib.h>
+#include <string.h>
+#include "container.h"
+#include "crc32c.h"
+
+/* ===================== SMALL LITTLE ENDIAN HELPERS ===================== */
+static void put_le(unsigned char *p, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) p[i] = (v >> (i * 8)) & 0xFF;
+}
+
+static uint64_t get_le(const unsigned char *p, int bytes)
+{
+    uint64_t v = 0;
+    for (int i = bytes - 1; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+/* Table entry: offset, size, first chunk, name length, name */
+#define ENTRY_FIXED (8 + 8 + 8 + 2)
+
+/* A name is stored and later used as a file name inside the output
+   directory, so it must not climb out of it */
+static int valid_name(const char *name, size_t len)
+{
+    if (len == 0 || len > CONTAINER_NAME_MAX) return 0;
+    if (memchr(name, '/', len) || memchr(name, '\\', len) || memchr(name, '\0', len)) return 0;
+    return !(len == 1 && name[0] == '.') && !(len == 2 && name[0] == '.' && name[1] == '.');
+}
+
+/* ===================== CHUNKS OF EVERY FILE ===================== */
+/* files[] is set; derive chunk counts, chunks and total. Returns e_failure on overflow. */
+static Status lay_out_chunks(Container *c, int with_chunks)
+{
+    int64_t offset = 0, chunk = 0;
+
+    for (int f = 0; f < c->file_count; f++)
+    {
+        ContainerFile *file = &c->files[f];
+        file->offset = offset;
+        file->first_chunk = chunk;
+        if (file->size < 0 || offset > INT64_MAX / 2 - file->size) return e_failure;
+        file->chunks = (file->size + c->chunk_size - 1) / c->chunk_size;
+        offset += file->size;
+        chunk += file->chunks;
+    }
+    c->chunk_count = chunk;
+    c->data_start = CONTAINER_HEADER_SIZE + (int64_t)c->table_len + 8 * c->chunk_count;
+    c->total = c->data_start + offset;
+    if (!with_chunks) return e_success;
+
+    c->chunks = calloc(c->chunk_count ? c->chunk_count : 1, sizeof(*c->chunks));
+    if (!c->chunks) return e_failure;
+    for (int f = 0; f < c->file_count; f++)
+    {
+        const ContainerFile *file = &c->files[f];
+        for (int64_t i = 0; i < file->chunks; i++)
+        {
+            ContainerChunk *ch = &c->chunks[file->first_chunk + i];
+            int64_t at = i * c->chunk_size;
+            ch->offset = c->data_start + file->offset + at;
+            ch->length = (file->size - at > c->chunk_size) ? c->chunk_size : (uint32_t)(file->size - at);
+            ch->file = f;
+        }
+    }
+    return e_success;
+}
+
+/* ===================== NEW CONTAINER ===================== */
+Status container_plan(Container *c, const char *const names[], const int64_t sizes[],
+                      int count, uint32_t chunk_size)
+{
+    memset(c, 0, sizeof(*c));
+    if (count < 1 || count > CONTAINER_FILES_MAX || chunk_size == 0) return e_failure;
+
+    c->version = CONTAINER_VERSION;
+    c->chunk_size = chunk_size;
+    c->file_count = count;
+    c->files = calloc(count, sizeof(*c->files));
+    if (!c->files) return e_failure;
+
+    int64_t table_len = 0;
+    for (int f = 0; f < count; f++)
+    {
+        size_t len = strlen(names[f]);
+        if (!valid_name(names[f], len) || container_find(c, names[f]) >= 0)
+        {
+            container_free(c);
+            return e_failure;                          // unusable or duplicate name
+        }
+        memcpy(c->files[f].name, names[f], len + 1);
+        c->files[f].size = sizes[f];
+        table_len += ENTRY_FIXED + len;
+    }
+    c->table_len = (uint32_t)table_len;               // at most 65535 * 281 bytes
+
+    if (lay_out_chunks(c, 1) != e_success)
+    {
+        container_free(c);
+        return e_failure;
+    }
+    return e_success;
+}
+
+void container_write_meta(const Container *c, unsigned char *out)
+{
+    unsigned char *p = out + CONTAINER_HEADER_SIZE;
+
+    for (int f = 0; f < c->file_count; f++)
+    {
+        const ContainerFile *file = &c->files[f];
+        size_t len = strlen(file->name);
+        put_le(p, file->offset, 8);
+        put_le(p + 8, file->size, 8);
+        put_le(p + 16, file->first_chunk, 8);
+        put_le(p + 24, len, 2);
+        memcpy(p + ENTRY_FIXED, file->name, len);
+        p += ENTRY_FIXED + len;
+    }
+    for (int64_t i = 0; i < c->chunk_count; i++, p += 8)
+    {
+        put_le(p, c->chunks[i].length, 4);
+        put_le(p + 4, c->chunks[i].crc, 4);
+    }
+
+    memcpy(out, CONTAINER_MAGIC, 4);
+    out[4] = CONTAINER_VERSION;
+    out[5] = 0;
+    put_le(out + 6, c->file_count, 2);
+    put_le(out + 8, c->chunk_size, 4);
+    put_le(out + 12, c->table_len, 4);
+    put_le(out + 16, c->chunk_count, 8);
+    put_le(out + 24, crc32c(0, out + CONTAINER_HEADER_SIZE, c->data_start - CONTAINER_HEADER_SIZE), 4);
+    put_le(out + 28, crc32c(0, out, 28), 4);
+}
+
+/* ===================== READ A CONTAINER ===================== */
+Status container_read_header(Container *c, const unsigned char *header, int64_t available)
+{
+    memset(c, 0, sizeof(*c));
+    if (available < CONTAINER_HEADER_SIZE || memcmp(header, CONTAINER_MAGIC, 4) != 0 ||
+        header[4] != CONTAINER_VERSION || get_le(header + 28, 4) != crc32c(0, header, 28))
+        return e_bad_header;
+
+    c->version = header[4];
+    c->file_count = (int)get_le(header + 6, 2);
+    c->chunk_size = (uint32_t)get_le(header + 8, 4);
+    c->table_len = (uint32_t)get_le(header + 12, 4);
+    uint64_t chunks = get_le(header + 16, 8);
+
+    /* everything it describes has to fit in the hidden data */
+    if (c->file_count == 0 || c->chunk_size == 0 ||
+        available - CONTAINER_HEADER_SIZE < (int64_t)c->table_len ||
+        chunks > (uint64_t)(available - CONTAINER_HEADER_SIZE - c->table_len) / 8)
+        return e_bad_header;
+    c->chunk_count = (int64_t)chunks;
+    c->data_start = CONTAINER_HEADER_SIZE + (int64_t)c->table_len + 8 * c->chunk_count;
+    if (c->data_start > available) return e_bad_header;
+    return e_success;
+}
+
+Status container_read_meta(Container *c, const unsigned char *meta, int64_t available)
+{
+    const unsigned char *p = meta + CONTAINER_HEADER_SIZE;
+    const unsigned char *table_end = p + c->table_len;
+    int64_t chunk_count = c->chunk_count, data_start = c->data_start;
+
+    if (get_le(meta + 24, 4) != crc32c(0, p, c->data_start - CONTAINER_HEADER_SIZE)) return e_bad_crc;
+
+    c->files = calloc(c->file_count, sizeof(*c->files));
+    if (!c->files) return e_failure;
+    for (int f = 0; f < c->file_count; f++)
+    {
+        ContainerFile *file = &c->files[f];
+        if (table_end - p < ENTRY_FIXED) return e_bad_header;
+        size_t len = get_le(p + 24, 2);
+        if ((size_t)(table_end - p - ENTRY_FIXED) < len || !valid_name((const char *)p + ENTRY_FIXED, len))
+            return e_bad_header;
+        memcpy(file->name, p + ENTRY_FIXED, len);
+        file->size = (int64_t)get_le(p + 8, 8);
+        if (file->size < 0) return e_bad_header;
+        p += ENTRY_FIXED + len;
+    }
+    if (p != table_end) return e_bad_header;
+
+    /* recompute the layout and insist the stored one matches it exactly */
+    p = meta + CONTAINER_HEADER_SIZE;
+    if (lay_out_chunks(c, 0) != e_success || c->chunk_count != chunk_count ||
+        c->data_start != data_start || c->total > available)
+        return e_bad_header;
+    if (lay_out_chunks(c, 1) != e_success) return e_failure;
+    for (int f = 0; f < c->file_count; f++)
+    {
+        const ContainerFile *file = &c->files[f];
+        if ((int64_t)get_le(p, 8) != file->offset || (int64_t)get_le(p + 16, 8) != file->first_chunk)
+            return e_bad_header;
+        p += ENTRY_FIXED + strlen(file->name);
+    }
+    for (int64_t i = 0; i < c->chunk_count; i++, p += 8)
+    {
+        if (get_le(p, 4) != c->chunks[i].length) return e_bad_header;
+        c->chunks[i].crc = (uint32_t)get_le(p + 4, 4);
+    }
+    return e_success;
+}
+
+int container_find(const Container *c, const char *name)
+{
+    for (int f = 0; f < c->file_count; f++)
+        if (!strcmp(c->files[f].name, name)) return f;
+    return -1;
+}
+
+void container_free(Container *c)
+{
+    free(c->files);
+    free(c->chunks);
+    c->files = NULL;
+    c->chunks = NULL;
+}
@@ -0,0 +1,92 @@
+#ifndef CONTAINER_H
+#define CONTAINER_H
+
+#include <stddef.h>   // size_t
+#include <stdint.h>   // int64_t, uint32_t
+#include "types.h"    // Status
+
+/*----------------------------------------------------------
+    Container format v2: many files in one secret (part of libstego)
+
+    The container is the hidden data of a "#*" image whose header has
+    STEGO_FLAG_CONTAINER, so depth and encryption work as they do for
+    one file and container byte k still sits at stego_data_pos(info, k).
+    Layout, little endian:
+        header  32 bytes: magic "STGC" | version | 0 | file count (16)
+                | chunk size (32) | table bytes (32) | chunk count (64)
+                | CRC32C of table + index | CRC32C of header bytes 0..27
+        table   per file: offset (64) | size (64) | first chunk (64)
+                | name length (16) | name
+        index   per chunk: length (32) | CRC32C (32)
+        data    the files back to back
+    Each file is cut into chunks of chunk size bytes (the last one may be
+    shorter), so a chunk never spans two files: any chunk can be fetched,
+    checked and written on its own, by any thread, in any order.
+----------------------------------------------------------*/
+
+#define CONTAINER_MAGIC "STGC"
+#define CONTAINER_VERSION 2
+#define CONTAINER_HEADER_SIZE 32
+#define CONTAINER_CHUNK_DEFAULT (256 * 1024)  // bytes per chunk for new containers
+#define CONTAINER_NAME_MAX 255                // longest stored file name
+#define CONTAINER_FILES_MAX 65535
+
+/* One file of the container */
+typedef struct _ContainerFile
+{
+    char name[CONTAINER_NAME_MAX + 1];      // plain name, never a path
+    int64_t offset;                         // first byte, counted from the start of the data
+    int64_t size;                           // bytes
+    int64_t first_chunk;                    // index of its first chunk
+    int64_t chunks;                         // number of chunks
+} ContainerFile;
+
+/* One chunk of the index */
+typedef struct _ContainerChunk
+{
+    int64_t offset;                         // container offset of its first byte
+    uint32_t length;                        // bytes
+    uint32_t crc;                           // CRC32C of those bytes
+    int file;                               // file it belongs to
+} ContainerChunk;
+
+/* A parsed or planned container */
+typedef struct _Container
+{
+    int version;                            // CONTAINER_VERSION
+    uint32_t chunk_size;                    // bytes per full chunk
+    int file_count;
+    int64_t chunk_count;
+    uint32_t table_len;                     // bytes of the file table
+    int64_t data_start;                     // container offset of the data (header + table + index)
+    int64_t total;                          // container bytes in all
+    ContainerFile *files;                   // file_count entries
+    ContainerChunk *chunks;                 // chunk_count entries
+} Container;
+
+/* Lay out count files with the given names and sizes. Chunk CRCs start at
+   zero; fill them in before container_write_meta. */
+Status container_plan(Container *c, const char *const names[], const int64_t sizes[],
+                      int count, uint32_t chunk_size);
+
+/* Header, table and index: the first c->data_start bytes of the container */
+void container_write_meta(const Container *c, unsigned char *out);
+
+/* Parse the CONTAINER_HEADER_SIZE byte header. available is the number of
+   container bytes in the image (StegoInfo.size). Sets everything but the
+   files and chunks; e_bad_header if it is not a valid v2 header. */
+Status container_read_header(Container *c, const unsigned char *header, int64_t available);
+
+/* Parse table and index from the first c->data_start container bytes
+   (after container_read_header, same available). e_bad_crc if they fail
+   their checksum, e_bad_header if they do not describe a consistent
+   layout. Call container_free afterwards whatever it returns. */
+Status container_read_meta(Container *c, const unsigned char *meta, int64_t available);
+
+/* Index of the file with this name, or -1 */
+int container_find(const Container *c, const char *name);
+
+/* Release files and chunks */
+void container_free(Container *c);
+
+#endif // CONTAINER_H
@@ -0,0 +1,129 @@
+#define _DEFAULT_SOURCE      // st_mtim, MUST be first line
+#define _FILE_OFFSET_BITS 64 // same off_t as fileio.c
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/mman.h>        // madvise
+#include "covercache.h"
+
+/* ===================== SMALL HELPERS ===================== */
+static unsigned bucket_of(const char *path)
+{
+    uint32_t h = 2166136261u;                 // FNV-1a
+    for (; *path; path++) h = (h ^ (unsigned char)*path) * 16777619u;
+    return h % COVER_CACHE_BUCKETS;
+}
+
+static void free_entry(CoverCacheEntry *e)
+{
+    unmap_file(&e->map);
+    free(e->path);
+    free(e);
+}
+
+/* Take e out of the hash and the LRU list (caller holds the lock); the
+   reference the cache held goes with it */
+static void unlink_entry(CoverCache *cache, CoverCacheEntry *e)
+{
+    CoverCacheEntry **p = &cache->buckets[bucket_of(e->path)];
+    while (*p != e) p = &(*p)->chain;
+    *p = e->chain;
+
+    if (e->prev) e->prev->next = e->next; else cache->head = e->next;
+    if (e->next) e->next->prev = e->prev; else cache->tail = e->prev;
+    cache->bytes -= e->size;
+    if (--e->refs == 0) free_entry(e);
+}
+
+static void push_front(CoverCache *cache, CoverCacheEntry *e)
+{
+    e->prev = NULL;
+    e->next = cache->head;
+    if (cache->head) cache->head->prev = e; else cache->tail = e;
+    cache->head = e;
+}
+
+static CoverCacheEntry *find(CoverCache *cache, const char *path)
+{
+    CoverCacheEntry *e = cache->buckets[bucket_of(path)];
+    while (e && strcmp(e->path, path)) e = e->chain;
+    return e;
+}
+
+/* ===================== API ===================== */
+void cover_cache_init(CoverCache *cache, int64_t budget)
+{
+    memset(cache, 0, sizeof(*cache));
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->budget = budget;
+}
+
+Status cover_cache_get(CoverCache *cache, const char *path, CoverCacheEntry **entry)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) return e_failure;
+    int64_t mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+
+    pthread_mutex_lock(&cache->lock);
+    CoverCacheEntry *e = find(cache, path);
+    if (e && e->mtime == mtime && e->size == st.st_size)
+    {
+        e->refs++;
+        if (e != cache->head)                    // most recently used first
+        {
+            e->prev->next = e->next;
+            if (e->next) e->next->prev = e->prev; else cache->tail = e->prev;
+            push_front(cache, e);
+        }
+        cache->hits++;
+        pthread_mutex_unlock(&cache->lock);
+        *entry = e;
+        return e_success;
+    }
+    if (e) unlink_entry(cache, e);               // changed on disk since it was mapped
+    cache->misses++;
+    pthread_mutex_unlock(&cache->lock);
+
+    /* mapping happens outside the lock, so hits never wait for a slow disk */
+    e = calloc(1, sizeof(*e));
+    if (!e || !(e->path = strdup(path)) || map_file(path, &e->map) != e_success)
+    {
+        if (e) free(e->path);
+        free(e);
+        return e_failure;
+    }
+    if (e->map.data) madvise(e->map.data, e->map.size, MADV_WILLNEED);
+    e->mtime = mtime;
+    e->size = e->map.size;
+    e->refs = 1;
+    *entry = e;
+    if (e->size > cache->budget) return e_success;   // never cached, unmapped on release
+
+    pthread_mutex_lock(&cache->lock);
+    if (!find(cache, path))                      // another worker may have mapped it meanwhile
+    {
+        e->refs++;
+        e->chain = cache->buckets[bucket_of(path)];
+        cache->buckets[bucket_of(path)] = e;
+        push_front(cache, e);
+        cache->bytes += e->size;
+        while (cache->bytes > cache->budget && cache->tail != e)
+            unlink_entry(cache, cache->tail);
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return e_success;
+}
+
+void cover_cache_release(CoverCache *cache, CoverCacheEntry *entry)
+{
+    pthread_mutex_lock(&cache->lock);
+    int last = (--entry->refs == 0);
+    pthread_mutex_unlock(&cache->lock);
+    if (last) free_entry(entry);
+}
+
+void cover_cache_destroy(CoverCache *cache)
+{
+    while (cache->head) unlink_entry(cache, cache->head);
+    pthread_mutex_destroy(&cache->lock);
+}
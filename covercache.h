@@ -0,0 +1,54 @@
+#ifndef COVERCACHE_H
+#define COVERCACHE_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "types.h"
+#include "fileio.h"   // MappedFile
+
+/*----------------------------------------------------------
+    LRU of mapped cover images, shared by the daemon workers
+
+    A hit costs one stat (to notice a cover that changed on disk)
+    and no open, mmap or page faults. Entries are reference
+    counted: eviction only unlinks an entry, the last user unmaps
+    it. Covers larger than the whole budget are handed out
+    uncached.
+----------------------------------------------------------*/
+
+#define COVER_CACHE_BUCKETS 1024
+
+typedef struct _CoverCacheEntry
+{
+    char *path;
+    int64_t mtime;                          // ns, as seen when it was mapped
+    int64_t size;
+    MappedFile map;
+    int refs;                               // users + 1 while linked in the cache
+    struct _CoverCacheEntry *prev, *next;   // LRU list, most recent first
+    struct _CoverCacheEntry *chain;         // hash bucket
+} CoverCacheEntry;
+
+typedef struct _CoverCache
+{
+    pthread_mutex_t lock;
+    CoverCacheEntry *buckets[COVER_CACHE_BUCKETS];
+    CoverCacheEntry *head, *tail;           // LRU order
+    int64_t bytes;                          // mapped bytes linked in the cache
+    int64_t budget;                         // evict beyond this
+    int64_t hits, misses;
+} CoverCache;
+
+/* Empty cache that keeps at most budget bytes of covers mapped */
+void cover_cache_init(CoverCache *cache, int64_t budget);
+
+/* The mapped cover at path (e_failure if it cannot be mapped). Pass the
+   entry to cover_cache_release when done with entry->map. */
+Status cover_cache_get(CoverCache *cache, const char *path, CoverCacheEntry **entry);
+
+void cover_cache_release(CoverCache *cache, CoverCacheEntry *entry);
+
+/* Unmap everything (no entry may be in use) */
+void cover_cache_destroy(CoverCache *cache);
+
+#endif // COVERCACHE_H
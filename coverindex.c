@@ -0,0 +1,420 @@
+#define _DEFAULT_SOURCE      // d_type, st_mtim, MUST be first line
+#define _FILE_OFFSET_BITS 64 // same off_t as fileio.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/mman.h>        // madvise
+#include "coverindex.h"
+#include "crc32c.h"          // checksum of the index
+#include "fileio.h"          // map_file
+#include "pool.h"            // run_tasks: headers of changed files
+#include "console.h"         // console_quiet
+
+#define COVER_READ 4096      // one pread per new or changed file: the BMP headers
+
+/* ===================== SMALL LITTLE ENDIAN HELPERS ===================== */
+static void put_le(unsigned char *p, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) p[i] = (v >> (i * 8)) & 0xFF;
+}
+
+static uint64_t get_le(const unsigned char *p, int bytes)
+{
+    uint64_t v = 0;
+    for (int i = bytes - 1; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+/* ===================== ONE COVER ===================== */
+typedef struct
+{
+    char *path;
+    int64_t mtime;                   // ns since the epoch
+    int64_t size;                    // file size
+    PixelView view;                  // from the BMP headers (or the old record)
+    int64_t capacity;                // depth 1, CRC, 4 character extension
+    int usable;                      // a BMP we can hide data in
+    int reused;                      // record taken over from the old index
+} CoverEntry;
+
+typedef struct
+{
+    CoverEntry *items;
+    int count;
+    int cap;
+} CoverList;
+
+static int64_t stat_mtime(const struct stat *st)
+{
+    return (int64_t)st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec;
+}
+
+static int64_t cover_capacity(const PixelView *view)
+{
+    StegoOptions opts = { .depth = 1, .flags = STEGO_FLAG_CRC };    // the CLI defaults
+    int64_t capacity = 0;
+    stego_capacity(view, MAX_FILE_SUFFIX, &opts, &capacity);
+    return capacity;
+}
+
+static void add_cover(CoverList *list, const char *path, const struct stat *st)
+{
+    if (list->count == list->cap)
+    {
+        int cap = list->cap ? list->cap * 2 : 1024;
+        CoverEntry *grown = realloc(list->items, cap * sizeof(*grown));
+        if (!grown) return;
+        list->items = grown;
+        list->cap = cap;
+    }
+    CoverEntry *e = &list->items[list->count];
+    memset(e, 0, sizeof(*e));
+    if (!(e->path = strdup(path))) return;
+    e->mtime = stat_mtime(st);
+    e->size = st->st_size;
+    list->count++;
+}
+
+static int is_bmp_name(const char *name)
+{
+    size_t len = strlen(name);
+    return len > 4 && !strcasecmp(name + len - 4, ".bmp");
+}
+
+/* Every *.bmp below dir; symlinks are not followed */
+static void walk_dir(const char *dir, CoverList *list)
+{
+    DIR *d = opendir(dir);
+    struct dirent *e;
+
+    if (!d)
+    {
+        fprintf(stderr, "[WARN] Cannot open directory: %s\n", dir);
+        return;
+    }
+    while ((e = readdir(d)) != NULL)
+    {
+        if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) continue;
+
+        size_t len = strlen(dir) + strlen(e->d_name) + 2;
+        char *path = malloc(len);
+        struct stat st;
+        if (!path) break;
+        snprintf(path, len, "%s/%s", dir, e->d_name);
+
+        if (e->d_type == DT_DIR || (e->d_type == DT_UNKNOWN && lstat(path, &st) == 0 && S_ISDIR(st.st_mode)))
+            walk_dir(path, list);
+        else if ((e->d_type == DT_REG || e->d_type == DT_UNKNOWN) && is_bmp_name(e->d_name) &&
+                 lstat(path, &st) == 0 && S_ISREG(st.st_mode))
+            add_cover(list, path, &st);     // the stat is needed anyway for mtime and size
+        free(path);
+    }
+    closedir(d);
+}
+
+/* ===================== RECORDS ===================== */
+static void write_record(unsigned char *r, const CoverEntry *e, uint64_t path_offset)
+{
+    memset(r, 0, COVER_INDEX_RECORD);
+    put_le(r, e->mtime, 8);
+    put_le(r + 8, e->size, 8);
+    put_le(r + 16, e->view.offset, 8);
+    put_le(r + 24, e->view.stride, 8);
+    put_le(r + 32, e->view.row_bytes, 8);
+    put_le(r + 40, e->view.width, 4);
+    put_le(r + 44, e->view.height, 4);
+    put_le(r + 48, e->view.rows, 4);
+    r[52] = e->view.bytes_per_pixel;
+    r[53] = e->view.channels;
+    r[54] = e->view.top_down;
+    put_le(r + 56, path_offset, 8);
+    put_le(r + 64, strlen(e->path), 2);
+    put_le(r + 72, e->capacity, 8);
+}
+
+static void read_record_view(const unsigned char *r, PixelView *view)
+{
+    view->offset = (int64_t)get_le(r + 16, 8);
+    view->stride = (int64_t)get_le(r + 24, 8);
+    view->row_bytes = (int64_t)get_le(r + 32, 8);
+    view->width = (int64_t)get_le(r + 40, 4);
+    view->height = (int64_t)get_le(r + 44, 4);
+    view->rows = (int64_t)get_le(r + 48, 4);
+    view->bytes_per_pixel = r[52];
+    view->channels = r[53];
+    view->top_down = r[54];
+}
+
+/* ===================== AN EXISTING INDEX ===================== */
+typedef struct
+{
+    MappedFile map;
+    uint32_t count;
+    const unsigned char *records;
+    const char *paths;
+    uint64_t paths_len;
+} CoverIndex;
+
+/* full: also check the CRC of records and paths (O(n), only when rewriting) */
+static Status open_index(const char *fname, CoverIndex *idx, int full)
+{
+    memset(idx, 0, sizeof(*idx));
+    if (map_file(fname, &idx->map) != e_success) return e_failure;
+
+    const unsigned char *h = idx->map.data;
+    Status ret = e_bad_header;
+    if (idx->map.size >= COVER_INDEX_HEADER && memcmp(h, COVER_INDEX_MAGIC, 4) == 0 &&
+        h[4] == COVER_INDEX_VERSION && get_le(h + 12, 4) == COVER_INDEX_RECORD &&
+        get_le(h + 28, 4) == crc32c(0, h, 28))
+    {
+        idx->count = (uint32_t)get_le(h + 8, 4);
+        idx->paths_len = get_le(h + 16, 8);
+        uint64_t body = (uint64_t)idx->map.size - COVER_INDEX_HEADER;
+        if ((uint64_t)idx->count <= body / COVER_INDEX_RECORD &&
+            idx->paths_len == body - (uint64_t)idx->count * COVER_INDEX_RECORD)
+            ret = e_success;
+    }
+    if (ret == e_success)
+    {
+        idx->records = h + COVER_INDEX_HEADER;
+        idx->paths = (const char *)idx->records + (size_t)idx->count * COVER_INDEX_RECORD;
+        if (full && get_le(h + 24, 4) != crc32c(0, idx->records, idx->map.size - COVER_INDEX_HEADER))
+            ret = e_bad_crc;
+    }
+    if (ret != e_success) unmap_file(&idx->map);
+    return ret;
+}
+
+/* Path of record i, or NULL if it points outside the path area */
+static const char *record_path(const CoverIndex *idx, uint32_t i, size_t *len)
+{
+    const unsigned char *r = idx->records + (size_t)i * COVER_INDEX_RECORD;
+    uint64_t offset = get_le(r + 56, 8);
+    *len = get_le(r + 64, 2);
+    return (offset <= idx->paths_len && *len <= idx->paths_len - offset) ? idx->paths + offset : NULL;
+}
+
+/* ===================== HEADERS OF NEW OR CHANGED FILES ===================== */
+static void read_cover_task(void *ctx, int index)
+{
+    CoverEntry **todo = ctx;
+    CoverEntry *e = todo[index];
+    unsigned char buf[COVER_READ];
+    size_t need;
+
+    int fd = open(e->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    ssize_t got = pread(fd, buf, sizeof(buf), 0);
+    close(fd);
+    if (got > 0 && stego_parse_bmp(buf, got, e->size, &e->view, &need) == e_success)
+    {
+        e->capacity = cover_capacity(&e->view);
+        e->usable = e->capacity > 0;
+    }
+}
+
+typedef struct
+{
+    const char *path;
+    size_t len;
+    uint32_t record;
+} OldPath;
+
+static int cmp_old_path(const void *a, const void *b)
+{
+    const OldPath *x = a, *y = b;
+    int c = memcmp(x->path, y->path, x->len < y->len ? x->len : y->len);
+    return c ? c : (x->len > y->len) - (x->len < y->len);
+}
+
+/* Smaller covers first; the path keeps the order stable between runs */
+static int cmp_carriers(const void *a, const void *b)
+{
+    const CoverEntry *x = a, *y = b;
+    int64_t cx = x->view.rows * x->view.row_bytes, cy = y->view.rows * y->view.row_bytes;
+    if (cx != cy) return cx < cy ? -1 : 1;
+    return strcmp(x->path, y->path);
+}
+
+/* ===================== -i: BUILD OR UPDATE ===================== */
+Status cover_index_update(const char *index_fname, char *dirs[], int count, int workers)
+{
+    CoverList list = { 0 };
+    CoverIndex old;
+    OldPath *old_paths = NULL;
+    struct stat st;
+    int reused = 0, read = 0, usable = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (stat(dirs[i], &st) != 0)
+            fprintf(stderr, "[WARN] Cannot stat: %s\n", dirs[i]);
+        else if (S_ISDIR(st.st_mode))
+            walk_dir(dirs[i], &list);
+        else if (S_ISREG(st.st_mode))
+            add_cover(&list, dirs[i], &st);
+    }
+
+    /* records of files with the same path, mtime and size are taken over as they are */
+    Status old_ret = open_index(index_fname, &old, 1);
+    if (old_ret == e_success && old.count && (old_paths = malloc(old.count * sizeof(*old_paths))))
+    {
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < old.count; i++)
+        {
+            size_t len;
+            const char *p = record_path(&old, i, &len);
+            if (p) old_paths[n++] = (OldPath){ p, len, i };
+        }
+        qsort(old_paths, n, sizeof(*old_paths), cmp_old_path);
+
+        for (int i = 0; i < list.count; i++)
+        {
+            CoverEntry *e = &list.items[i];
+            OldPath key = { e->path, strlen(e->path), 0 };
+            OldPath *hit = bsearch(&key, old_paths, n, sizeof(*old_paths), cmp_old_path);
+            if (!hit) continue;
+            const unsigned char *r = old.records + (size_t)hit->record * COVER_INDEX_RECORD;
+            if ((int64_t)get_le(r, 8) != e->mtime || (int64_t)get_le(r + 8, 8) != e->size) continue;
+            read_record_view(r, &e->view);
+            e->capacity = (int64_t)get_le(r + 72, 8);
+            e->usable = e->reused = 1;
+            reused++;
+        }
+    }
+    else if (old_ret == e_bad_header || old_ret == e_bad_crc)
+    {
+        fprintf(stderr, "[WARN] %s is not a valid cover index, rebuilding it\n", index_fname);
+    }
+    free(old_paths);
+    if (old_ret == e_success) unmap_file(&old.map);
+
+    /* everything else costs one open and one pread, on the pool */
+    CoverEntry **todo = malloc((list.count ? list.count : 1) * sizeof(*todo));
+    if (!todo) return e_failure;
+    for (int i = 0; i < list.count; i++)
+        if (!list.items[i].reused) todo[read++] = &list.items[i];
+    if (workers < 1) workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    run_tasks(workers, read, read_cover_task, todo);
+    free(todo);
+
+    /* usable covers, smallest first */
+    uint64_t paths_len = 0;
+    for (int i = 0; i < list.count; i++)
+    {
+        if (!list.items[i].usable)
+        {
+            free(list.items[i].path);
+            continue;
+        }
+        paths_len += strlen(list.items[i].path);
+        list.items[usable++] = list.items[i];
+    }
+    qsort(list.items, usable, sizeof(*list.items), cmp_carriers);
+
+    size_t body_len = (size_t)usable * COVER_INDEX_RECORD + paths_len;
+    unsigned char *body = malloc(body_len ? body_len : 1);
+    unsigned char header[COVER_INDEX_HEADER] = { 0 };
+    Status ret = body ? e_success : e_failure;
+    if (ret == e_success)
+    {
+        char *paths = (char *)body + (size_t)usable * COVER_INDEX_RECORD;
+        uint64_t at = 0;
+        for (int i = 0; i < usable; i++)
+        {
+            size_t len = strlen(list.items[i].path);
+            write_record(body + (size_t)i * COVER_INDEX_RECORD, &list.items[i], at);
+            memcpy(paths + at, list.items[i].path, len);
+            at += len;
+        }
+        memcpy(header, COVER_INDEX_MAGIC, 4);
+        header[4] = COVER_INDEX_VERSION;
+        put_le(header + 8, usable, 4);
+        put_le(header + 12, COVER_INDEX_RECORD, 4);
+        put_le(header + 16, paths_len, 8);
+        put_le(header + 24, crc32c(0, body, body_len), 4);
+        put_le(header + 28, crc32c(0, header, 28), 4);
+    }
+
+    /* written next to the old one and renamed over it, so a reader never sees half an index */
+    size_t tmp_len = strlen(index_fname) + 5;
+    char *tmp = malloc(tmp_len);
+    FILE *fp = NULL;
+    if (ret == e_success && tmp)
+    {
+        snprintf(tmp, tmp_len, "%s.tmp", index_fname);
+        fp = fopen(tmp, "wb");
+    }
+    if (ret == e_success && (!fp || fwrite(header, 1, sizeof(header), fp) != sizeof(header) ||
+                             fwrite(body, 1, body_len, fp) != body_len))
+        ret = e_failure;
+    if (fp && fclose(fp) != 0) ret = e_failure;
+    if (ret == e_success && rename(tmp, index_fname) != 0) ret = e_failure;
+    if (ret != e_success && fp) unlink(tmp);
+
+    if (ret != e_success)
+        fprintf(stderr, "[ERROR] Cannot write cover index: %s\n", index_fname);
+    else if (!console_quiet)
+        fprintf(stderr, "[INFO] Cover index %s: %d cover(s), %d unchanged, %d read, %d not usable\n",
+                index_fname, usable, reused, read, list.count - usable);
+
+    for (int i = 0; i < usable; i++) free(list.items[i].path);
+    free(list.items);
+    free(body);
+    free(tmp);
+    return ret;
+}
+
+/* ===================== --cover-index: BEST FIT ===================== */
+static int record_fits(const CoverIndex *idx, uint32_t i, int64_t secret_len, int extn_len,
+                       const StegoOptions *opts, int64_t *capacity)
+{
+    PixelView view;
+    read_record_view(idx->records + (size_t)i * COVER_INDEX_RECORD, &view);
+    *capacity = 0;
+    return stego_capacity(&view, extn_len, opts, capacity) == e_success && *capacity >= secret_len;
+}
+
+Status cover_index_pick(const char *index_fname, int64_t secret_len, int extn_len,
+                        const StegoOptions *opts, char *path, size_t path_cap, int64_t *capacity)
+{
+    CoverIndex idx;
+    struct stat st;
+
+    if (open_index(index_fname, &idx, 0) != e_success) return e_failure;
+    if (idx.map.data) madvise(idx.map.data, idx.map.size, MADV_RANDOM);   // a few records, not a scan
+
+    /* capacity only grows with the carrier count the records are sorted by: lower bound */
+    uint32_t lo = 0, hi = idx.count;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (record_fits(&idx, mid, secret_len, extn_len, opts, capacity))
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    /* a cover edited or deleted since indexing is passed over for the next larger one */
+    Status ret = e_failure;
+    for (uint32_t i = lo; i < idx.count && ret != e_success; i++)
+    {
+        const unsigned char *r = idx.records + (size_t)i * COVER_INDEX_RECORD;
+        size_t len;
+        const char *p = record_path(&idx, i, &len);
+        if (!p || len + 1 > path_cap || !record_fits(&idx, i, secret_len, extn_len, opts, capacity)) continue;
+
+        memcpy(path, p, len);
+        path[len] = '\0';
+        if (stat(path, &st) == 0 && stat_mtime(&st) == (int64_t)get_le(r, 8) &&
+            st.st_size == (off_t)get_le(r + 8, 8))
+            ret = e_success;
+    }
+    unmap_file(&idx.map);
+    return ret;
+}
@@ -0,0 +1,49 @@
+#ifndef COVERINDEX_H
+#define COVERINDEX_H
+
+#include <stddef.h>   // size_t
+#include <stdint.h>   // int64_t
+#include "types.h"
+#include "stego.h"    // StegoOptions
+
+/*----------------------------------------------------------
+    Cover index: pick a cover from a large library without
+    opening it first
+
+    -i scans cover directories once, reading only the BMP headers of
+    each file, and saves one fixed-size record per usable cover, sorted
+    by the number of carrier bytes. Little endian:
+        header  32 bytes: magic "STGI" | version | 0 | 0 (16)
+                | cover count (32) | record size (32) | path bytes (64)
+                | CRC32C of records + paths | CRC32C of header bytes 0..27
+        records COVER_INDEX_RECORD bytes each: mtime (ns) | file size
+                | pixel offset | row stride | carrier bytes per row
+                | width | height | rows | bytes per pixel | channels
+                | top down | 0 | path offset | path length | 0
+                | capacity (depth 1, CRC, 4 character extension)
+        paths   every path back to back, no terminators
+    Running -i again re-reads only files whose mtime or size changed.
+    --cover-index maps the index and binary searches the records for the
+    smallest cover that holds the secret: O(log n) record reads and one
+    stat of the cover picked, however large the library is.
+----------------------------------------------------------*/
+
+#define COVER_INDEX_MAGIC "STGI"
+#define COVER_INDEX_VERSION 1
+#define COVER_INDEX_HEADER 32
+#define COVER_INDEX_RECORD 80
+
+/* Scan dirs (and plain files) into index_fname, reusing the records of
+   files that did not change since the index was last written. workers
+   threads read the headers (< 1: one per CPU). Prints a summary on
+   stderr; e_failure if the index cannot be written. */
+Status cover_index_update(const char *index_fname, char *dirs[], int count, int workers);
+
+/* Smallest indexed cover that holds secret_len bytes next to an extension
+   of extn_len characters with opts. Its path goes to path (path_cap
+   bytes). Covers changed since indexing are passed over. e_failure if no
+   cover is large enough or the index is unusable. */
+Status cover_index_pick(const char *index_fname, int64_t secret_len, int extn_len,
+                        const StegoOptions *opts, char *path, size_t path_cap, int64_t *capacity);
+
+#endif // COVERINDEX_H
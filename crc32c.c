@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "crc32c.h"
+
+#if defined(__x86_64__)
+#define CRC_X86 1
+#include <immintrin.h>
+#endif
+
+#define CRC_POLY 0x82F63B78u        // Castagnoli polynomial, bit reversed
+#define CRC_LANE 2048               // bytes per stream in the 3-way pclmul loop
+#define CRC_POW_BITS 68             // x^(2^k) for every bit of an int64_t length in bits
+
+/* ===================== TABLE VERSION (slicing by 8) ===================== */
+static uint32_t table[8][256];
+
+static void build_table(void)
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t c = i;
+        for (int j = 0; j < 8; j++) c = (c & 1) ? (c >> 1) ^ CRC_POLY : c >> 1;
+        table[0][i] = c;
+    }
+    for (int k = 1; k < 8; k++)
+        for (int i = 0; i < 256; i++)
+            table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+}
+
+/* Raw register in and out (no inversion): the other versions finish with this */
+static uint32_t update_table(uint32_t c, const unsigned char *p, size_t n)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; n >= 8; p += 8, n -= 8)
+    {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        w ^= c;
+        c = table[7][w & 0xFF] ^ table[6][(w >> 8) & 0xFF] ^
+            table[5][(w >> 16) & 0xFF] ^ table[4][(w >> 24) & 0xFF] ^
+            table[3][(w >> 32) & 0xFF] ^ table[2][(w >> 40) & 0xFF] ^
+            table[1][(w >> 48) & 0xFF] ^ table[0][w >> 56];
+    }
+#endif
+    while (n--) c = table[0][(c ^ *p++) & 0xFF] ^ (c >> 8);
+    return c;
+}
+
+/* ===================== POLYNOMIAL ARITHMETIC MOD P ===================== */
+/* Bit 31 is x^0 (the reflected order the CRC register uses) */
+static uint32_t pow2_table[CRC_POW_BITS];   // x^(2^k) mod P
+
+static uint32_t mult_mod(uint32_t a, uint32_t b)
+{
+    uint32_t m = 1u << 31, p = 0;
+
+    for (;;)
+    {
+        if (a & m)
+        {
+            p ^= b;
+            if ((a & (m - 1)) == 0) break;
+        }
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ CRC_POLY : b >> 1;
+    }
+    return p;
+}
+
+/* x^(n * 2^k) mod P */
+static uint32_t pow_mod(uint64_t n, int k)
+{
+    uint32_t p = 1u << 31;
+
+    for (; n; n >>= 1, k++)
+        if (n & 1) p = mult_mod(pow2_table[k], p);
+    return p;
+}
+
+static void build_pow2_table(void)
+{
+    pow2_table[0] = 1u << 30;                      // x^1
+    for (int k = 1; k < CRC_POW_BITS; k++)
+        pow2_table[k] = mult_mod(pow2_table[k - 1], pow2_table[k - 1]);
+}
+
+uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, int64_t len2)
+{
+    return mult_mod(pow_mod((uint64_t)len2, 3), crc1) ^ crc2;
+}
+
+uint32_t crc32c_join(const uint32_t *crcs, int64_t total, int64_t grain)
+{
+    uint32_t crc = 0;
+    uint32_t full = pow_mod((uint64_t)grain, 3);   // every slice but the last has the same length
+
+    for (int64_t begin = 0; begin < total; begin += grain, crcs++)
+    {
+        int64_t len = (total - begin < grain) ? total - begin : grain;
+        crc = mult_mod(len == grain ? full : pow_mod((uint64_t)len, 3), crc) ^ *crcs;
+    }
+    return crc;
+}
+
+/* ===================== SSE4.2 crc32 INSTRUCTION ===================== */
+#ifdef CRC_X86
+__attribute__((target("sse4.2")))
+static uint32_t update_sse42(uint32_t c, const unsigned char *p, size_t n)
+{
+    uint64_t c64 = c;
+
+    for (; n >= 8; p += 8, n -= 8)
+    {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        c64 = _mm_crc32_u64(c64, w);
+    }
+    c = (uint32_t)c64;
+    while (n--) c = _mm_crc32_u8(c, *p++);
+    return c;
+}
+
+/* ===================== THREE crc32 STREAMS JOINED WITH PCLMUL ===================== */
+/* One crc32 has 3 cycles of latency but issues every cycle: three independent
+   lanes keep the unit busy. Lane registers are then moved past the bytes that
+   follow them with one carry-less multiply by x^(8*len - 33) and one crc32. */
+static uint32_t lane_shift1, lane_shift2;   // x^(8*CRC_LANE - 33), x^(16*CRC_LANE - 33)
+
+__attribute__((target("sse4.2,pclmul")))
+static uint32_t shift_lane(uint32_t c, uint32_t k)
+{
+    __m128i prod = _mm_clmulepi64_si128(_mm_cvtsi32_si128((int)c), _mm_cvtsi32_si128((int)k), 0);
+    return (uint32_t)_mm_crc32_u64(0, (uint64_t)_mm_cvtsi128_si64(prod));
+}
+
+__attribute__((target("sse4.2,pclmul")))
+static uint32_t update_pclmul(uint32_t c, const unsigned char *p, size_t n)
+{
+    for (; n >= 3 * CRC_LANE; p += 3 * CRC_LANE, n -= 3 * CRC_LANE)
+    {
+        uint64_t c0 = c, c1 = 0, c2 = 0;
+        for (size_t i = 0; i < CRC_LANE; i += 8)
+        {
+            uint64_t w0, w1, w2;
+            memcpy(&w0, p + i, 8);
+            memcpy(&w1, p + CRC_LANE + i, 8);
+            memcpy(&w2, p + 2 * CRC_LANE + i, 8);
+            c0 = _mm_crc32_u64(c0, w0);
+            c1 = _mm_crc32_u64(c1, w1);
+            c2 = _mm_crc32_u64(c2, w2);
+        }
+        c = shift_lane((uint32_t)c0, lane_shift2) ^ shift_lane((uint32_t)c1, lane_shift1) ^ (uint32_t)c2;
+    }
+    return update_sse42(c, p, n);
+}
+#endif
+
+/* ===================== SELECTION ===================== */
+typedef struct
+{
+    const char *name;
+    uint32_t (*update)(uint32_t c, const unsigned char *p, size_t n);
+} CrcImpl;
+
+static const CrcImpl impl_table = { "table", update_table };
+#ifdef CRC_X86
+static const CrcImpl impl_sse42 = { "sse42", update_sse42 };
+static const CrcImpl impl_pclmul = { "pclmul", update_pclmul };
+#endif
+
+static const CrcImpl *impl = &impl_table;
+
+/* Check one implementation against the table on odd sizes and offsets */
+static Status check_impl(const CrcImpl *candidate)
+{
+    enum { N = 3 * CRC_LANE * 2 + 77 };
+    static unsigned char buf[N];
+    uint32_t seed = 0x27D4EB2Fu;
+
+    if (~candidate->update(~0u, (const unsigned char *)"123456789", 9) != 0xE3069283u)
+        return e_failure;
+
+    for (size_t i = 0; i < N; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        buf[i] = seed >> 24;
+    }
+    for (size_t off = 0; off < 8; off += 3)
+    {
+        size_t sizes[] = { 0, 1, 7, 8, 63, 3 * CRC_LANE, 3 * CRC_LANE + 5, N - off };
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+        {
+            if (candidate->update(~0u, buf + off, sizes[s]) != update_table(~0u, buf + off, sizes[s]))
+                return e_failure;
+        }
+    }
+    return e_success;
+}
+
+__attribute__((constructor))
+static void crc_select(void)
+{
+    const char *force = getenv("STEGO_CRC");
+
+    build_table();
+    build_pow2_table();
+
+#ifdef CRC_X86
+    lane_shift1 = pow_mod(8 * CRC_LANE - 33, 0);
+    lane_shift2 = pow_mod(16 * CRC_LANE - 33, 0);
+
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) impl = &impl_sse42;
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("pclmul")) impl = &impl_pclmul;
+#endif
+
+    if (force)
+    {
+        if (!strcmp(force, "table")) impl = &impl_table;
+#ifdef CRC_X86
+        else if (!strcmp(force, "sse42") && __builtin_cpu_supports("sse4.2")) impl = &impl_sse42;
+#endif
+    }
+
+#ifndef NDEBUG
+    if (crc32c_self_check() != e_success)
+    {
+        fprintf(stderr, "[WARN] CRC32C '%s' failed self check, using table\n", impl->name);
+        impl = &impl_table;
+    }
+#endif
+}
+
+/* ===================== PUBLIC ENTRY POINTS ===================== */
+uint32_t crc32c(uint32_t crc, const void *data, size_t n)
+{
+    return ~impl->update(~crc, data, n);
+}
+
+const char *crc32c_impl_name(void)
+{
+    return impl->name;
+}
+
+Status crc32c_self_check(void)
+{
+    unsigned char buf[300];
+
+    if (check_impl(impl) != e_success) return e_failure;
+
+    /* joining two parts must give the CRC of the whole */
+    for (size_t i = 0; i < sizeof(buf); i++) buf[i] = (unsigned char)(i * 131 + 7);
+    if (crc32c_combine(crc32c(0, buf, 100), crc32c(0, buf + 100, 200), 200) != crc32c(0, buf, 300))
+        return e_failure;
+    return e_success;
+}
@@ -0,0 +1,35 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stddef.h>   // size_t
+#include <stdint.h>   // uint32_t, int64_t
+#include "types.h"    // Status
+
+/*----------------------------------------------------------
+    CRC32C (Castagnoli) of the hidden data (part of libstego)
+
+    The implementation (pclmul, sse42 or table) is picked once at
+    startup from CPUID. Setting STEGO_CRC=<name> in the environment
+    forces a specific one, like STEGO_LSB does for the LSB kernels.
+----------------------------------------------------------*/
+
+/* Continue a CRC over n more bytes; start with crc = 0. Pieces may be
+   any size: crc32c(crc32c(0, a, na), b, nb) is the CRC of a then b. */
+uint32_t crc32c(uint32_t crc, const void *data, size_t n);
+
+/* CRC of A then B from crc1 = CRC of A and crc2 = CRC of B (len2 bytes),
+   so slices checked on different threads can be joined in order */
+uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, int64_t len2);
+
+/* CRC of [0, total) from the CRCs of its slices of grain bytes (the last
+   one may be shorter), in order: how parallel_for workers are joined */
+uint32_t crc32c_join(const uint32_t *crcs, int64_t total, int64_t grain);
+
+/* Name of the implementation currently in use */
+const char *crc32c_impl_name(void);
+
+/* Compare the implementation in use with the table version (also run
+   at startup unless built with -DNDEBUG) */
+Status crc32c_self_check(void);
+
+#endif // CRC32C_H
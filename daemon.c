@@ -0,0 +1,709 @@
+#define _GNU_SOURCE          // accept4, MSG_CMSG_CLOEXEC, MUST be first line
+#define _FILE_OFFSET_BITS 64 // same off_t as fileio.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>        // PRId64
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "daemon.h"
+#include "stego.h"           // the in-memory library does the work
+#include "fileio.h"          // write_all_at
+#include "covercache.h"      // covers stay mapped between requests
+#include "console.h"         // console_quiet
+#include "lsb.h"             // LSB_MAX_DEPTH
+
+/* ===================== CONNECTIONS AND JOBS ===================== */
+typedef struct
+{
+    int fd;
+    atomic_int refs;                 // the reader + every queued or running job
+    unsigned seq;                    // requests read so far (reader thread only)
+} DaemonConn;
+
+typedef struct
+{
+    DaemonConn *conn;
+    unsigned seq;                    // echoed in the reply
+    size_t len;                      // bytes received in line
+    char line[DAEMON_MSG_MAX + 1];
+    int fds[DAEMON_FDS_MAX];         // received with the request, closed after it
+    int nfds;
+} DaemonJob;
+
+static void conn_release(DaemonConn *conn)
+{
+    if (atomic_fetch_sub(&conn->refs, 1) == 1)
+    {
+        close(conn->fd);             // only now: a worker may still be replying on it
+        free(conn);
+    }
+}
+
+/* ===================== BOUNDED QUEUE ===================== */
+typedef struct
+{
+    DaemonJob **ring;
+    int cap, head, count;
+    int closing;                     // no more jobs: workers drain and exit
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty, not_full;
+} JobQueue;
+
+/* Blocks while the queue is full: that is the backpressure */
+static void queue_push(JobQueue *q, DaemonJob *job)
+{
+    pthread_mutex_lock(&q->lock);
+    while (q->count == q->cap) pthread_cond_wait(&q->not_full, &q->lock);
+    q->ring[(q->head + q->count) % q->cap] = job;
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+/* NULL once the queue is closed and empty */
+static DaemonJob *queue_pop(JobQueue *q)
+{
+    DaemonJob *job = NULL;
+
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0 && !q->closing) pthread_cond_wait(&q->not_empty, &q->lock);
+    if (q->count)
+    {
+        job = q->ring[q->head];
+        q->head = (q->head + 1) % q->cap;
+        q->count--;
+        pthread_cond_signal(&q->not_full);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return job;
+}
+
+/* ===================== ONE REQUEST ===================== */
+typedef struct
+{
+    const DaemonOptions *opts;
+    CoverCache cache;
+    JobQueue queue;
+    atomic_long served;
+    atomic_long failed;
+} Daemon;
+
+/* A file of the request: an absolute path or @k, the k-th descriptor sent with it */
+typedef struct
+{
+    const char *path;
+    int fd;                          // -1 for a path
+} Operand;
+
+static Status resolve(const DaemonJob *job, const char *tok, Operand *o)
+{
+    o->path = NULL;
+    o->fd = -1;
+    if (tok[0] == '@')
+    {
+        char *end;
+        long k = strtol(tok + 1, &end, 10);
+        if (*end || end == tok + 1 || k < 0 || k >= job->nfds) return e_failure;
+        o->fd = job->fds[k];
+        return e_success;
+    }
+    o->path = tok;
+    return tok[0] == '/' ? e_success : e_failure;    // the daemon's cwd means nothing to the client
+}
+
+/* Map an input; a received descriptor is mapped in place and stays the job's to close */
+static Status map_operand(const Operand *o, MappedFile *map)
+{
+    struct stat st;
+
+    if (o->path) return map_file(o->path, map);
+    map->fd = -1;
+    map->data = NULL;
+    map->size = 0;
+    if (fstat(o->fd, &st) != 0 || !S_ISREG(st.st_mode)) return e_failure;
+    map->size = st.st_size;
+    if (map->size == 0) return e_success;
+    void *p = mmap(NULL, map->size, PROT_READ, MAP_PRIVATE, o->fd, 0);
+    if (p == MAP_FAILED) return e_failure;
+    map->data = p;
+    return e_success;
+}
+
+/* Write len bytes to a path (plus suffix) or a received descriptor, replacing its contents */
+static Status write_operand(const Operand *o, const char *suffix, const unsigned char *data, size_t len)
+{
+    int fd = o->fd;
+
+    if (o->path)
+    {
+        char name[DAEMON_MSG_MAX + 8];
+        snprintf(name, sizeof(name), "%s%s", o->path, suffix);
+        fd = open(name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) return e_failure;
+    }
+    Status ret = write_all_at(fd, data, len, 0);
+    if (ret == e_success && !o->path && ftruncate(fd, len) != 0) ret = e_failure;
+    if (o->path && close(fd) != 0) ret = e_failure;
+    return ret;
+}
+
+static Status do_encode(Daemon *d, const DaemonJob *job, char *ops[], const StegoOptions *opts,
+                        const char *extn, char *reply, size_t cap)
+{
+    Operand cover, secret, out;
+    if (resolve(job, ops[0], &cover) != e_success || resolve(job, ops[1], &secret) != e_success ||
+        resolve(job, ops[2], &out) != e_success)
+    {
+        snprintf(reply, cap, "ERR file names must be absolute paths or @k");
+        return e_failure;
+    }
+
+    /* the secret's own extension, unless the request names one; same list as the CLI */
+    const char *slash = secret.path ? strrchr(secret.path, '/') : NULL;
+    const char *dot = slash ? strrchr(slash, '.') : NULL;
+    if (!extn) extn = dot ? dot : "";
+    if (!stego_extn_supported(extn))
+    {
+        snprintf(reply, cap, "ERR secret file type not supported (.txt, .c, .h, .sh)");
+        return e_failure;
+    }
+
+    /* covers named by path come from the cache; received descriptors are mapped per request */
+    CoverCacheEntry *entry = NULL;
+    MappedFile image, data;
+    Status ret = cover.path ? cover_cache_get(&d->cache, cover.path, &entry) : map_operand(&cover, &image);
+    if (ret != e_success)
+    {
+        snprintf(reply, cap, "ERR cannot map cover");
+        return e_failure;
+    }
+    if (entry) image = entry->map;
+
+    if (map_operand(&secret, &data) != e_success)
+    {
+        snprintf(reply, cap, "ERR cannot map secret");
+        ret = e_failure;
+    }
+    else
+    {
+        unsigned char *buf = malloc(image.size ? image.size : 1);
+        ret = buf ? stego_encode(image.data, buf, image.size, data.data, data.size, extn, opts) : e_failure;
+        if (ret != e_success)
+            snprintf(reply, cap, "ERR %s", stego_strerror(ret));
+        else if ((ret = write_operand(&out, "", buf, image.size)) != e_success)
+            snprintf(reply, cap, "ERR cannot write output");
+        else
+            snprintf(reply, cap, "OK encoded %" PRId64 " bytes", (int64_t)data.size);
+        free(buf);
+        if (data.data) munmap(data.data, data.size);
+        if (secret.path && data.fd >= 0) close(data.fd);
+    }
+
+    if (entry)
+        cover_cache_release(&d->cache, entry);
+    else
+    {
+        if (image.data) munmap(image.data, image.size);
+    }
+    return ret;
+}
+
+static Status do_decode(const DaemonJob *job, char *ops[], const char *passphrase, char *reply, size_t cap)
+{
+    Operand in, out;
+    MappedFile image;
+    StegoInfo info;
+
+    if (resolve(job, ops[0], &in) != e_success || resolve(job, ops[1], &out) != e_success)
+    {
+        snprintf(reply, cap, "ERR file names must be absolute paths or @k");
+        return e_failure;
+    }
+    if (map_operand(&in, &image) != e_success)
+    {
+        snprintf(reply, cap, "ERR cannot map image");
+        return e_failure;
+    }
+
+    Status ret = stego_probe(image.data, image.size, &info);
+    if (ret == e_success && (info.flags & (STEGO_FLAG_CONTAINER | STEGO_FLAG_SEGMENT)))
+    {
+        snprintf(reply, cap, "ERR container or segment image: decode it with the command line");
+        if (image.data) munmap(image.data, image.size);
+        if (in.path && image.fd >= 0) close(image.fd);
+        return e_failure;
+    }
+    unsigned char *buf = NULL;
+    if (ret == e_success && !(buf = malloc(info.original_size ? info.original_size : 1))) ret = e_failure;
+    if (ret == e_success)
+        ret = stego_decode(image.data, image.size, buf, info.original_size, passphrase, &info);
+
+    if (ret != e_success)
+        snprintf(reply, cap, "ERR %s", stego_strerror(ret));
+    else if ((ret = write_operand(&out, info.extn, buf, info.original_size)) != e_success)
+        snprintf(reply, cap, "ERR cannot write output");
+    else
+        snprintf(reply, cap, "OK decoded %" PRId64 " bytes extn=%s", info.original_size, info.extn);
+
+    free(buf);
+    if (image.data) munmap(image.data, image.size);
+    if (in.path && image.fd >= 0) close(image.fd);
+    return ret;
+}
+
+static Status do_probe(const DaemonJob *job, char *ops[], char *reply, size_t cap)
+{
+    Operand in;
+    MappedFile image;
+    StegoInfo info;
+
+    if (resolve(job, ops[0], &in) != e_success || map_operand(&in, &image) != e_success)
+    {
+        snprintf(reply, cap, "ERR cannot map image");
+        return e_failure;
+    }
+    Status ret = stego_probe(image.data, image.size, &info);   // touches the header pages only
+    if (ret == e_success)
+        snprintf(reply, cap, "OK stego extn=%s size=%" PRId64 " original_size=%" PRId64 " depth=%d flags=0x%02x",
+                 info.extn, info.size, info.original_size, info.depth, info.flags);
+    else if (ret == e_no_secret)
+        snprintf(reply, cap, "OK clean");
+    else
+        snprintf(reply, cap, "ERR %s", stego_strerror(ret));
+
+    if (image.data) munmap(image.data, image.size);
+    if (in.path && image.fd >= 0) close(image.fd);
+    return (ret == e_success || ret == e_no_secret) ? e_success : e_failure;
+}
+
+/* Whole decimal number in [lo, hi]; same ranges as the command line */
+static Status parse_count(const char *val, int lo, int hi, int *out)
+{
+    char *end;
+    long n = strtol(val, &end, 10);
+
+    if (end == val || *end != '\0' || n < lo || n > hi) return e_failure;
+    *out = (int)n;
+    return e_success;
+}
+
+/* Split a request into at most max tokens, -1 if there are more. A message
+   holding a NUL is NUL separated, so names may contain spaces; otherwise it
+   is a hand-written line split on whitespace. */
+static int split_request(DaemonJob *job, char *toks[], int max)
+{
+    char *save = NULL;
+    int n = 0;
+
+    if (memchr(job->line, '\0', job->len))
+    {
+        for (size_t i = 0; i < job->len; i += strlen(job->line + i) + 1)
+        {
+            if (!job->line[i]) continue;
+            if (n == max) return -1;
+            toks[n++] = job->line + i;
+        }
+        return n;
+    }
+    for (char *tok = strtok_r(job->line, " \t\r\n", &save); tok; tok = strtok_r(NULL, " \t\r\n", &save))
+    {
+        if (n == max) return -1;
+        toks[n++] = tok;
+    }
+    return n;
+}
+
+/* Parse the request line, run it, write the reply text (without the number) */
+static Status run_job(Daemon *d, DaemonJob *job, char *reply, size_t cap)
+{
+    const DaemonOptions *defaults = d->opts;
+    char *ops[4] = { 0 }, *op = NULL, *toks[DAEMON_TOKENS_MAX];
+    const char *extn = NULL, *passphrase = defaults->passphrase;
+    int nops = 0, depth = defaults->depth, compress = defaults->compress, crc = defaults->crc;
+    int scatter = defaults->scatter, ecc = defaults->ecc;
+
+    int ntoks = split_request(job, toks, DAEMON_TOKENS_MAX);
+    if (ntoks < 0)
+    {
+        snprintf(reply, cap, "ERR too many arguments");
+        return e_failure;
+    }
+    for (int t = 0; t < ntoks; t++)
+    {
+        char *tok = toks[t];
+        if (!op)
+            op = tok;
+        else if (!strncmp(tok, "--depth=", 8))
+        {
+            if (parse_count(tok + 8, 1, LSB_MAX_DEPTH, &depth) != e_success)
+            {
+                snprintf(reply, cap, "ERR bad --depth (1 to %d)", LSB_MAX_DEPTH);
+                return e_failure;
+            }
+        }
+        else if (!strcmp(tok, "--compress"))
+            compress = 1;
+        else if (!strcmp(tok, "--no-crc"))
+            crc = 0;
+        else if (!strcmp(tok, "--crc"))
+            crc = 1;
+        else if (!strncmp(tok, "--passphrase=", 13) && tok[13])
+            passphrase = tok + 13;           // the socket is 0600: only this user can send it
+        else if (!strcmp(tok, "--scatter"))
+            scatter = 1;
+        else if (!strncmp(tok, "--ecc=", 6))
+        {
+            if (parse_count(tok + 6, STEGO_ECC_MIN, STEGO_ECC_MAX, &ecc) != e_success)
+            {
+                snprintf(reply, cap, "ERR bad --ecc (%d to %d)", STEGO_ECC_MIN, STEGO_ECC_MAX);
+                return e_failure;
+            }
+        }
+        else if (!strncmp(tok, "--extn=", 7))
+        {
+            if (!stego_extn_supported(tok + 7))
+            {
+                snprintf(reply, cap, "ERR bad --extn (.txt, .c, .h, .sh or empty)");
+                return e_failure;
+            }
+            extn = tok + 7;
+        }
+        else if (tok[0] == '-' && tok[1] == '-')
+        {
+            snprintf(reply, cap, "ERR unknown option %s", tok);
+            return e_failure;
+        }
+        else if (nops < 3)
+            ops[nops++] = tok;
+        else
+        {
+            snprintf(reply, cap, "ERR too many arguments");
+            return e_failure;
+        }
+    }
+
+    if (op && !strcmp(op, "-e") && nops == 3)
+    {
+        StegoOptions opts = { .depth = depth };
+        if (compress) opts.flags |= STEGO_FLAG_LZ;
+        if (crc) opts.flags |= STEGO_FLAG_CRC;
+        if (scatter) opts.flags |= STEGO_FLAG_SCATTER;
+        if (ecc) opts.flags |= STEGO_FLAG_RS;
+        opts.ecc = ecc;
+        if (passphrase)
+        {
+            opts.flags |= STEGO_FLAG_CHACHA;
+            opts.passphrase = passphrase;
+        }
+        return do_encode(d, job, ops, &opts, extn, reply, cap);
+    }
+    if (op && !strcmp(op, "-d") && nops == 2) return do_decode(job, ops, passphrase, reply, cap);
+    if (op && !strcmp(op, "-p") && nops == 1) return do_probe(job, ops, reply, cap);
+
+    snprintf(reply, cap, "ERR usage: -e <cover> <secret> <out> | -d <image> <out_base> | -p <image>");
+    return e_failure;
+}
+
+static void *worker_main(void *arg)
+{
+    Daemon *d = arg;
+    DaemonJob *job;
+    char reply[DAEMON_MSG_MAX];
+
+    while ((job = queue_pop(&d->queue)) != NULL)
+    {
+        int len = snprintf(reply, sizeof(reply), "%u ", job->seq);
+        if (run_job(d, job, reply + len, sizeof(reply) - len) != e_success)
+            atomic_fetch_add(&d->failed, 1);
+        atomic_fetch_add(&d->served, 1);
+
+        /* one message per reply: concurrent workers never interleave on a connection */
+        send(job->conn->fd, reply, strlen(reply), MSG_NOSIGNAL);
+        for (int i = 0; i < job->nfds; i++) close(job->fds[i]);
+        conn_release(job->conn);
+        free(job);
+    }
+    return NULL;
+}
+
+/* ===================== READER: ACCEPT, RECEIVE, QUEUE ===================== */
+static volatile sig_atomic_t daemon_stop;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    daemon_stop = 1;
+}
+
+/* Read one request of conn; e_failure once the client has gone */
+static Status receive_job(Daemon *d, DaemonConn *conn)
+{
+    DaemonJob *job = malloc(sizeof(*job));
+    union { char buf[CMSG_SPACE(sizeof(int) * DAEMON_FDS_MAX)]; struct cmsghdr align; } control;
+    struct iovec iov;
+    struct msghdr msg = { 0 };
+
+    if (!job) return e_failure;
+    iov.iov_base = job->line;
+    iov.iov_len = DAEMON_MSG_MAX;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t n = recvmsg(conn->fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    if (n <= 0)
+    {
+        free(job);
+        return (n < 0 && (errno == EAGAIN || errno == EINTR)) ? e_success : e_failure;
+    }
+    job->line[n] = '\0';
+    job->len = n;
+    job->nfds = 0;
+    for (struct cmsghdr *c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c))
+    {
+        if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS) continue;
+        int count = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        int *fds = (int *)CMSG_DATA(c);
+        for (int i = 0; i < count; i++)
+        {
+            if (job->nfds < DAEMON_FDS_MAX) job->fds[job->nfds++] = fds[i];
+            else close(fds[i]);
+        }
+    }
+
+    job->conn = conn;
+    job->seq = ++conn->seq;
+    if (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC))
+    {
+        char reply[64];
+        snprintf(reply, sizeof(reply), "%u ERR request too long", job->seq);
+        send(conn->fd, reply, strlen(reply), MSG_NOSIGNAL);
+        for (int i = 0; i < job->nfds; i++) close(job->fds[i]);
+        free(job);
+        return e_success;
+    }
+    atomic_fetch_add(&conn->refs, 1);
+    queue_push(&d->queue, job);
+    return e_success;
+}
+
+/* -1 on failure, -2 if a daemon already answers on path; bound gets the
+   socket file made here, so exit only removes that one */
+static int listen_on(const char *path, struct stat *bound)
+{
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    struct stat st;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+    strcpy(addr.sun_path, path);
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+    {
+        int probe = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        int live = probe >= 0 && connect(probe, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+        if (probe >= 0) close(probe);
+        if (live) return -2;
+        unlink(path);                            // left over from a killed daemon
+    }
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    mode_t mask = umask(077);                    // only this user may send requests
+    int ok = bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0 && listen(fd, 128) == 0 &&
+             lstat(path, bound) == 0;
+    umask(mask);
+    if (!ok)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Remove the socket file, unless another daemon has since put its own there */
+static void unlink_own(const char *path, const struct stat *bound)
+{
+    struct stat st;
+
+    if (lstat(path, &st) == 0 && st.st_dev == bound->st_dev && st.st_ino == bound->st_ino)
+        unlink(path);
+}
+
+/* ===================== -D: SERVE ===================== */
+Status run_daemon(const char *socket_path, const DaemonOptions *opts)
+{
+    Daemon d = { .opts = opts };
+    int workers = opts->workers > 0 ? opts->workers : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    DaemonConn *conns[DAEMON_CONNS_MAX];
+    struct pollfd pfds[DAEMON_CONNS_MAX + 1];
+    int nconns = 0;
+
+    struct stat bound;
+    int listen_fd = listen_on(socket_path, &bound);
+    if (listen_fd < 0)
+    {
+        if (listen_fd == -2)
+            fprintf(stderr, "[ERROR] A daemon is already running on %s\n", socket_path);
+        else
+            fprintf(stderr, "[ERROR] Cannot listen on %s\n", socket_path);
+        return e_failure;
+    }
+
+    struct sigaction sa = { .sa_handler = on_signal };
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    cover_cache_init(&d.cache, opts->cache_bytes > 0 ? opts->cache_bytes : DAEMON_CACHE_DEFAULT);
+    d.queue.cap = workers * DAEMON_QUEUE_PER_WORKER;
+    d.queue.ring = malloc(d.queue.cap * sizeof(*d.queue.ring));
+    pthread_mutex_init(&d.queue.lock, NULL);
+    pthread_cond_init(&d.queue.not_empty, NULL);
+    pthread_cond_init(&d.queue.not_full, NULL);
+    atomic_init(&d.served, 0);
+    atomic_init(&d.failed, 0);
+
+    pthread_t tid[workers];
+    int started = 0;
+    while (d.queue.ring && started < workers && pthread_create(&tid[started], NULL, worker_main, &d) == 0)
+        started++;
+    if (started == 0)
+    {
+        fprintf(stderr, "[ERROR] Cannot start worker threads\n");
+        close(listen_fd);
+        unlink_own(socket_path, &bound);
+        free(d.queue.ring);
+        return e_failure;
+    }
+    if (!console_quiet)
+        fprintf(stderr, "[INFO] Daemon on %s: %d worker(s), queue of %d, cover cache %" PRId64 " MB\n",
+                socket_path, started, d.queue.cap, d.cache.budget >> 20);
+
+    while (!daemon_stop)
+    {
+        pfds[0] = (struct pollfd){ .fd = listen_fd, .events = POLLIN };
+        for (int i = 0; i < nconns; i++) pfds[i + 1] = (struct pollfd){ .fd = conns[i]->fd, .events = POLLIN };
+
+        if (poll(pfds, nconns + 1, 500) <= 0) continue;    // timeout or a signal: check daemon_stop
+
+        for (int i = nconns - 1; i >= 0; i--)
+        {
+            if (!pfds[i + 1].revents) continue;
+            if (receive_job(&d, conns[i]) != e_success)
+            {
+                conn_release(conns[i]);         // replies still queued keep it open
+                conns[i] = conns[--nconns];
+            }
+        }
+        if (pfds[0].revents & POLLIN)
+        {
+            int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+            DaemonConn *conn = (fd >= 0 && nconns < DAEMON_CONNS_MAX) ? malloc(sizeof(*conn)) : NULL;
+            if (conn)
+            {
+                conn->fd = fd;
+                conn->seq = 0;
+                atomic_init(&conn->refs, 1);
+                conns[nconns++] = conn;
+            }
+            else if (fd >= 0)
+            {
+                close(fd);                      // too many clients
+            }
+        }
+    }
+
+    /* stop taking requests, finish the queued ones */
+    close(listen_fd);
+    unlink_own(socket_path, &bound);
+    pthread_mutex_lock(&d.queue.lock);
+    d.queue.closing = 1;
+    pthread_cond_broadcast(&d.queue.not_empty);
+    pthread_mutex_unlock(&d.queue.lock);
+    for (int i = 0; i < started; i++) pthread_join(tid[i], NULL);
+    for (int i = 0; i < nconns; i++) conn_release(conns[i]);
+
+    if (!console_quiet)
+        fprintf(stderr, "[INFO] Daemon stopped: %ld request(s), %ld failed, cover cache %" PRId64
+                " hit(s) / %" PRId64 " miss(es)\n",
+                atomic_load(&d.served), atomic_load(&d.failed), d.cache.hits, d.cache.misses);
+
+    cover_cache_destroy(&d.cache);
+    pthread_mutex_destroy(&d.queue.lock);
+    pthread_cond_destroy(&d.queue.not_empty);
+    pthread_cond_destroy(&d.queue.not_full);
+    free(d.queue.ring);
+    return e_success;
+}
+
+/* ===================== -C: ONE REQUEST FROM THE COMMAND LINE ===================== */
+/* Append one NUL-terminated argument; *len > DAEMON_MSG_MAX once it no longer fits */
+static void put_arg(char *request, size_t *len, const char *fmt, ...)
+{
+    va_list ap;
+
+    if (*len > DAEMON_MSG_MAX) return;
+    va_start(ap, fmt);
+    *len += vsnprintf(request + *len, DAEMON_MSG_MAX - *len, fmt, ap) + 1;
+    va_end(ap);
+}
+
+Status run_client(const char *socket_path, char *args[], int count, const DaemonOptions *opts)
+{
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    char request[DAEMON_MSG_MAX], reply[DAEMON_MSG_MAX + 1], cwd[DAEMON_MSG_MAX];
+    size_t len = 0;
+
+    if (strlen(socket_path) >= sizeof(addr.sun_path) || !getcwd(cwd, sizeof(cwd)))
+        return e_failure;
+    strcpy(addr.sun_path, socket_path);
+
+    /* NUL separated, so names keep their spaces; the daemon has its own
+       working directory, so names are sent absolute */
+    put_arg(request, &len, "%s", args[0]);
+    for (int i = 1; i < count; i++)
+        put_arg(request, &len, args[i][0] == '/' ? "%s" : "%s/%s", args[i][0] == '/' ? args[i] : cwd, args[i]);
+    if (opts->depth > 0) put_arg(request, &len, "--depth=%d", opts->depth);
+    if (opts->compress) put_arg(request, &len, "--compress");
+    if (opts->crc >= 0) put_arg(request, &len, opts->crc ? "--crc" : "--no-crc");
+    if (opts->scatter) put_arg(request, &len, "--scatter");
+    if (opts->ecc) put_arg(request, &len, "--ecc=%d", opts->ecc);
+    if (opts->passphrase) put_arg(request, &len, "--passphrase=%s", opts->passphrase);
+    if (len > sizeof(request))
+    {
+        fprintf(stderr, "[ERROR] Request too long\n");
+        return e_failure;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        fprintf(stderr, "[ERROR] No daemon on %s\n", socket_path);
+        if (fd >= 0) close(fd);
+        return e_failure;
+    }
+    ssize_t n = -1;
+    if (send(fd, request, len, MSG_NOSIGNAL) == (ssize_t)len) n = recv(fd, reply, DAEMON_MSG_MAX, 0);
+    close(fd);
+    if (n <= 0)
+    {
+        fprintf(stderr, "[ERROR] No reply from %s\n", socket_path);
+        return e_failure;
+    }
+    reply[n] = '\0';
+    printf("%s\n", reply);
+
+    const char *status = strchr(reply, ' ');
+    return (status && !strncmp(status + 1, "OK", 2)) ? e_success : e_failure;
+}
@@ -0,0 +1,59 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <stdint.h>
+#include "types.h"
+
+/*----------------------------------------------------------
+    Daemon: one long-running process serving many requests
+
+    -D listens on a Unix domain socket (SOCK_SEQPACKET, mode 0600).
+    Every message is one request, written like a command line with
+    each argument NUL-terminated (a message without a NUL is split on
+    whitespace instead, for hand-written requests):
+        -e <cover> <secret> <output.bmp> [--depth=N] [--compress] [--crc | --no-crc] [--scatter]
+           [--ecc=N] [--extn=.txt] [--passphrase=TEXT]
+        -d <image> <output_basename> [--passphrase=TEXT]
+        -p <image>
+    File names are absolute paths, or @k for the k-th descriptor sent
+    with the message (SCM_RIGHTS, e.g. memfds). The reply is one message
+    "<n> OK <details>" or "<n> ERR <reason>", n counting the requests of
+    that connection from 1, so clients can keep several in flight.
+
+    One thread polls the socket and feeds a bounded queue; -j workers
+    run the jobs on the in-memory library (stego.h). When the queue is
+    full the reader stops reading, so clients block in send instead of
+    the daemon buffering without limit. Covers named by path stay mapped
+    in an LRU (covercache.h) between requests.
+----------------------------------------------------------*/
+
+#define DAEMON_MSG_MAX 4096                 // longest request or reply
+#define DAEMON_FDS_MAX 4                    // descriptors per request
+#define DAEMON_TOKENS_MAX 16                // operation, names and options per request
+#define DAEMON_CONNS_MAX 1024               // clients connected at once
+#define DAEMON_QUEUE_PER_WORKER 4           // queued jobs per worker before backpressure
+#define DAEMON_CACHE_DEFAULT (256LL << 20)  // cover cache budget without --cache-mb
+
+/* Defaults for every request (-D); a zeroed struct is depth 1, CRC off.
+   For -C, the options the user gave, sent with the request. */
+typedef struct _DaemonOptions
+{
+    int workers;                    // -j: worker threads (< 1: one per CPU)
+    int64_t cache_bytes;            // --cache-mb: cover cache budget (0: default)
+    int depth;                      // --depth N (-C: 0 = not sent)
+    int compress;                   // --compress
+    int crc;                        // store a CRC32C (off with --no-crc; -C: -1 = not sent)
+    int scatter;                    // --scatter: data blocks in keyed random slots
+    int ecc;                        // --ecc N: Reed-Solomon parity bytes per codeword (0 = none)
+    const char *passphrase;         // --passphrase-file: encrypt / decrypt (-C: sent over the 0600 socket)
+} DaemonOptions;
+
+/* Serve requests on socket_path until SIGINT / SIGTERM */
+Status run_daemon(const char *socket_path, const DaemonOptions *opts);
+
+/* Send one request (args[0] is -e, -d or -p, then the file names, made
+   absolute here) with the request options of opts, print the reply on
+   stdout. e_success if the daemon answered OK. */
+Status run_client(const char *socket_path, char *args[], int count, const DaemonOptions *opts);
+
+#endif // DAEMON_H
@@ -1,236 +1,584 @@
-#define _XOPEN_SOURCE 700
-#include <unistd.h>
-#include <stdio.h>
-#include <string.h>
-#include <stdlib.h>
-#include <time.h>           // for nanosleep
-#include "decode.h"
-#include "types.h"
-#include "common.h"
-
-/* small portable delay */
-static void delay_ms(int milliseconds)
-{
-    struct timespec ts;
-    ts.tv_sec = milliseconds / 1000;
-    ts.tv_nsec = (milliseconds % 1000) * 1000000L;
-    nanosleep(&ts, NULL);
-}
-
-/* Color codes */
-#define GREEN  "\033[0;32m"
-#define GRAY   "\033[0;90m"
-#define RESET  "\033[0m"
-
-/* ========================= INPUT VALIDATION ========================= */
-Status read_and_validate_decode_args(char *argv[], DecodeInfo *decInfo)
-{
-    if (strstr(argv[2], ".bmp") != NULL)
-        decInfo->out_image_fname = argv[2];
-    else
-    {
-        printf("✖️ Invalid input image. Must be .bmp\n");
-        return e_failure;
-    }
-
-    if (argv[3] == NULL)
-        decInfo->secret_fname = "decoded";
-    else
-    {
-        char *dot = strchr(argv[3], '.');
-        if (dot != NULL) *dot = '\0';
-        decInfo->secret_fname = argv[3];
-    }
-
-    return e_success;
-}
-
-/* ========================= OPEN ENCODED IMAGE ========================= */
-Status open_output_image_file(DecodeInfo *decInfo)
-{
-    decInfo->fptr_out_image = fopen(decInfo->out_image_fname, "rb");
-    if (decInfo->fptr_out_image == NULL)
-    {
-        printf("✖️ Cannot open encoded image: %s\n", decInfo->out_image_fname);
-        return e_failure;
-    }
-
-    fseek(decInfo->fptr_out_image, 54, SEEK_SET);
-    return e_success;
-}
-
-/* ========================= CREATE SECRET OUTPUT FILE ========================= */
-Status open_decoded_message_file(DecodeInfo *decInfo)
-{
-    int len = strlen(decInfo->secret_fname) + strlen(decInfo->extn_secret_file) + 1;
-    decInfo->secret_file_concat_name = malloc(len);
-
-    strcpy(decInfo->secret_file_concat_name, decInfo->secret_fname);
-    strcat(decInfo->secret_file_concat_name, decInfo->extn_secret_file);
-
-    decInfo->fptr_secret = fopen(decInfo->secret_file_concat_name, "wb");
-    if (decInfo->fptr_secret == NULL)
-    {
-        printf("✖️ Cannot create output secret file\n");
-        return e_failure;
-    }
-
-    return e_success;
-}
-
-/* ========================= BASIC DECODERS ========================= */
-Status decode_bit_from_lsb(char *ch, char *buffer)
-{
-    *ch = 0;
-    for (int i = 0; i < 8; i++)
-        *ch |= ((buffer[i] & 1) << i);
-    return e_success;
-}
-
-Status decode_int_from_lsb(int *num, char *buffer)
-{
-    *num = 0;
-    for (int i = 0; i < 32; i++)
-        *num |= ((buffer[i] & 1) << i);
-    return e_success;
-}
-
-/* ========================= MAGIC CHECK ========================= */
-Status decode_magic_string(const char *magic_string, DecodeInfo *decInfo)
-{
-    char buffer[8], ch;
-    char data[strlen(magic_string) + 1];
-
-    for (size_t i = 0; i < strlen(magic_string); i++)
-    {
-        if (fread(buffer, 8, 1, decInfo->fptr_out_image) != 1) return e_failure;
-        decode_bit_from_lsb(&ch, buffer);
-        data[i] = ch;
-    }
-    data[strlen(magic_string)] = '\0';
-
-    if (!strcmp(magic_string, data)) return e_success;
-    return e_failure;
-}
-
-/* ========================= EXTENSION SIZE ========================= */
-Status decode_secret_file_extn_size(DecodeInfo *decInfo)
-{
-    char buffer[32];
-    if (fread(buffer, 32, 1, decInfo->fptr_out_image) != 1) return e_failure;
-    decode_int_from_lsb(&decInfo->extension_size, buffer);
-    return e_success;
-}
-
-/* ========================= EXTENSION NAME ========================= */
-Status decode_secret_file_extn(DecodeInfo *decInfo)
-{
-    char buffer[8], ch;
-
-    for (int i = 0; i < decInfo->extension_size; i++)
-    {
-        if (fread(buffer, 8, 1, decInfo->fptr_out_image) != 1) return e_failure;
-        decode_bit_from_lsb(&ch, buffer);
-        decInfo->extn_secret_file[i] = ch;
-    }
-
-    decInfo->extn_secret_file[decInfo->extension_size] = '\0';
-    return e_success;
-}
-
-/* ========================= FILE SIZE ========================= */
-Status decode_secret_file_size(DecodeInfo *decInfo)
-{
-    char buffer[32];
-    int temp_size = 0;
-    if (fread(buffer, 32, 1, decInfo->fptr_out_image) != 1) return e_failure;
-    decode_int_from_lsb(&temp_size, buffer);
-    decInfo->size_secret_file = (long)temp_size;
-    return e_success;
-}
-
-/* ===================== PROGRESS BAR (Decoding) ===================== */
-void show_progress_decode(long done, long total)
-{
-    int barWidth = 50;
-    float progress = (total > 0) ? ((float)done / total) : 0.0f;
-    int fill = (int)(progress * barWidth);
-
-    printf("\r[");
-    for(int i = 0; i < barWidth; i++)
-        printf(i < fill ? GREEN "■" RESET : GRAY "□" RESET);
-
-    printf("] %3d%%", (int)(progress * 100));
-    fflush(stdout);
-}
-
-/* ========================= SECRET DATA DECODE ========================= */
-Status decode_secret_file_data(DecodeInfo *decInfo)
-{
-    char buffer[8], ch;
-    long done = 0;
-
-    printf("\n⚙️  Extracting Secret Data...\n");
-
-    for (int i = 0; i < decInfo->size_secret_file; i++)
-    {
-        if (fread(buffer, 8, 1, decInfo->fptr_out_image) != 1)
-        {
-            printf("\n[ERROR] Unexpected EOF while reading encoded data.\n");
-            return e_failure;
-        }
-        decode_bit_from_lsb(&ch, buffer);
-        fwrite(&ch, 1, 1, decInfo->fptr_secret);
-
-        done++;
-        show_progress_decode(done, decInfo->size_secret_file);
-        delay_ms(200);
-    }
-
-    printf("\n" GREEN "✔ Secret Data Extracted Successfully!" RESET "\n");
-    return e_success;
-}
-
-/* ========================= MAIN DECODING PROCESS ========================= */
-Status do_decoding(DecodeInfo *decInfo)
-{
-    printf("\n───────────────────────────────────────────────\n");
-    printf("🕵️  STEGANOGRAPHY TOOL - DECODING STARTED\n");
-    printf("───────────────────────────────────────────────\n");
-    printf("📁 Input Image : %s\n\n", decInfo->out_image_fname);
-
-    printf("🔍 Steps:\n");
-
-    printf("\n   1️⃣  Opening encoded image ............ ");
-    if (open_output_image_file(decInfo) != e_success) { printf("✖️\n"); return e_failure; }
-    printf("✔️\n");
-
-    printf("   2️⃣  Checking magic signature (#*) .... ");
-    if (decode_magic_string(MAGIC_STRING, decInfo) != e_success) { printf("✖️ Invalid!\n"); return e_failure; }
-    printf("✔️  Valid\n");
-
-    printf("   3️⃣  Reading extension size .......... ");
-    decode_secret_file_extn_size(decInfo);
-    printf("✔️  (%d)\n", decInfo->extension_size);
-
-    printf("   4️⃣  Reading extension ............... ");
-    decode_secret_file_extn(decInfo);
-    printf("✔️  (%s)\n", decInfo->extn_secret_file);
-
-    printf("   5️⃣  Creating output file ............ ");
-    open_decoded_message_file(decInfo);
-    printf("✔️  (%s)\n", decInfo->secret_file_concat_name);
-
-    printf("   6️⃣  Reading file size ............... ");
-    decode_secret_file_size(decInfo);
-    printf("✔️  (%ld bytes)\n", decInfo->size_secret_file);
-
-    printf("   7️⃣  Extracting secret data .......... ⏳\n");
-    decode_secret_file_data(decInfo);
-
-    printf("\n🎯 STATUS: SUCCESS — Secret restored!\n");
-    printf("📌 Extracted File: %s\n", decInfo->secret_file_concat_name);
-    printf("───────────────────────────────────────────────\n\n");
-
-    return e_success;
-}
+#define _XOPEN_SOURCE 700
+#define _FILE_OFFSET_BITS 64 // fseeko / pread past 2 GB
+#include <unistd.h>
+#include <inttypes.h>   // PRId64
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include "decode.h"
+#include "types.h"
+#include "common.h"
+#include "console.h"        // cprintf (silent in batch workers)
+#include "stego.h"          // header parsing + extraction, no file handling
+#include "lsb.h"            // LSB_BLOCK_SIZE
+#include "stream.h"         // stdin / stdout streaming helpers
+#include "fileio.h"         // pread / pwrite helpers
+#include "pool.h"           // parallel_for over payload ranges
+#include "progress.h"       // byte counter + background reporter
+#include "lz.h"             // streaming unpacker for LZ packed secrets
+#include "crc32c.h"         // checksum of the data, verified while extracting
+#include "cipher.h"         // kernel name for the unlock step
+#include "archive.h"        // images that hold a multi-file container
+#include "stats.h"          // --stats phase timings and I/O counts
+
+/* Color codes */
+#define GREEN  "\033[0;32m"
+#define RESET  "\033[0m"
+
+#define CRC_ERROR "Secret data failed its CRC32C check: the image is corrupt or truncated."
+#define ECC_ERROR "Secret data is damaged beyond what its ECC parity can repair."
+
+/* ========================= INPUT VALIDATION ========================= */
+Status read_and_validate_decode_args(char *argv[], DecodeInfo *decInfo)
+{
+    if (strstr(argv[2], ".bmp") != NULL || !strcmp(argv[2], STREAM_NAME))
+        decInfo->out_image_fname = argv[2];
+    else
+    {
+        cprintf("✖️ Invalid input image. Must be .bmp\n");
+        return e_failure;
+    }
+
+    if (argv[3] == NULL)
+        decInfo->secret_fname = "decoded";
+    else
+    {
+        char *dot = strchr(argv[3], '.');
+        if (dot != NULL) *dot = '\0';
+        decInfo->secret_fname = argv[3];
+    }
+
+    return e_success;
+}
+
+/* ========================= SKIP FORWARD IN THE IMAGE ========================= */
+/* stdin cannot seek, so read past the bytes there */
+static Status skip_image_bytes(FILE *fp, int64_t gap, StegoStats *stats)
+{
+    char buffer[4096];
+
+    if (gap <= 0 || fseeko(fp, (off_t)gap, SEEK_CUR) == 0) return e_success;
+    while (gap > 0)
+    {
+        size_t n = (gap > (int64_t)sizeof(buffer)) ? sizeof(buffer) : (size_t)gap;
+        if (fread(buffer, 1, n, fp) != n) return e_failure;
+        stats_read(stats, n, 1);
+        gap -= n;
+    }
+    return e_success;
+}
+
+/* ========================= READ ON PAST THE HIDDEN HEADER ========================= */
+/* Bytes the header search already read past data_offset come first: a pipe cannot seek back */
+static size_t read_image(DecodeInfo *decInfo, unsigned char *buf, size_t n)
+{
+    size_t kept = decInfo->carry_len - decInfo->carry_pos;
+
+    if (kept > n) kept = n;
+    memcpy(buf, decInfo->carry + decInfo->carry_pos, kept);
+    decInfo->carry_pos += kept;
+    return kept + (n > kept ? fread(buf + kept, 1, n - kept, decInfo->fptr_out_image) : 0);
+}
+
+static Status skip_data_bytes(DecodeInfo *decInfo, int64_t gap)
+{
+    int64_t kept = decInfo->carry_len - decInfo->carry_pos;
+
+    if (kept > gap) kept = gap;
+    decInfo->carry_pos += kept;
+    return skip_image_bytes(decInfo->fptr_out_image, gap - kept, decInfo->stats);
+}
+
+/* ========================= OPEN ENCODED IMAGE ========================= */
+Status open_output_image_file(DecodeInfo *decInfo)
+{
+    unsigned char header[STEGO_BMP_HEADER_MAX];
+    size_t header_len;
+    size_t image_len = STEGO_LEN_UNKNOWN;
+    struct stat st;
+
+    if (!strcmp(decInfo->out_image_fname, STREAM_NAME))
+        decInfo->fptr_out_image = stream_open_prefetch(STDIN_FILENO);
+    else
+        decInfo->fptr_out_image = fopen(decInfo->out_image_fname, "rb");
+    if (decInfo->fptr_out_image == NULL)
+    {
+        cprintf("✖️ Cannot open encoded image: %s\n", decInfo->out_image_fname);
+        return e_failure;
+    }
+
+    if (strcmp(decInfo->out_image_fname, STREAM_NAME) &&
+        fstat(fileno(decInfo->fptr_out_image), &st) == 0 && S_ISREG(st.st_mode))
+        image_len = st.st_size;
+
+    Status ret = read_bmp_header(decInfo->fptr_out_image, image_len, header, &header_len,
+                                 &decInfo->view);
+    stats_read(decInfo->stats, header_len, 1);
+    if (ret != e_success)
+    {
+        cprintf("✖️ %s\n", stego_strerror(ret));
+        return e_failure;
+    }
+
+    /* move to the first pixel */
+    if (skip_image_bytes(decInfo->fptr_out_image, decInfo->view.offset - header_len,
+                         decInfo->stats) != e_success)
+    {
+        cprintf("✖️ %s\n", stego_strerror(e_bad_image));
+        return e_failure;
+    }
+    return e_success;
+}
+
+/* ========================= CREATE SECRET OUTPUT FILE ========================= */
+Status open_decoded_message_file(DecodeInfo *decInfo)
+{
+    if (!strcmp(decInfo->secret_fname, STREAM_NAME))
+    {
+        /* stdout was claimed in do_decoding, before anything was printed */
+        decInfo->secret_file_concat_name = strdup("(stdout)");
+        return decInfo->fptr_secret ? e_success : e_failure;
+    }
+
+    int len = strlen(decInfo->secret_fname) + strlen(decInfo->extn_secret_file) + 1;
+    decInfo->secret_file_concat_name = malloc(len);
+
+    strcpy(decInfo->secret_file_concat_name, decInfo->secret_fname);
+    strcat(decInfo->secret_file_concat_name, decInfo->extn_secret_file);
+
+    decInfo->fptr_secret = fopen(decInfo->secret_file_concat_name, "wb");
+    if (decInfo->fptr_secret == NULL)
+    {
+        cprintf("✖️ Cannot create output secret file\n");
+        return e_failure;
+    }
+
+    return e_success;
+}
+
+/* ========================= MAGIC, EXTENSION AND SIZE ========================= */
+Status decode_stego_header(DecodeInfo *decInfo)
+{
+    unsigned char region[STEGO_HEADER_MAX];
+    size_t have = 0, need;
+    Status ret;
+
+    /* read only as far as the header says it goes, so pipes need no seeking */
+    while ((ret = stego_read_header(&decInfo->view, region, have, &decInfo->stego, &need)) == e_short_buffer)
+    {
+        if (fread(region + have, 1, need - have, decInfo->fptr_out_image) != need - have)
+            return e_bad_image;
+        stats_read(decInfo->stats, need - have, 1);
+        have = need;
+    }
+    if (ret != e_success) return ret;
+
+    /* a repaired Reed-Solomon header may have been found past the bytes it
+       spans: those are kept for the data loop instead of seeking back */
+    int64_t used = decInfo->stego.data_offset - decInfo->view.offset;
+    decInfo->carry_len = decInfo->carry_pos = 0;
+    if ((int64_t)have > used)
+    {
+        decInfo->carry_len = have - used;
+        memcpy(decInfo->carry, region + used, decInfo->carry_len);
+    }
+
+    decInfo->extension_size = decInfo->stego.extn_len;
+    strcpy(decInfo->extn_secret_file, decInfo->stego.extn);
+    decInfo->size_secret_file = decInfo->stego.size;
+    return e_success;
+}
+
+/* ========================= ONE THREAD'S SLICE OF THE SECRET DATA ========================= */
+typedef struct
+{
+    int image_fd;                 // encoded image, read with pread
+    int secret_fd;                // decoded secret, written with pwrite
+    const StegoInfo *stego;       // layout read from the hidden header
+    int64_t first;                // secret byte written at output offset 0 (--offset)
+    Progress *progress;           // shared byte counter
+    uint32_t *crcs;               // CRC32C of each POOL_GRAIN slice, joined afterwards
+    StegoStats *stats;            // --stats counters (NULL = off)
+    atomic_int damaged;           // a block was beyond ECC repair
+} ExtractRangeCtx;
+
+/* Secret byte k always sits at stego_data_pos(k), so slices are independent */
+static Status extract_range(void *arg, int64_t begin, int64_t end)
+{
+    ExtractRangeCtx *ctx = arg;
+    unsigned char image[STEGO_BLOCK_SPAN];
+    unsigned char secret[LSB_BLOCK_SIZE];
+    uint32_t crc = 0;
+    int64_t moved = 0, calls = 0;   // added to the shared counters once per slice
+    size_t n;
+
+    for (int64_t k = begin; k < end; k += n)
+    {
+        n = stego_data_run(ctx->stego, ctx->first + k,
+                           (end - k > LSB_BLOCK_SIZE) ? LSB_BLOCK_SIZE : (size_t)(end - k));
+        size_t span = stego_data_span(ctx->stego, ctx->first + k, n);
+
+        if (read_all_at(ctx->image_fd, image, span, stego_data_pos(ctx->stego, ctx->first + k)) != e_success)
+            return e_failure;
+        moved += span;
+        calls++;
+        if (stego_extract_data(ctx->stego, ctx->first + k, image, n, secret) != e_success)
+        {
+            atomic_store(&ctx->damaged, 1);
+            return e_failure;
+        }
+        if (ctx->crcs) crc = crc32c(crc, secret, n);
+        if (write_all_at(ctx->secret_fd, secret, n, k) != e_success) return e_failure;
+        progress_add(ctx->progress, n);
+    }
+    stats_read(ctx->stats, moved, calls);
+    stats_write(ctx->stats, end - begin, calls);
+    if (ctx->crcs) ctx->crcs[begin / POOL_GRAIN] = crc;
+    return e_success;
+}
+
+/* ========================= SECRET DATA DECODE (N threads) ========================= */
+/* Extracts data bytes [first, first + total); the CRC is only checked on the whole secret */
+static Status decode_secret_file_data_parallel(DecodeInfo *decInfo, Progress *progress,
+                                               int64_t first, int64_t total)
+{
+    ExtractRangeCtx ctx;
+
+    fflush(decInfo->fptr_secret);
+    ctx.image_fd = fileno(decInfo->fptr_out_image);
+    ctx.secret_fd = fileno(decInfo->fptr_secret);
+    ctx.stego = &decInfo->stego;
+    ctx.first = first;
+    ctx.progress = progress;
+    ctx.crcs = NULL;
+    ctx.stats = decInfo->stats;
+    atomic_init(&ctx.damaged, 0);
+
+    Status ret = e_success;
+    if ((decInfo->stego.flags & STEGO_FLAG_CRC) && total == decInfo->size_secret_file)
+    {
+        ctx.crcs = malloc(((total + POOL_GRAIN - 1) / POOL_GRAIN + 1) * sizeof(*ctx.crcs));
+        if (!ctx.crcs) ret = e_failure;
+    }
+    if (ret == e_success)
+        ret = parallel_for(decInfo->threads, total, POOL_GRAIN, extract_range, &ctx);
+    progress_finish(progress);
+    stats_data(decInfo->stats, atomic_load(&progress->done));
+    if (ret == e_success && ctx.crcs)
+    {
+        unsigned char trailer[STEGO_CRC_SPAN];
+        const StegoInfo *stego = &decInfo->stego;
+        if (read_all_at(ctx.image_fd, trailer, stego->end_offset - stego->crc_offset,
+                        stego->crc_offset) != e_success)
+            ret = e_failure;
+        else if (stego_extract_crc(stego, trailer) !=
+                 crc32c_join(ctx.crcs, decInfo->size_secret_file, POOL_GRAIN))
+            ret = e_bad_crc;
+        if (ret != e_failure) stats_read(decInfo->stats, stego->end_offset - stego->crc_offset, 1);
+    }
+    free(ctx.crcs);
+    if (ret != e_success)
+    {
+        cprintf("[ERROR] %s\n", ret == e_bad_crc ? CRC_ERROR : atomic_load(&ctx.damaged) ? ECC_ERROR
+                                 : "Unexpected EOF while reading encoded data.");
+        return e_failure;
+    }
+
+    cprintf(GREEN "✔ Secret Data Extracted Successfully!" RESET "\n");
+    return e_success;
+}
+
+/* ========================= UNPACKED BYTES GO STRAIGHT TO THE SECRET FILE ========================= */
+/* Only the --offset/--length window of the unpacked bytes is written */
+typedef struct
+{
+    FILE *fp;
+    int64_t skip;                 // unpacked bytes still to drop before the window
+    int64_t left;                 // window bytes still to write
+    StegoStats *stats;            // --stats counters (NULL = off)
+} SecretWindow;
+
+static Status write_secret(void *ctx, const unsigned char *data, size_t n)
+{
+    SecretWindow *w = ctx;
+    int64_t drop = (w->skip < (int64_t)n) ? w->skip : (int64_t)n;
+    int64_t take = (w->left < (int64_t)n - drop) ? w->left : (int64_t)n - drop;
+
+    w->skip -= drop;
+    w->left -= take;
+    if (take > 0) stats_write(w->stats, take, 1);
+    return fwrite(data + drop, 1, take, w->fp) == (size_t)take ? e_success : e_failure;
+}
+
+/* ========================= SECRET DATA DECODE ========================= */
+Status decode_secret_file_data(DecodeInfo *decInfo)
+{
+    unsigned char image[STEGO_BLOCK_SPAN];      // block of encoded image bytes
+    unsigned char secret[LSB_BLOCK_SIZE];       // decoded block
+    int64_t done = 0;
+    uint32_t crc = 0;                           // CRC32C of the data so far
+    const char *error = NULL;
+    Progress progress;
+    LzDecoder lz;
+    int packed = decInfo->stego.flags & STEGO_FLAG_LZ;
+    int scatter = decInfo->stego.flags & STEGO_FLAG_SCATTER;   // blocks out of order: seek to each
+
+    /* --offset/--length: byte k sits at a known image offset, so only the
+       window is read. Packed data unpacks front to back; there the window
+       applies to the unpacked bytes and decoding stops once it is written. */
+    int64_t original = decInfo->stego.original_size;
+    int64_t offset = decInfo->range_offset;
+    int64_t length = (decInfo->range_length <= 0 || decInfo->range_length > original - offset)
+                   ? original - offset : decInfo->range_length;
+    int whole = (offset == 0 && length == original);
+    int64_t first = packed ? 0 : offset;
+    int64_t total = packed ? decInfo->size_secret_file : length;
+    SecretWindow window = { decInfo->fptr_secret, offset, length, decInfo->stats };
+
+    cprintf("\n⚙️  Extracting Secret Data...\n");
+    if (packed && lz_decoder_init(&lz, decInfo->stego.original_size, write_secret,
+                                  &window) != e_success)
+    {
+        cprintf("[ERROR] Out of memory.\n");
+        return e_failure;
+    }
+    if (scatter) decInfo->carry_pos = decInfo->carry_len;   // every block is sought out instead
+    if (first > 0 && !scatter &&
+        skip_data_bytes(decInfo, stego_data_pos(&decInfo->stego, first) - decInfo->stego.data_offset)
+            != e_success)
+    {
+        cprintf("[ERROR] Unexpected EOF while reading encoded data.\n");
+        return e_failure;
+    }
+    progress_start(&progress, decInfo->progress, "decode", total);
+
+    /* pread/pwrite need real files on both sides; packed data only unpacks front to back */
+    if (!packed && decInfo->threads > 1 && strcmp(decInfo->out_image_fname, STREAM_NAME) &&
+        strcmp(decInfo->secret_fname, STREAM_NAME))
+        return decode_secret_file_data_parallel(decInfo, &progress, first, total);
+
+    while (done < total && (whole || !packed || window.left > 0))
+    {
+        size_t n = total - done;
+        if (n > LSB_BLOCK_SIZE) n = LSB_BLOCK_SIZE;
+        n = stego_data_run(&decInfo->stego, first + done, n);
+        size_t span = stego_data_span(&decInfo->stego, first + done, n);
+
+        if (scatter && fseeko(decInfo->fptr_out_image, stego_data_pos(&decInfo->stego, first + done),
+                              SEEK_SET) != 0)
+        {
+            error = "Scattered data needs a seekable image, not a pipe.";
+            break;
+        }
+        if (read_image(decInfo, image, span) != span)
+        {
+            error = "Unexpected EOF while reading encoded data.";
+            break;
+        }
+        stats_read(decInfo->stats, span, 1);
+        if (stego_extract_data(&decInfo->stego, first + done, image, n, secret) != e_success)
+        {
+            error = ECC_ERROR;                                         // whole block in one pass
+            break;
+        }
+        crc = crc32c(crc, secret, n);                                  // checked at the end
+        Status ret = packed ? lz_decode(&lz, secret, n)                // unpacked as it arrives
+                   : fwrite(secret, 1, n, decInfo->fptr_secret) == n ? e_success : e_failure;
+        if (ret != e_success)
+        {
+            error = (ret == e_bad_data) ? "Packed secret data is corrupt."
+                                        : "Failed writing decoded secret file.";
+            break;
+        }
+        if (!packed) stats_write(decInfo->stats, n, 1);   // unpacked bytes are counted by write_secret
+
+        done += n;
+        progress_add(&progress, n);     // the reporter thread does the drawing
+    }
+
+    /* the checksum follows the data: no seeking (but for scatter), and nothing is read twice */
+    if (!error && whole && (decInfo->stego.flags & STEGO_FLAG_CRC))
+    {
+        size_t span = decInfo->stego.end_offset - decInfo->stego.crc_offset;
+        if (scatter && fseeko(decInfo->fptr_out_image, decInfo->stego.crc_offset, SEEK_SET) != 0)
+            error = "Scattered data needs a seekable image, not a pipe.";
+        else if (read_image(decInfo, image, span) != span)
+            error = "Unexpected EOF while reading encoded data.";
+        else
+        {
+            stats_read(decInfo->stats, span, 1);
+            if (stego_extract_crc(&decInfo->stego, image) != crc) error = CRC_ERROR;
+        }
+    }
+
+    if (packed)
+    {
+        /* a window that ends early never needs the rest flushed */
+        Status ret = (error || (!whole && window.left == 0)) ? e_success : lz_decoder_finish(&lz);
+        if (ret == e_success && !error && (whole ? lz.produced != original : window.left != 0))
+            ret = e_bad_data;
+        if (ret != e_success)
+            error = (ret == e_bad_data) ? "Packed secret data is corrupt."
+                                        : "Failed writing decoded secret file.";
+        lz_decoder_free(&lz);
+    }
+    progress_finish(&progress);
+    stats_data(decInfo->stats, done);
+    if (error)
+    {
+        cprintf("[ERROR] %s\n", error);
+        return e_failure;
+    }
+
+    cprintf(GREEN "✔ Secret Data Extracted Successfully!" RESET "\n");
+    return e_success;
+}
+
+/* ========================= CLOSE WHATEVER IS STILL OPEN ========================= */
+static void close_decode_files(DecodeInfo *decInfo)
+{
+    if (decInfo->fptr_out_image) fclose(decInfo->fptr_out_image);
+    if (decInfo->fptr_secret) fclose(decInfo->fptr_secret);
+    free(decInfo->secret_file_concat_name);
+    decInfo->fptr_out_image = NULL;
+    decInfo->fptr_secret = NULL;
+    decInfo->secret_file_concat_name = NULL;
+}
+
+static Status decode_steps(DecodeInfo *decInfo);
+
+/* ========================= MAIN DECODING PROCESS ========================= */
+Status do_decoding(DecodeInfo *decInfo)
+{
+    stats_begin(decInfo->stats, "decode");
+    stats_phase(decInfo->stats, e_phase_open);
+
+    /* Secret goes to stdout: keep it clean, banners move to stderr */
+    if (!strcmp(decInfo->secret_fname, STREAM_NAME))
+    {
+        decInfo->fptr_secret = stream_claim_stdout();
+        if (!decInfo->fptr_secret)
+        {
+            cprintf("✖️ Cannot use stdout for the decoded secret\n");
+            stats_end(decInfo->stats, 0);
+            return e_failure;
+        }
+    }
+
+    Status ret = decode_steps(decInfo);
+    stats_phase(decInfo->stats, e_phase_close);
+    close_decode_files(decInfo);    // every path, so long batch runs don't leak descriptors
+    stats_end(decInfo->stats, ret == e_success);
+    return ret;
+}
+
+/* ========================= DECODING STEPS ========================= */
+static Status decode_steps(DecodeInfo *decInfo)
+{
+    cprintf("\n───────────────────────────────────────────────\n");
+    cprintf("🕵️  STEGANOGRAPHY TOOL - DECODING STARTED\n");
+    cprintf("───────────────────────────────────────────────\n");
+    cprintf("📁 Input Image : %s\n\n", decInfo->out_image_fname);
+
+    cprintf("🔍 Steps:\n");
+
+    cprintf("\n   1️⃣  Opening encoded image ............ ");
+    if (open_output_image_file(decInfo) != e_success) { cprintf("✖️\n"); return e_failure; }
+    cprintf("✔️\n");
+
+    stats_phase(decInfo->stats, e_phase_fields);
+    cprintf("   2️⃣  Checking magic signature (#*) .... ");
+    Status ret = decode_stego_header(decInfo);
+    if (ret != e_success) { cprintf("✖️ Invalid! (%s)\n", stego_strerror(ret)); return e_failure; }
+    cprintf("✔️  Valid\n");
+
+    if (decInfo->stego.flags & STEGO_FLAG_CHACHA)
+    {
+        stats_phase(decInfo->stats, e_phase_unlock);
+        cprintf("   🔑 Deriving key from passphrase ..... ");
+        ret = stego_unlock(&decInfo->stego, decInfo->passphrase);
+        if (ret != e_success)
+        {
+            cprintf("✖️\n");
+            cprintf("\n🎯 STATUS: FAILED — The secret is encrypted: %s.\n", stego_strerror(ret));
+            cprintf("───────────────────────────────────────────────\n");
+            return e_failure;
+        }
+        cprintf("✔️  (ChaCha20, %s)\n", cipher_impl_name());
+    }
+
+    /* A container (-c) is a directory of files, not one secret */
+    if (decInfo->stego.flags & STEGO_FLAG_CONTAINER)
+    {
+        stats_phase(decInfo->stats, e_phase_data);
+        return decode_container(decInfo);
+    }
+    if (decInfo->stego.flags & STEGO_FLAG_SEGMENT)
+    {
+        cprintf("\n🎯 STATUS: FAILED — This image holds one segment of a spanned secret: decode the set with -m.\n");
+        cprintf("───────────────────────────────────────────────\n");
+        return e_failure;
+    }
+
+    cprintf("   3️⃣  Reading extension size .......... ");
+    cprintf("✔️  (%d)\n", decInfo->extension_size);
+
+    cprintf("   4️⃣  Reading extension ............... ");
+    cprintf("✔️  (%s)\n", decInfo->extn_secret_file);
+
+    /* checked against the header before the output file exists, so a bad range leaves nothing behind */
+    if (decInfo->range_offset > decInfo->stego.original_size)
+    {
+        cprintf("\n🎯 STATUS: FAILED — --offset is past the end of the secret.\n");
+        cprintf("───────────────────────────────────────────────\n");
+        return e_failure;
+    }
+
+    stats_phase(decInfo->stats, e_phase_open);
+    cprintf("   5️⃣  Creating output file ............ ");
+    if (open_decoded_message_file(decInfo) != e_success)
+    {
+        cprintf("\n🎯 STATUS: FAILED — Could not create the output file.\n");
+        cprintf("───────────────────────────────────────────────\n");
+        return e_failure;
+    }
+    cprintf("✔️  (%s)\n", decInfo->secret_file_concat_name);
+
+    cprintf("   6️⃣  Reading file size ............... ");
+    if (decInfo->stego.flags & STEGO_FLAG_LZ)
+        cprintf("✔️  (%" PRId64 " bytes, packed to %" PRId64 ")\n", decInfo->stego.original_size,
+                decInfo->size_secret_file);
+    else
+        cprintf("✔️  (%" PRId64 " bytes)\n", decInfo->size_secret_file);
+
+    if (decInfo->range_offset > 0 || decInfo->range_length > 0)
+    {
+        int64_t left = decInfo->stego.original_size - decInfo->range_offset;
+        cprintf("   ✂️  Selecting byte range ............ ✔️  (%" PRId64 " bytes from offset %" PRId64 ")\n",
+                (decInfo->range_length > 0 && decInfo->range_length < left) ? decInfo->range_length : left,
+                decInfo->range_offset);
+    }
+
+    stats_phase(decInfo->stats, e_phase_data);
+    cprintf("   7️⃣  Extracting secret data .......... ⏳\n");
+    if (decode_secret_file_data(decInfo) != e_success)
+    {
+        cprintf("\n🎯 STATUS: FAILED — Secret data is corrupt or incomplete.\n");
+        cprintf("───────────────────────────────────────────────\n");
+        return e_failure;
+    }
+
+    stats_phase(decInfo->stats, e_phase_close);
+    if (fflush(decInfo->fptr_secret) != 0)     // flushes a piped stdout too
+    {
+        cprintf("\n🎯 STATUS: FAILED — Could not write decoded secret.\n");
+        return e_failure;
+    }
+
+    cprintf("\n🎯 STATUS: SUCCESS — Secret restored!\n");
+    cprintf("📌 Extracted File: %s\n", decInfo->secret_file_concat_name);
+    cprintf("───────────────────────────────────────────────\n\n");
+
+    return e_success;
+}
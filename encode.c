@@ -1,82 +1,62 @@
 #define _XOPEN_SOURCE 700   // MUST be first line
+#define _FILE_OFFSET_BITS 64 // 64-bit off_t even on 32-bit hosts
 #include <unistd.h>
+#include <inttypes.h>   // PRId64
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
-#include <time.h>           // for nanosleep in delay()
+#include <fcntl.h>
+#include <sys/stat.h>
 #include "encode.h"
 #include "types.h"
 #include "common.h"
-
-/* ===================== small portable delay ===================== */
-static void delay_ms(int milliseconds)
-{
-    struct timespec ts;
-    ts.tv_sec = milliseconds / 1000;
-    ts.tv_nsec = (milliseconds % 1000) * 1000000L;
-    nanosleep(&ts, NULL);
-}
-
-/* ===================== COLOR CODES FOR PROGRESS BAR ===================== */
+#include "console.h"        // cprintf (silent in batch workers)
+#include "stego.h"          // layout + embedding, no file handling
+#include "lsb.h"            // LSB_BLOCK_SIZE
+#include "fileio.h"         // mmap + kernel side copy helpers
+#include "stream.h"         // stdin / stdout streaming helpers
+#include "pool.h"           // parallel_for over payload ranges
+#include "progress.h"       // byte counter + background reporter
+#include "lz.h"             // optional LZ stage for the secret
+#include "crc32c.h"         // checksum of the data, computed while embedding
+#include "stats.h"          // --stats phase timings and I/O counts
+
+/* ===================== COLOR CODES ===================== */
 #define GREEN  "\033[0;32m"
-#define GRAY   "\033[0;90m"
 #define RESET  "\033[0m"
 
-/* ===================== IMAGE SIZE FETCHING ===================== */
-uint get_image_size_for_bmp(FILE *fptr_image)
+/* ===================== OPEN ONE INPUT ("-" = stdin) ===================== */
+static FILE *open_input(const char *fname)
 {
-    uint width = 0, height = 0;          // store width and height of BMP image
-
-    if (!fptr_image) return 0;
-
-    fseek(fptr_image, 18, SEEK_SET);    // jump to header offset where width is stored
-    fread(&width, sizeof(int), 1, fptr_image);   // read 4 bytes width value
-    fread(&height, sizeof(int), 1, fptr_image);  // read 4 bytes height value
-
-    return width * height * 3;          // total pixel data bytes (RGB → 3 bytes per pixel)
-}
-
-/* ===================== SECRET FILE SIZE FETCHING - return 0 on failure ===================== */
-uint get_file_size(FILE *fptr)
-{
-    if (!fptr) return 0;
-
-    long size;
-    if (fseek(fptr, 0, SEEK_END) != 0) return 0;
-    size = ftell(fptr);
-    if (size <= 0)
-    {
-        rewind(fptr);
-        return 0;
-    }
-    rewind(fptr);
-    return (uint)size;
+    if (!strcmp(fname, STREAM_NAME)) return stream_open_prefetch(STDIN_FILENO);
+    return fopen(fname, "rb");      /* binary mode to preserve exact bytes (important for BMP) */
 }
 
 /* ===================== OPENING NECESSARY FILES (binary mode) ===================== */
 Status open_files(EncodeInfo *encInfo)
 {
-    /* Open files in binary mode to preserve exact bytes (important for BMP) */
-    encInfo->fptr_src_image = fopen(encInfo->src_image_fname, "rb");
+    encInfo->fptr_src_image = open_input(encInfo->src_image_fname);
     if (!encInfo->fptr_src_image)
     {
-        printf("[ERROR] Cannot open image: %s\n", encInfo->src_image_fname);
+        cprintf("[ERROR] Cannot open image: %s\n", encInfo->src_image_fname);
         return e_failure;
     }
 
-    encInfo->fptr_secret = fopen(encInfo->secret_fname, "rb");
+    encInfo->fptr_secret = open_input(encInfo->secret_fname);
     if (!encInfo->fptr_secret)
     {
-        printf("[ERROR] Cannot open secret file: %s\n", encInfo->secret_fname);
-        fclose(encInfo->fptr_src_image);
+        cprintf("[ERROR] Cannot open secret file: %s\n", encInfo->secret_fname);
         return e_failure;
     }
 
-    encInfo->fptr_stego_image = fopen(encInfo->stego_image_fname, "wb");
+    if (!encInfo->fptr_stego_image)      /* stdout was already claimed in do_encoding */
+    {
+        encInfo->fptr_stego_image = fopen(encInfo->stego_image_fname, "wb");
+        encInfo->output_created = encInfo->fptr_stego_image != NULL;
+    }
     if (!encInfo->fptr_stego_image)
     {
-        printf("[ERROR] Cannot create output image: %s\n", encInfo->stego_image_fname);
-        fclose(encInfo->fptr_src_image);
-        fclose(encInfo->fptr_secret);
+        cprintf("[ERROR] Cannot create output image: %s\n", encInfo->stego_image_fname);
         return e_failure;
     }
 
@@ -88,165 +68,300 @@ Status read_and_validate_encode_args(char *argv[], EncodeInfo *encInfo)
 {
     if (argv[2] == NULL || argv[3] == NULL)   // minimum args check
     {
-        printf("[ERROR] Missing arguments.\n");
-        printf("Usage: ./stego -e <source.bmp> <secret.txt> <output.bmp>\n");
+        cprintf("[ERROR] Missing arguments.\n");
+        cprintf("Usage: ./stego -e <source.bmp> <secret.txt> <output.bmp>\n");
         return e_failure;
     }
 
     /* validate BMP extension - check last occurrence of ".bmp" to be safe */
-    if (strstr(argv[2], ".bmp") != NULL)
+    if (strstr(argv[2], ".bmp") != NULL || !strcmp(argv[2], STREAM_NAME))
     {
         encInfo->src_image_fname = argv[2];
     }
     else
     {
-        printf("[ERROR] Source must be .bmp file\n");
+        cprintf("[ERROR] Source must be .bmp file\n");
         return e_failure;
     }
 
     char *ext = strrchr(argv[3], '.');        // find last dot = extension start
-    if (!ext)                                 // no extension
+    if (!strcmp(argv[3], STREAM_NAME))       // secret from stdin has no extension
+    {
+        if (!strcmp(argv[2], STREAM_NAME))
+        {
+            cprintf("[ERROR] Source image and secret cannot both come from stdin\n");
+            return e_failure;
+        }
+        encInfo->secret_fname = argv[3];
+        encInfo->extn_secret_file = "";
+    }
+    else if (!ext)                            // no extension
     {
-        printf("[ERROR] Secret file needs extension (.txt, .c, .h, .sh)\n");
+        cprintf("[ERROR] Secret file needs extension (.txt, .c, .h, .sh)\n");
         return e_failure;
     }
-
-    if (!strcmp(ext, ".txt") || !strcmp(ext, ".c") ||
-        !strcmp(ext, ".h") || !strcmp(ext, ".sh"))      // allowed types
+    else if (stego_extn_supported(ext))      // allowed types
     {
         encInfo->secret_fname = argv[3];
         encInfo->extn_secret_file = ext;
     }
     else
     {
-        printf("[ERROR] Secret file type not supported\n");
+        cprintf("[ERROR] Secret file type not supported\n");
         return e_failure;
     }
 
-    if (argv[4] && strstr(argv[4], ".bmp"))    // if output name given & valid
+    if (argv[4] && (strstr(argv[4], ".bmp") || !strcmp(argv[4], STREAM_NAME)))  // if output name given & valid
     {
         encInfo->stego_image_fname = argv[4];
     }
     else if (!argv[4])                          // if not given → default name
     {
-        printf("[INFO] Output name missing → using default output.bmp\n");
+        cprintf("[INFO] Output name missing → using default output.bmp\n");
         encInfo->stego_image_fname = "output.bmp";
     }
     else
     {
-        printf("[ERROR] Output must be .bmp\n");
+        cprintf("[ERROR] Output must be .bmp\n");
         return e_failure;
     }
 
+    encInfo->use_stream = !strcmp(encInfo->src_image_fname, STREAM_NAME) ||
+                          !strcmp(encInfo->secret_fname, STREAM_NAME) ||
+                          !strcmp(encInfo->stego_image_fname, STREAM_NAME);
+
     return e_success;
 }
 
-/* ===================== IMAGE CAPACITY CHECK ===================== */
-Status verify_capacity(EncodeInfo *encInfo)
+/* ===================== SIZE OF A REGULAR FILE, -1 FOR PIPES ===================== */
+static off_t regular_file_size(FILE *fp, const char *fname)
 {
-    encInfo->size_secret_file = get_file_size(encInfo->fptr_secret); // check secret size
-    if (encInfo->size_secret_file == 0)
-    {
-        printf("[ERROR] Secret file is empty or unreadable.\n");
-        return e_failure;
-    }
+    struct stat st;
+    int fd = !strcmp(fname, STREAM_NAME) ? STDIN_FILENO : fileno(fp);
 
-    encInfo->extension_size = strlen(encInfo->extn_secret_file); // extension length (.txt etc.)
-
-    uint img_size = get_image_size_for_bmp(encInfo->fptr_src_image); // capacity of image
-    uint required = 54 + 16 + 32 + (encInfo->extension_size * 8)
-                    + 32 + ((uint)encInfo->size_secret_file * 8); // required bytes for hiding data
+    if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) return -1;
+    return st.st_size;
+}
 
-    if (img_size < required)              // compare image capacity vs needed
-    {
-        printf("[ERROR] Image too small to hide secret data.\n");
-        return e_failure;
-    }
+/* ===================== PIPED SECRET WITHOUT --size ===================== */
+/* Checked before open_files creates the output: the header needs the size up front */
+static int secret_size_unknown(const EncodeInfo *encInfo)
+{
+    struct stat st;
+    const char *fname = encInfo->secret_fname;
 
-    return e_success;
+    if (encInfo->compress || encInfo->secret_size_hint > 0) return 0;   /* packing reads to EOF */
+    if ((!strcmp(fname, STREAM_NAME) ? fstat(STDIN_FILENO, &st) : stat(fname, &st)) != 0)
+        return 0;                                           /* open_files reports it */
+    return !S_ISREG(st.st_mode);
 }
 
-/* ===================== HEADER COPYING ===================== */
-Status transfer_header(FILE *src, FILE *dest)
+/* --size bytes were read: anything after them would be dropped without a word */
+static int secret_has_more(FILE *fp)
 {
-    char header[54];                      // store 54 bytes BMP header
-    rewind(src);                          // jump to beginning of source file
-    if (fread(header, 54, 1, src) != 1) return e_failure;
-    if (fwrite(header, 54, 1, dest) != 1) return e_failure;
-    return e_success;
+    return fgetc(fp) != EOF;
 }
 
-/* ===================== ENCODE SECRET FILE EXTENSION ===================== */
-Status encode_secret_extn(const char *extn, EncodeInfo *encInfo)
+/* ===================== A FAILED JOB LEAVES NO PARTIAL IMAGE ===================== */
+static void discard_output(const EncodeInfo *encInfo)
 {
-    char buffer[8];   // 1 character = 8 bits = 8 pixels needed
+    struct stat st;
 
-    for (int i = 0; i < (int)strlen(extn); i++)   // loop through extension characters
+    if (encInfo->output_created && lstat(encInfo->stego_image_fname, &st) == 0 && S_ISREG(st.st_mode))
+        unlink(encInfo->stego_image_fname);
+}
+
+/* ===================== LAYOUT OPTIONS FOR stego_plan (zeroed info = classic format) ===================== */
+static void encode_options(const EncodeInfo *encInfo, StegoOptions *opts)
+{
+    memset(opts, 0, sizeof(*opts));
+    opts->depth = encInfo->depth;
+    if (encInfo->crc) opts->flags |= STEGO_FLAG_CRC;
+    if (encInfo->scatter) opts->flags |= STEGO_FLAG_SCATTER;
+    if (encInfo->ecc)
     {
-        if (fread(buffer, 8, 1, encInfo->fptr_src_image) != 1) return e_failure;
-        for (int j = 0; j < 8; j++)   // 8 bits of extension char
-        {
-            buffer[j] = (buffer[j] & ~1) | ((extn[i] >> j) & 1);   // push 1 bit into LSB
-        }
-        if (fwrite(buffer, 8, 1, encInfo->fptr_stego_image) != 1) return e_failure;
+        opts->flags |= STEGO_FLAG_RS;                 // parity on header, every data block and the CRC
+        opts->ecc = encInfo->ecc;
+    }
+    if (encInfo->passphrase)
+    {
+        opts->flags |= STEGO_FLAG_CHACHA;             // the data is encrypted as it is embedded
+        opts->passphrase = encInfo->passphrase;
+    }
+    if (encInfo->secret_buf && encInfo->original_size > encInfo->size_secret_file)
+    {
+        opts->flags |= STEGO_FLAG_LZ;                 // packing paid off
+        opts->original_size = encInfo->original_size;
     }
+}
 
-    return e_success;
+/* ===================== OPTIONAL LZ STAGE ===================== */
+/* Pack the secret into secret_buf; left NULL (data stays raw) unless that makes it smaller */
+static void pack_secret(EncodeInfo *encInfo, const unsigned char *data, size_t len)
+{
+    unsigned char *packed = malloc(LZ_COMPRESS_BOUND(len));
+    size_t packed_len = packed ? lz_compress(data, len, packed, len) : 0;
+
+    encInfo->original_size = len;
+    encInfo->size_secret_file = len;
+    if (packed_len > 0 && packed_len < len)
+    {
+        encInfo->secret_buf = packed;
+        encInfo->size_secret_file = packed_len;
+    }
+    else
+    {
+        free(packed);
+    }
 }
 
-/* ===================== ENCODE SECRET FILE SIZE ===================== */
-Status encode_secret_file_size(long file_size, EncodeInfo *encInfo)
+/* Read the secret to EOF (or the --size bytes) and pack it; the stream is then
+   replaced by one over the packed bytes, so the data loop does not change */
+static Status pack_secret_stream(EncodeInfo *encInfo)
 {
-    char buffer[32];   // 32 bytes → store file size
+    size_t cap = (encInfo->secret_size_hint > 0) ? (size_t)encInfo->secret_size_hint : 1 << 16;
+    size_t len = 0;
+    unsigned char *data = malloc(cap);
 
-    if (fread(buffer, 32, 1, encInfo->fptr_src_image) != 1) return e_failure;
-    encode_int_lsb((int)file_size, buffer);               // cast to int for storing 32 bits
-    if (fwrite(buffer, 32, 1, encInfo->fptr_stego_image) != 1) return e_failure;
+    while (data)
+    {
+        size_t want = cap - len;
+        if (encInfo->secret_size_hint > 0 && len + want > (size_t)encInfo->secret_size_hint)
+            want = encInfo->secret_size_hint - len;
+        size_t got = fread(data + len, 1, want, encInfo->fptr_secret);
+        stats_read(encInfo->stats, got, 1);
+        len += got;
+        if (got < want || (encInfo->secret_size_hint > 0 && len == (size_t)encInfo->secret_size_hint))
+            break;
+
+        unsigned char *grown = realloc(data, cap * 2);
+        if (!grown) { free(data); data = NULL; break; }
+        data = grown;
+        cap *= 2;
+    }
+    if (!data || len == 0 || ferror(encInfo->fptr_secret))
+    {
+        free(data);
+        encInfo->error = "Secret file is empty or unreadable.";
+        return e_failure;
+    }
+    if (encInfo->secret_size_hint > 0 && secret_has_more(encInfo->fptr_secret))
+    {
+        free(data);
+        encInfo->error = "Secret is longer than --size: the rest would be lost.";
+        return e_failure;
+    }
+
+    pack_secret(encInfo, data, len);
+    if (encInfo->secret_buf) free(data);
+    else encInfo->secret_buf = data;          /* did not shrink: embed the raw copy */
 
+    FILE *mem = fmemopen(encInfo->secret_buf, encInfo->size_secret_file, "rb");
+    if (!mem)
+    {
+        encInfo->error = "Out of memory.";
+        return e_failure;
+    }
+    fclose(encInfo->fptr_secret);
+    encInfo->fptr_secret = mem;
     return e_success;
 }
 
-/* ===================== ENCODE INTEGER USING LSB ===================== */
-Status encode_int_lsb(int data, char *buffer)
+/* ===================== IMAGE CAPACITY CHECK ===================== */
+Status verify_capacity(EncodeInfo *encInfo)
 {
-    for (int i = 0; i < 32; i++)            // 32 bits required for int
+    PixelView view;
+    off_t image_len = regular_file_size(encInfo->fptr_src_image, encInfo->src_image_fname);
+
+    /* headers are read once, front to back, so pipes work the same as files */
+    Status ret = read_bmp_header(encInfo->fptr_src_image,
+                                 image_len < 0 ? STEGO_LEN_UNKNOWN : (size_t)image_len,
+                                 encInfo->image_header, &encInfo->header_len, &view);
+    stats_read(encInfo->stats, encInfo->header_len, 1);
+    if (ret != e_success)
+    {
+        encInfo->error = (ret == e_bad_image) ? "Source image is not a usable BMP image."
+                                              : "Source image is unreadable.";
+        return e_failure;
+    }
+
+    if (encInfo->compress)
+    {
+        /* the packed size is only known once the whole secret is read (no --size needed) */
+        if (pack_secret_stream(encInfo) != e_success) return e_failure;
+    }
+    else
     {
-        buffer[i] = (buffer[i] & ~1) | ((data >> i) & 1);  // Set LSB bit by bit
+        encInfo->size_secret_file = encInfo->secret_size_hint;
+        if (encInfo->size_secret_file <= 0)
+            encInfo->size_secret_file = regular_file_size(encInfo->fptr_secret, encInfo->secret_fname);
     }
+    if (encInfo->size_secret_file <= 0)
+    {
+        encInfo->error = "Secret file is empty or unreadable.";
+        return e_failure;
+    }
+
+    encInfo->extension_size = strlen(encInfo->extn_secret_file); // extension length (.txt etc.)
+
+    StegoOptions opts;
+    encode_options(encInfo, &opts);
+    ret = stego_plan(&view, encInfo->extn_secret_file, encInfo->size_secret_file, &opts,
+                     &encInfo->stego);
+    if (ret != e_success)
+    {
+        encInfo->error = (ret == e_no_capacity) ? "Image cannot hold the secret."
+                                                : "Encoding options do not fit this image.";
+        return e_failure;
+    }
+
+    int64_t capacity;
+    if (stego_capacity(&view, encInfo->extension_size, &opts, &capacity) == e_success)
+        encInfo->image_capacity = capacity;
+
     return e_success;
 }
 
-/* ===================== ENCODE MAGIC STRING ===================== */
-Status store_magic_data(const char *magic_string, EncodeInfo *encInfo)
+/* ===================== HEADER COPYING ===================== */
+Status transfer_header(EncodeInfo *encInfo)
 {
-    char buffer[8];
+    char buffer[4096];
+    int64_t left = encInfo->stego.header_offset - encInfo->header_len;   // palette, profile gap ...
+
+    if (fwrite(encInfo->image_header, 1, encInfo->header_len, encInfo->fptr_stego_image) !=
+        encInfo->header_len)
+        return e_failure;
+    stats_write(encInfo->stats, encInfo->header_len, 1);
 
-    for (size_t i = 0; i < strlen(magic_string); i++)
+    while (left > 0)
     {
-        if (fread(buffer, 8, 1, encInfo->fptr_src_image) != 1) return e_failure;
-        for (int j = 0; j < 8; j++)
-        {
-            buffer[j] = (buffer[j] & ~1) | ((magic_string[i] >> j) & 1);  // Store each bit
-        }
-        if (fwrite(buffer, 8, 1, encInfo->fptr_stego_image) != 1) return e_failure;
+        size_t n = (left > (int64_t)sizeof(buffer)) ? sizeof(buffer) : (size_t)left;
+        if (fread(buffer, 1, n, encInfo->fptr_src_image) != n) return e_failure;
+        if (fwrite(buffer, 1, n, encInfo->fptr_stego_image) != n) return e_failure;
+        stats_read(encInfo->stats, n, 1);
+        stats_write(encInfo->stats, n, 1);
+        left -= n;
     }
-
     return e_success;
 }
 
-/* ===================== ENCODE EXTENSION SIZE ===================== */
-Status encode_secret_extn_size(int size, EncodeInfo *encInfo)
+/* ===================== ENCODE MAGIC, EXTENSION AND SIZE ===================== */
+Status encode_header_fields(EncodeInfo *encInfo)
 {
-    char buffer[32];
-    if (fread(buffer, 32, 1, encInfo->fptr_src_image) != 1) return e_failure;
-    encode_int_lsb(size, buffer);                         // Store size into LSB
-    if (fwrite(buffer, 32, 1, encInfo->fptr_stego_image) != 1) return e_failure;
+    unsigned char buffer[STEGO_HEADER_MAX];
+    size_t len = encInfo->stego.data_offset - encInfo->stego.header_offset;
+
+    if (fread(buffer, 1, len, encInfo->fptr_src_image) != len) return e_failure;
+    stego_embed_header(&encInfo->stego, buffer, buffer);
+    if (fwrite(buffer, 1, len, encInfo->fptr_stego_image) != len) return e_failure;
+    stats_read(encInfo->stats, len, 1);
+    stats_write(encInfo->stats, len, 1);
 
     return e_success;
 }
 
 /* ===================== COPY REMAINING IMAGE BYTES ===================== */
-Status copy_remaining_data(FILE *src, FILE *dest)
+Status copy_remaining_data(FILE *src, FILE *dest, StegoStats *stats)
 {
     char buffer[4096];   // larger buffer for efficiency
     size_t bytes;        // number of bytes read per loop
@@ -254,181 +369,480 @@ Status copy_remaining_data(FILE *src, FILE *dest)
     while ((bytes = fread(buffer, 1, sizeof(buffer), src)) > 0)   // copy until no bytes left
     {
         if (fwrite(buffer, 1, bytes, dest) != bytes) return e_failure;  // ensure exact write
+        stats_read(stats, bytes, 1);
+        stats_write(stats, bytes, 1);
     }
 
     return e_success;
 }
 
-/* ===================== PROGRESS BAR FOR ENCODING SECRET DATA ===================== */
-void show_progress_encode(long current, long total)
+/* ===================== ENCODE SECRET FILE DATA (block at a time) ===================== */
+Status encode_secret_data(EncodeInfo *encInfo)
 {
-    int barWidth = 50;
-    float progress = (total > 0) ? ((float)current / total) : 0.0f;
-    int fill = (int)(progress * barWidth);
+    unsigned char secret[LSB_BLOCK_SIZE];         /* block of secret bytes */
+    unsigned char image[STEGO_BLOCK_SPAN];        /* matching block of cover bytes */
+    size_t n;
+    int64_t done = 0;   /* Track encoded bytes */
+    uint32_t crc = 0;   /* CRC32C of the data so far */
+    const char *error = NULL;
+    Progress progress;
+
+    progress_start(&progress, encInfo->progress, "encode", encInfo->size_secret_file);
 
-    printf("\r[");  // Update same line
-    for (int i = 0; i < barWidth; i++)
+    while (done < encInfo->size_secret_file)   /* exactly the size stored in the header */
     {
-        if (i < fill)
+        n = encInfo->size_secret_file - done;
+        if (n > sizeof(secret)) n = sizeof(secret);
+        size_t span = stego_data_span(&encInfo->stego, done, n);
+
+        if (fread(secret, 1, n, encInfo->fptr_secret) != n)
         {
-            printf(GREEN "■" RESET); // Filled (green)
+            error = "Secret data ended before the announced size.";
+            break;
         }
-        else
+
+        if (fread(image, 1, span, encInfo->fptr_src_image) != span)
         {
-            printf(GRAY "□" RESET);  // Empty (gray)
+            error = "Unexpected EOF while reading source image data.";
+            break;
         }
-    }
-    printf("] %3d%%", (int)(progress * 100));
-    fflush(stdout);
-}
 
-/* ===================== ENCODE SECRET FILE DATA (use int for fgetc) ===================== */
-Status encode_secret_data(EncodeInfo *encInfo)
-{
-    char buffer[8];
-    int c;               /* must be int to compare with EOF */
-    unsigned char ch;
-    long done = 0;   /* Track encoded bytes */
-
-    rewind(encInfo->fptr_secret);   /* Start from beginning of secret file */
-
-    while ((c = fgetc(encInfo->fptr_secret)) != EOF)
-    {
-        ch = (unsigned char)c;                    /* safe cast */
+        stego_embed_data(&encInfo->stego, done, secret, n, image, image);
+        crc = crc32c(crc, secret, n);   /* same block, still in cache */
 
-        if (fread(buffer, 8, 1, encInfo->fptr_src_image) != 1)
+        if (fwrite(image, 1, span, encInfo->fptr_stego_image) != span)
         {
-            printf("\n[ERROR] Unexpected EOF while reading source image data.\n");
-            return e_failure;
+            error = "Failed writing stego image.";
+            break;
         }
+        if (encInfo->secret_buf) stats_read(encInfo->stats, span, 1);   /* packed secret is in memory */
+        else stats_read(encInfo->stats, n + span, 2);
+        stats_write(encInfo->stats, span, 1);
 
-        for (int i = 0; i < 8; i++)
-        {
-            buffer[i] = (buffer[i] & ~1) | ((ch >> i) & 1);
-        }
+        done += n;
+        progress_add(&progress, n);     /* the reporter thread does the drawing */
+    }
+
+    if (!error && !encInfo->secret_buf && encInfo->secret_size_hint > 0 &&
+        secret_has_more(encInfo->fptr_secret))
+        error = "Secret is longer than --size: the rest would be lost.";
 
-        if (fwrite(buffer, 8, 1, encInfo->fptr_stego_image) != 1)
+    /* the checksum follows the data, so the image is still read front to back */
+    if (!error && (encInfo->stego.flags & STEGO_FLAG_CRC))
+    {
+        size_t span = encInfo->stego.end_offset - encInfo->stego.crc_offset;
+        if (fread(image, 1, span, encInfo->fptr_src_image) != span)
+            error = "Unexpected EOF while reading source image data.";
+        else
         {
-            printf("\n[ERROR] Failed writing stego image.\n");
-            return e_failure;
+            stego_embed_crc(&encInfo->stego, crc, image, image);
+            if (fwrite(image, 1, span, encInfo->fptr_stego_image) != span)
+                error = "Failed writing stego image.";
+            stats_read(encInfo->stats, span, 1);
+            stats_write(encInfo->stats, span, 1);
         }
+    }
 
-        done++;
-        show_progress_encode(done, encInfo->size_secret_file);
-        delay_ms(200);   /* 200 ms delay for animation */
+    progress_finish(&progress);
+    stats_data(encInfo->stats, done);
+    if (error)
+    {
+        encInfo->error = error;
+        return e_failure;
     }
 
-    printf("\n" GREEN "✔ Encoding Completed Successfully!" RESET "\n");
+    cprintf(GREEN "✔ Encoding Completed Successfully!" RESET "\n");
     return e_success;
 }
 
+/* ===================== CLOSE WHATEVER IS STILL OPEN ===================== */
+static void close_files(EncodeInfo *encInfo)
+{
+    if (encInfo->fptr_src_image) fclose(encInfo->fptr_src_image);
+    if (encInfo->fptr_secret) fclose(encInfo->fptr_secret);
+    if (encInfo->fptr_stego_image) fclose(encInfo->fptr_stego_image);
+    encInfo->fptr_src_image = NULL;
+    encInfo->fptr_secret = NULL;
+    encInfo->fptr_stego_image = NULL;
+    free(encInfo->secret_buf);         /* after fclose: a packed secret is read through fmemopen */
+    encInfo->secret_buf = NULL;
+}
+
+static Status encode_sequential(EncodeInfo *encInfo);
+
 /* ===================== COMPLETE ENCODING PROCESS ===================== */
 Status do_encoding(EncodeInfo *encInfo)
 {
-    printf("\n───────────────────────────────────────────────\n");
-    printf("🔐 STEGANOGRAPHY TOOL - ENCODING STARTED\n");
-    printf("───────────────────────────────────────────────\n\n");
+    stats_begin(encInfo->stats, "encode");
+    stats_phase(encInfo->stats, e_phase_open);
+    encInfo->error = NULL;
+    encInfo->output_created = 0;
+
+    /* Stego image goes to stdout: keep it clean, banners move to stderr */
+    if (!strcmp(encInfo->stego_image_fname, STREAM_NAME))
+    {
+        encInfo->fptr_stego_image = stream_claim_stdout();
+        if (!encInfo->fptr_stego_image)
+        {
+            cprintf("[ERROR] Cannot use stdout for the output image\n");
+            stats_end(encInfo->stats, 0);
+            return e_failure;
+        }
+    }
+
+    cprintf("\n───────────────────────────────────────────────\n");
+    cprintf("🔐 STEGANOGRAPHY TOOL - ENCODING STARTED\n");
+    cprintf("───────────────────────────────────────────────\n\n");
 
-    printf("📁 Files:\n");
-    printf("   Source Image    : %s\n", encInfo->src_image_fname);
-    printf("   Secret File     : %s\n", encInfo->secret_fname);
-    printf("   Output Image    : %s\n\n", encInfo->stego_image_fname);
+    cprintf("📁 Files:\n");
+    cprintf("   Source Image    : %s\n", encInfo->src_image_fname);
+    cprintf("   Secret File     : %s\n", encInfo->secret_fname);
+    cprintf("   Output Image    : %s\n\n", encInfo->stego_image_fname);
 
-    printf("⚙️  Steps:\n");
-    printf("   1️⃣  Validating arguments .............. ✔️\n");
+    cprintf("⚙️  Steps:\n");
+    cprintf("   1️⃣  Validating arguments .............. ✔️\n");
+
+    Status ret;
+    if (encInfo->scatter && encInfo->use_stream)
+    {
+        cprintf("\n🎯 STATUS: FAILED — --scatter writes the image out of order and cannot use a pipe.\n");
+        cprintf("───────────────────────────────────────────────\n");
+        ret = e_failure;
+    }
+    else if (!encInfo->use_stream && (encInfo->use_mmap || encInfo->threads > 1 || encInfo->scatter))
+        ret = do_encoding_mmap(encInfo);
+    else
+        ret = encode_sequential(encInfo);
+
+    stats_phase(encInfo->stats, e_phase_close);
+    close_files(encInfo);    /* every path, so long batch runs don't leak descriptors */
+    if (ret != e_success) discard_output(encInfo);
+    stats_end(encInfo->stats, ret == e_success);
+    return ret;
+}
+
+/* ===================== ENCODING STEPS 2..8, STRICTLY SEQUENTIAL (files or pipes) ===================== */
+static Status encode_sequential(EncodeInfo *encInfo)
+{
+    Status ret = e_success;
 
     /* Step 2: Open all files */
-    printf("   2️⃣  Opening files ..................... ");
+    cprintf("   2️⃣  Opening files ..................... ");
+    if (secret_size_unknown(encInfo))
+    {
+        cprintf("✖️\n");
+        cprintf("\n🎯 STATUS: FAILED — Secret size unknown: pass --size <bytes> for piped secrets.\n");
+        cprintf("───────────────────────────────────────────────\n");
+        return e_failure;
+    }
     if (open_files(encInfo) != e_success)
     {
-        printf("✖️\n");
-        printf("\n🎯 STATUS: FAILED — Could not open required files.\n");
-        printf("───────────────────────────────────────────────\n");
+        cprintf("✖️\n");
+        cprintf("\n🎯 STATUS: FAILED — Could not open required files.\n");
+        cprintf("───────────────────────────────────────────────\n");
         return e_failure;
     }
-    printf("✔️\n");
+    cprintf("✔️\n");
 
     /* Step 3: Check image capacity */
-    printf("   3️⃣  Checking image capacity ........... ");
+    stats_phase(encInfo->stats, e_phase_plan);
+    cprintf("   3️⃣  Checking image capacity ........... ");
     if (verify_capacity(encInfo) != e_success)
     {
-        printf("✖️\n");
-        printf("\n🎯 STATUS: FAILED — Image too small to hide secret.\n");
-        printf("───────────────────────────────────────────────\n");
+        cprintf("✖️\n");
+        cprintf("\n🎯 STATUS: FAILED — %s\n", encInfo->error);
+        cprintf("───────────────────────────────────────────────\n");
         return e_failure;
     }
-    printf("✔️  (Enough space)\n");
+    cprintf("✔️  (Enough space%s)\n", (encInfo->stego.flags & STEGO_FLAG_CHACHA) ? ", ChaCha20 key derived" : "");
 
     /* Step 4: Copy BMP header */
-    printf("   4️⃣  Copying BMP header ................ ");
-    if (transfer_header(encInfo->fptr_src_image, encInfo->fptr_stego_image) != e_success)
+    stats_phase(encInfo->stats, e_phase_header);
+    cprintf("   4️⃣  Copying BMP header ................ ");
+    if (transfer_header(encInfo) != e_success)
     {
-        printf("✖️\n");
-        printf("\n🎯 STATUS: FAILED — Unable to copy BMP header.\n");
-        printf("───────────────────────────────────────────────\n");
+        cprintf("✖️\n");
+        cprintf("\n🎯 STATUS: FAILED — Unable to copy BMP header.\n");
+        cprintf("───────────────────────────────────────────────\n");
         return e_failure;
     }
-    printf("✔️\n");
+    cprintf("✔️\n");
 
-    /* Step 5: Embed magic string */
-    printf("   5️⃣  Embedding magic signature (#*) .... ");
-    if (store_magic_data(MAGIC_STRING, encInfo) != e_success)
+    /* Step 5: Magic string, extension and file size */
+    stats_phase(encInfo->stats, e_phase_fields);
+    if (encInfo->stego.flags & STEGO_FLAG_LZ)
+        cprintf("   5️⃣  Hiding #*, extension (%s), size (%" PRId64 " bytes, packed from %" PRId64 ") .... ",
+                encInfo->extn_secret_file, encInfo->size_secret_file, encInfo->original_size);
+    else
+        cprintf("   5️⃣  Hiding #*, extension (%s), size (%" PRId64 " bytes) .... ",
+                encInfo->extn_secret_file, encInfo->size_secret_file);
+    if (encode_header_fields(encInfo) != e_success)
     {
-        printf("✖️\n");
-        printf("\n🎯 STATUS: FAILED — Could not store magic string.\n");
-        printf("───────────────────────────────────────────────\n");
+        cprintf("✖️\n");
+        cprintf("\n🎯 STATUS: FAILED — Could not write stego header fields.\n");
+        cprintf("───────────────────────────────────────────────\n");
         return e_failure;
     }
-    printf("✔️\n");
+    cprintf("✔️\n");
 
-    /* Step 6: Hide extension size and extension */
-    printf("   6️⃣  Hiding extension (%s) ........... ", encInfo->extn_secret_file);
-    if (encode_secret_extn_size(encInfo->extension_size, encInfo) != e_success ||
-        encode_secret_extn(encInfo->extn_secret_file, encInfo) != e_success)
+    /* Step 6: Encode secret data (with progress bar) */
+    stats_phase(encInfo->stats, e_phase_data);
+    cprintf("   6️⃣  Encoding secret data .............. ⏳\n\n");
+    cprintf("⚙️  Encoding Secret Data...\n");
+    if (encode_secret_data(encInfo) != e_success)
     {
-        printf("✖️\n");
-        printf("\n🎯 STATUS: FAILED — Could not encode extension.\n");
-        printf("───────────────────────────────────────────────\n");
+        cprintf("\n🎯 STATUS: FAILED — %s\n", encInfo->error);
+        cprintf("───────────────────────────────────────────────\n");
         return e_failure;
     }
-    printf("✔️\n");
 
-    /* Step 7: Hide file size */
-    printf("   7️⃣  Hiding file size (%ld bytes) ..... ", encInfo->size_secret_file);
-    if (encode_secret_file_size(encInfo->size_secret_file, encInfo) != e_success)
+    /* Step 7: Copy remaining image bytes */
+    stats_phase(encInfo->stats, e_phase_tail);
+    cprintf("\n   7️⃣  Writing padding bytes ............ ");
+    if (copy_remaining_data(encInfo->fptr_src_image, encInfo->fptr_stego_image, encInfo->stats) != e_success)
+        ret = e_failure;
+    stats_phase(encInfo->stats, e_phase_close);
+    if (fflush(encInfo->fptr_stego_image) != 0) ret = e_failure;   /* flush pipe before reporting */
+    if (ret != e_success)
     {
-        printf("✖️\n");
-        printf("\n🎯 STATUS: FAILED — Could not encode file size.\n");
-        printf("───────────────────────────────────────────────\n");
+        cprintf("✖️\n");
+        cprintf("\n🎯 STATUS: FAILED — Could not copy remaining image data.\n");
+        cprintf("───────────────────────────────────────────────\n");
         return e_failure;
     }
-    printf("✔️\n");
+    cprintf("✔️\n");
 
-    /* Step 8: Encode secret data (with progress bar) */
-    printf("   8️⃣  Encoding secret data .............. ⏳\n\n");
-    printf("⚙️  Encoding Secret Data...\n");
-    if (encode_secret_data(encInfo) != e_success)
+    /* Final status */
+    cprintf("\n🎯 STATUS: SUCCESS — Secret hidden safely!\n");
+    cprintf("📌 Output Saved: %s\n", strcmp(encInfo->stego_image_fname, STREAM_NAME)
+                                    ? encInfo->stego_image_fname : "(stdout)");
+    cprintf("───────────────────────────────────────────────\n");
+
+    return e_success;
+}
+
+/* ===================== ONE THREAD'S SLICE OF THE SECRET DATA ===================== */
+typedef struct
+{
+    const StegoInfo *stego;          // layout from stego_plan
+    const unsigned char *cover;      // mapped source image
+    const unsigned char *secret;     // mapped secret file
+    int out_fd;                      // stego image, written with pwrite
+    Progress *progress;              // shared byte counter
+    uint32_t *crcs;                  // CRC32C of each POOL_GRAIN slice, joined afterwards
+    StegoStats *stats;               // --stats counters (NULL = off)
+} EmbedRangeCtx;
+
+/* Secret byte k always lands at stego_data_pos(k), so slices are independent */
+static Status embed_range(void *arg, int64_t begin, int64_t end)
+{
+    EmbedRangeCtx *ctx = arg;
+    unsigned char block[STEGO_BLOCK_SPAN];
+    uint32_t crc = 0;
+    int64_t moved = 0, calls = 0;   /* added to the shared counters once per slice */
+    size_t n;
+
+    for (int64_t k = begin; k < end; k += n)
     {
-        printf("\n🎯 STATUS: FAILED — Error while encoding secret data.\n");
-        printf("───────────────────────────────────────────────\n");
-        return e_failure;
+        n = stego_data_run(ctx->stego, k, (end - k > LSB_BLOCK_SIZE) ? LSB_BLOCK_SIZE : (size_t)(end - k));
+        off_t off = stego_data_pos(ctx->stego, k);
+
+        stego_embed_data(ctx->stego, k, ctx->secret + k, n, ctx->cover + off, block);
+        if (ctx->crcs) crc = crc32c(crc, ctx->secret + k, n);
+        size_t span = stego_data_span(ctx->stego, k, n);
+        if (write_all_at(ctx->out_fd, block, span, off) != e_success)
+            return e_failure;
+        moved += span;
+        calls++;
+        progress_add(ctx->progress, n);
     }
+    stats_read(ctx->stats, (end - begin) + moved, 0);     /* secret and cover come from mappings */
+    stats_write(ctx->stats, moved, calls);
+    if (ctx->crcs) ctx->crcs[begin / POOL_GRAIN] = crc;
+    return e_success;
+}
 
-    /* Step 9: Copy remaining image bytes */
-    printf("\n   9️⃣  Writing padding bytes ............ ");
-    if (copy_remaining_data(encInfo->fptr_src_image, encInfo->fptr_stego_image) != e_success)
+/* ===================== COMPLETE ENCODING PROCESS (memory mapped) ===================== */
+Status do_encoding_mmap(EncodeInfo *encInfo)
+{
+    MappedFile cover, secret;
+    int out_fd;
+    int cloned;
+
+    /* Step 2: Map inputs, create output (do_encoding started the open phase) */
+    cprintf("   2️⃣  Mapping files ..................... ");
+    if (map_file(encInfo->src_image_fname, &cover) != e_success)
+    {
+        cprintf("✖️\n");
+        cprintf("\n🎯 STATUS: FAILED — Cannot map image: %s\n", encInfo->src_image_fname);
+        cprintf("───────────────────────────────────────────────\n");
+        return e_failure;
+    }
+    if (map_file(encInfo->secret_fname, &secret) != e_success)
     {
-        printf("✖️\n");
-        printf("\n🎯 STATUS: FAILED — Could not copy remaining image data.\n");
-        printf("───────────────────────────────────────────────\n");
+        cprintf("✖️\n");
+        cprintf("\n🎯 STATUS: FAILED — Cannot map secret file: %s\n", encInfo->secret_fname);
+        cprintf("───────────────────────────────────────────────\n");
+        unmap_file(&cover);
         return e_failure;
     }
-    printf("✔️\n");
+    out_fd = open(encInfo->stego_image_fname, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    encInfo->output_created = out_fd >= 0;
+    if (out_fd < 0)
+    {
+        cprintf("✖️\n");
+        cprintf("\n🎯 STATUS: FAILED — Cannot create output image: %s\n", encInfo->stego_image_fname);
+        cprintf("───────────────────────────────────────────────\n");
+        unmap_file(&cover);
+        unmap_file(&secret);
+        return e_failure;
+    }
+    cprintf("✔️\n");
+
+    /* Step 3: Check image capacity (same rule as verify_capacity) */
+    stats_phase(encInfo->stats, e_phase_plan);
+    cprintf("   3️⃣  Checking image capacity ........... ");
+    encInfo->size_secret_file = secret.size;
+    encInfo->extension_size = strlen(encInfo->extn_secret_file);
+
+    PixelView view;
+    StegoOptions opts;
+    size_t need;
+    Status ret = (secret.size == 0) ? e_failure
+               : stego_parse_bmp(cover.data, cover.size, cover.size, &view, &need);
+    if (ret == e_success && encInfo->compress)
+    {
+        pack_secret(encInfo, secret.data, secret.size);
+        stats_read(encInfo->stats, secret.size, 0);
+    }
+    encode_options(encInfo, &opts);
+    if (ret == e_success)
+        ret = stego_plan(&view, encInfo->extn_secret_file, encInfo->size_secret_file, &opts,
+                         &encInfo->stego);
+    if (ret != e_success)
+    {
+        cprintf("✖️\n");
+        cprintf("\n🎯 STATUS: FAILED — %s\n", secret.size == 0 ? "Secret file is empty."
+                                                             : stego_strerror(ret));
+        cprintf("───────────────────────────────────────────────\n");
+        close(out_fd);
+        unmap_file(&cover);
+        unmap_file(&secret);
+        return e_failure;
+    }
+    cprintf("✔️  (Enough space%s)\n", (encInfo->stego.flags & STEGO_FLAG_CHACHA) ? ", ChaCha20 key derived" : "");
+
+    /* Step 4: Share the cover's blocks when the filesystem can reflink */
+    stats_phase(encInfo->stats, e_phase_header);
+    cprintf("   4️⃣  Cloning cover image ............... ");
+    cloned = (clone_file(cover.fd, out_fd) == e_success);
+    if (cloned) stats_copy(encInfo->stats, 0);    /* a reflink shares blocks, it moves no bytes */
+    if (cloned)
+        cprintf("✔️  (reflink)\n");
+    else if (encInfo->stego.flags & STEGO_FLAG_SCATTER)
+    {
+        /* scattered slots leave gaps all over the image: copy it whole, then patch */
+        cloned = (copy_file_tail(cover.fd, out_fd, 0, cover.size) == e_success);
+        stats_copy(encInfo->stats, cover.size);
+        cprintf(cloned ? "➖ (no reflink, whole image copied)\n" : "✖️\n");
+        if (!cloned) ret = e_failure;
+    }
+    else
+        cprintf("➖ (no reflink, header + tail copied)\n");
+
+    /* Step 5: Write header, then the embedded prefix: magic, extn size, extn, size, data */
+    cprintf("   5️⃣  Embedding header and secret data .. ⏳\n\n");
+    cprintf("⚙️  Encoding Secret Data...\n");
+
+    const StegoInfo *layout = &encInfo->stego;
+    unsigned char fields[STEGO_HEADER_MAX];
+    size_t fields_len = layout->data_offset - layout->header_offset;
+
+    if (ret == e_success && !cloned && write_all_at(out_fd, cover.data, layout->header_offset, 0) != e_success)
+        ret = e_failure;
+    if (!cloned)
+    {
+        stats_read(encInfo->stats, layout->header_offset, 0);
+        stats_write(encInfo->stats, layout->header_offset, 1);
+    }
+    stats_phase(encInfo->stats, e_phase_fields);
+    stego_embed_header(layout, cover.data + layout->header_offset, fields);
+    if (ret == e_success &&
+        write_all_at(out_fd, fields, fields_len, layout->header_offset) != e_success)
+        ret = e_failure;
+    stats_read(encInfo->stats, fields_len, 0);
+    stats_write(encInfo->stats, fields_len, 1);
+    stats_phase(encInfo->stats, e_phase_data);
+    if (ret == e_success)
+    {
+        Progress progress;
+        const unsigned char *data = encInfo->secret_buf ? encInfo->secret_buf : secret.data;
+        EmbedRangeCtx ctx = { layout, cover.data, data, out_fd, &progress, NULL, encInfo->stats };
+
+        if (layout->flags & STEGO_FLAG_CRC)
+        {
+            ctx.crcs = malloc(((layout->size + POOL_GRAIN - 1) / POOL_GRAIN + 1) * sizeof(*ctx.crcs));
+            if (!ctx.crcs) ret = e_failure;
+        }
+        progress_start(&progress, encInfo->progress, "encode", layout->size);
+        if (ret == e_success)
+            ret = parallel_for(encInfo->threads > 1 ? encInfo->threads : 1, layout->size,
+                               POOL_GRAIN, embed_range, &ctx);
+        progress_finish(&progress);
+
+        if (ret == e_success && ctx.crcs)
+        {
+            unsigned char trailer[STEGO_CRC_SPAN];
+            uint32_t crc = crc32c_join(ctx.crcs, layout->size, POOL_GRAIN);
+            stego_embed_crc(layout, crc, cover.data + layout->crc_offset, trailer);
+            ret = write_all_at(out_fd, trailer, layout->end_offset - layout->crc_offset,
+                               layout->crc_offset);
+            stats_read(encInfo->stats, layout->end_offset - layout->crc_offset, 0);
+            stats_write(encInfo->stats, layout->end_offset - layout->crc_offset, 1);
+        }
+        free(ctx.crcs);
+        stats_data(encInfo->stats, atomic_load(&progress.done));
+    }
+    if (ret != e_success)
+    {
+        cprintf("\n🎯 STATUS: FAILED — Error while encoding secret data.\n");
+        cprintf("───────────────────────────────────────────────\n");
+    }
+    else
+    {
+        cprintf(GREEN "✔ Encoding Completed Successfully!" RESET "\n");
+    }
+
+    /* Step 6: Copy the untouched remainder without passing it through user space */
+    if (ret == e_success && !cloned)
+    {
+        stats_phase(encInfo->stats, e_phase_tail);
+        cprintf("\n   6️⃣  Copying untouched image tail ...... ");
+        ret = copy_file_tail(cover.fd, out_fd, layout->end_offset,
+                             cover.size - layout->end_offset);
+        stats_copy(encInfo->stats, cover.size - layout->end_offset);
+        if (ret != e_success)
+        {
+            cprintf("✖️\n");
+            cprintf("\n🎯 STATUS: FAILED — Could not copy remaining image data.\n");
+            cprintf("───────────────────────────────────────────────\n");
+        }
+        else
+        {
+            cprintf("✔️\n");
+        }
+    }
+
+    stats_phase(encInfo->stats, e_phase_close);
+    if (close(out_fd) != 0) ret = e_failure;
+    unmap_file(&cover);
+    unmap_file(&secret);
+    if (ret != e_success) return e_failure;
 
     /* Final status */
-    printf("\n🎯 STATUS: SUCCESS — Secret hidden safely!\n");
-    printf("📌 Output Saved: %s\n", encInfo->stego_image_fname);
-    printf("───────────────────────────────────────────────\n");
+    cprintf("\n🎯 STATUS: SUCCESS — Secret hidden safely!\n");
+    cprintf("📌 Output Saved: %s\n", encInfo->stego_image_fname);
+    cprintf("───────────────────────────────────────────────\n");
 
     return e_success;
 }
@@ -2,11 +2,13 @@
 #define ENCODE_H
 
 #include "types.h"    // using Status, OperationType, uint etc.
+#include "stego.h"    // StegoInfo, in-memory LSB engine
+#include "progress.h" // ProgressMode
+#include "stats.h"    // StegoStats
 
 /* Buffer sizes for processing */
 #define MAX_SECRET_BUF_SIZE 1        // We process 1 byte of secret file at a time
 #define MAX_IMAGE_BUF_SIZE (MAX_SECRET_BUF_SIZE * 8)  // 1 byte → 8 image bytes
-#define MAX_FILE_SUFFIX 4            // e.g. ".txt" = 4 characters
 
 /* Structure to store all encoding-related information */
 typedef struct _EncodeInfo
@@ -14,20 +16,47 @@ typedef struct _EncodeInfo
     /* Source Image Details */
     char *src_image_fname;           // Input BMP file name
     FILE *fptr_src_image;            // File pointer of source image
-    uint image_capacity;             // Maximum data image can hide
+    int64_t image_capacity;          // Maximum data image can hide
 
     /* Secret File Details */
     char *secret_fname;              // Name of the secret file (to hide)
     FILE *fptr_secret;               // Secret file pointer
     char *extn_secret_file;          // Secret file extension (e.g. .txt)
     char secret_data[100];           // Buffer for secret file data
-    long size_secret_file;           // Size of secret file in bytes
+    int64_t size_secret_file;        // Size of secret file in bytes
     int extension_size;              // Length of extension string (e.g. 4)
 
+    /* Hidden layout worked out by stego_plan */
+    unsigned char image_header[STEGO_BMP_HEADER_MAX];  // BMP headers, read once
+    size_t header_len;               // bytes of image_header read from the source
+    StegoInfo stego;                 // where each hidden field goes
+
     /* Output Stego Image Details */
     char *stego_image_fname;         // Output BMP after storing secret
     FILE *fptr_stego_image;          // File pointer for stego image
 
+    /* Options */
+    int use_mmap;                    // map inputs, copy untouched tail in kernel
+    int use_stream;                  // some file is "-" (stdin / stdout), no seeking
+    int64_t secret_size_hint;        // --size given by caller (needed for piped secrets)
+    int threads;                     // -j N: split the secret data across N threads
+    int depth;                       // --depth N: data LSBs per carrier byte (0 = 1)
+    int compress;                    // --compress: LZ-pack the secret before embedding
+    int crc;                         // store a CRC32C of the data (off with --no-crc)
+    int scatter;                     // --scatter: data blocks in keyed random slots (needs seeking)
+    int ecc;                         // --ecc N: Reed-Solomon parity bytes per codeword (0 = none)
+    const char *passphrase;          // --passphrase-file: encrypt the data (NULL = plain)
+
+    /* LZ stage: the header needs the packed size, so the whole secret is packed first */
+    unsigned char *secret_buf;       // secret held in memory (packed, or raw if it did not shrink)
+    int64_t original_size;           // secret size before packing
+    ProgressMode progress;           // --progress / --quiet (none when zeroed)
+    StegoStats *stats;               // --stats: filled by do_encoding (NULL = not measured)
+
+    /* Outcome */
+    const char *error;               // why a step failed, for the status line (NULL = none)
+    int output_created;              // the output file was made by this job (removed if it fails)
+
 } EncodeInfo;
 
 /*----------------------------------------------------------
@@ -40,40 +69,26 @@ Status read_and_validate_encode_args(char *argv[], EncodeInfo *encInfo);
 /* Perform entire encoding process */
 Status do_encoding(EncodeInfo *encInfo);
 
-/* Open required files for reading/writing */
+/* Encoding through memory maps; only the modified prefix is written by us */
+Status do_encoding_mmap(EncodeInfo *encInfo);
+
+/* Open required files for reading/writing ("-" = stdin / stdout) */
 Status open_files(EncodeInfo *encInfo);
 
-/* Check if source image can store secret file */
+/* Read the BMP header and check the source image can store the secret file
+   (encInfo->error says why not) */
 Status verify_capacity(EncodeInfo *encInfo);
 
-/* Find total usable pixel data size of BMP (WxHx3) */
-uint get_image_size_for_bmp(FILE *fptr_image);
-
-/* Get file size (used for secret file) */
-uint get_file_size(FILE *fptr);
-
-/* Copy BMP header (first 54 bytes) to output */
-Status transfer_header(FILE *fptr_src_image, FILE *fptr_dest_image);
-
-/* Encode magic identifier (#*) to verify valid stego image during decode */
-Status store_magic_data(const char *magic_string, EncodeInfo *encInfo);
-
-/* Store integer information into LSBs of image bytes */
-Status encode_int_lsb(int data, char *image_buffer);
-
-/* Store the size of secret file extension */
-Status encode_secret_extn_size(int size, EncodeInfo *encInfo);
-
-/* Store extension characters (e.g. ".txt") */
-Status encode_secret_extn(const char *extn, EncodeInfo *encInfo);
+/* Write the BMP headers read by verify_capacity and copy the source up to the pixels */
+Status transfer_header(EncodeInfo *encInfo);
 
-/* Store secret file size for later extraction */
-Status encode_secret_file_size(long file_size, EncodeInfo *encInfo);
+/* Embed magic (#*), extension size, extension and secret size */
+Status encode_header_fields(EncodeInfo *encInfo);
 
 /* Store secret file data (actual hidden content) */
 Status encode_secret_data(EncodeInfo *encInfo);
 
-/* Copy remaining image bytes unchanged */
-Status copy_remaining_data(FILE *src, FILE *dest);
+/* Copy remaining image bytes unchanged (counted in stats unless NULL) */
+Status copy_remaining_data(FILE *src, FILE *dest, StegoStats *stats);
 
 #endif
@@ -0,0 +1,42 @@
+#ifndef FILEIO_H
+#define FILEIO_H
+
+#include <stdio.h>
+#include <sys/types.h>   // off_t
+#include "types.h"       // Status
+#include "stego.h"       // PixelView
+
+/* A whole file mapped read-only into memory */
+typedef struct _MappedFile
+{
+    int fd;                          // descriptor kept open while mapped
+    unsigned char *data;             // start of mapping (NULL for empty files)
+    off_t size;                      // file size in bytes
+} MappedFile;
+
+/* Open and map a file read-only */
+Status map_file(const char *fname, MappedFile *map);
+
+/* Unmap and close a file mapped with map_file */
+void unmap_file(MappedFile *map);
+
+/* Make dst a reflink of the whole src file (shares blocks, no data copied) */
+Status clone_file(int src_fd, int dst_fd);
+
+/* Copy len bytes at offset off from src to the same offset in dst, letting the
+   kernel move the data (copy_file_range, then sendfile, then read/write) */
+Status copy_file_tail(int src_fd, int dst_fd, off_t off, off_t len);
+
+/* Read exactly len bytes at the given offset (fails on EOF), retrying short reads */
+Status read_all_at(int fd, void *buf, size_t len, off_t off);
+
+/* Write the whole buffer at the given offset, retrying short writes */
+Status write_all_at(int fd, const void *buf, size_t len, off_t off);
+
+/* Read the BMP headers from the current position of fp (works on pipes) and
+   parse them. header must hold STEGO_BMP_HEADER_MAX bytes; *header_len gets
+   the number of bytes consumed. image_len may be STEGO_LEN_UNKNOWN. */
+Status read_bmp_header(FILE *fp, size_t image_len, unsigned char *header,
+                       size_t *header_len, PixelView *view);
+
+#endif // FILEIO_H
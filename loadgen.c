@@ -0,0 +1,338 @@
+/************************************************************
+ * Steganography Tool - Daemon load generator
+ *
+ * Opens --clients connections to a running ./steganography -D,
+ * keeps --pipeline requests in flight on each and prints one
+ * JSON object:
+ *   {"op":..,"clients":..,"pipeline":..,"requests":..,"errors":..,
+ *    "seconds":..,"rps":..,"p50_us":..,"p90_us":..,"p99_us":..,"max_us":..}
+ * Secrets and outputs are memfds sent with every request, so
+ * the numbers measure the daemon and not a file system.
+ ************************************************************/
+
+#define _GNU_SOURCE          // memfd_create, MUST be first line
+#define _FILE_OFFSET_BITS 64 // same off_t as fileio.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>        // memfd_create
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "types.h"
+#include "stego.h"           // STEGO_BMP_HEADER, STEGO_HEADER_MAX
+#include "fileio.h"          // write_all_at
+
+#define LOADGEN_WIDTH 1024                // cover width in pixels
+#define LOADGEN_PIPELINE_MAX 64
+#define LOADGEN_MSG_MAX 4096              // DAEMON_MSG_MAX
+
+/* ===================== ONE CLIENT ===================== */
+typedef struct
+{
+    const char *socket_path;
+    const char *request;                  // same line for every request
+    int fds[3];                           // sent with every request
+    int nfds;
+    int requests;
+    int pipeline;
+    long *latency_ns;                     // one per request
+    int errors;
+} Client;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int send_request(int fd, const Client *c)
+{
+    union { char buf[CMSG_SPACE(sizeof(int) * 3)]; struct cmsghdr align; } control;
+    struct iovec iov = { (void *)c->request, strlen(c->request) };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+
+    if (c->nfds)
+    {
+        msg.msg_control = control.buf;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * c->nfds);
+        struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN(sizeof(int) * c->nfds);
+        memcpy(CMSG_DATA(cm), c->fds, sizeof(int) * c->nfds);
+    }
+    return sendmsg(fd, &msg, MSG_NOSIGNAL) == (ssize_t)iov.iov_len ? 0 : -1;
+}
+
+static void *client_main(void *arg)
+{
+    Client *c = arg;
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    int64_t *sent_at = malloc(c->requests * sizeof(int64_t));
+    char reply[LOADGEN_MSG_MAX + 1];
+    int sent = 0, done = 0;
+
+    strncpy(addr.sun_path, c->socket_path, sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (!sent_at || fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        c->errors = c->requests;
+        if (fd >= 0) close(fd);
+        free(sent_at);
+        return NULL;
+    }
+
+    while (done < c->requests)
+    {
+        /* top the pipeline up, then wait for any reply */
+        while (sent < c->requests && sent - done < c->pipeline)
+        {
+            sent_at[sent] = now_ns();
+            if (send_request(fd, c) != 0) break;
+            sent++;
+        }
+        ssize_t n = recv(fd, reply, LOADGEN_MSG_MAX, 0);
+        if (n <= 0) break;
+        reply[n] = '\0';
+
+        /* replies may come back out of order: match them by number */
+        unsigned seq = (unsigned)strtoul(reply, NULL, 10);
+        if (seq < 1 || seq > (unsigned)sent) break;
+        c->latency_ns[done++] = now_ns() - sent_at[seq - 1];
+        const char *status = strchr(reply, ' ');
+        if (!status || strncmp(status + 1, "OK", 2) != 0)
+        {
+            if (c->errors++ == 0) fprintf(stderr, "[ERROR] %s\n", reply);
+        }
+    }
+    c->errors += c->requests - done;      // lost with the connection
+    close(fd);
+    free(sent_at);
+    return NULL;
+}
+
+/* ===================== FILES ===================== */
+static void put_le(unsigned char *p, uint32_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) p[i] = (v >> (i * 8)) & 0xFF;
+}
+
+static void fill_random(unsigned char *buf, size_t len, uint64_t *state)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        uint64_t x = *state;              // xorshift64
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        *state = x;
+        buf[i] = (unsigned char)(x >> 32);
+    }
+}
+
+/* 24-bit BMP with room for payload bytes at depth 1, written to fd */
+static Status write_cover(int fd, long payload)
+{
+    unsigned char header[STEGO_BMP_HEADER] = { 'B', 'M' };
+    long row = LOADGEN_WIDTH * 3;
+    long height = (8 * (payload + STEGO_HEADER_MAX / 8) + row - 1) / row + 1;
+    long size = STEGO_BMP_HEADER + row * height;
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+
+    put_le(header + 2, (uint32_t)size, 4);            // bfSize
+    put_le(header + 10, STEGO_BMP_HEADER, 4);         // bfOffBits
+    put_le(header + 14, 40, 4);                       // BITMAPINFOHEADER
+    put_le(header + 18, LOADGEN_WIDTH, 4);
+    put_le(header + 22, (uint32_t)height, 4);
+    put_le(header + 26, 1, 2);                        // planes
+    put_le(header + 28, 24, 2);                       // bits per pixel
+    put_le(header + 34, (uint32_t)(row * height), 4); // biSizeImage
+
+    unsigned char *buf = malloc(size);
+    if (!buf) return e_failure;
+    memcpy(buf, header, sizeof(header));
+    fill_random(buf + sizeof(header), size - sizeof(header), &seed);
+    Status ret = write_all_at(fd, buf, size, 0);
+    if (ret == e_success && ftruncate(fd, size) != 0) ret = e_failure;
+    free(buf);
+    return ret;
+}
+
+static int memfd_with(long payload, int cover)
+{
+    int fd = memfd_create(cover ? "cover" : "secret", MFD_CLOEXEC);
+    if (fd < 0) return -1;
+    if (cover)
+    {
+        if (write_cover(fd, payload) != e_success) goto fail;
+    }
+    else if (payload)
+    {
+        unsigned char *buf = malloc(payload);
+        uint64_t seed = 0x2545F4914F6CDD1DULL;
+        if (!buf) goto fail;
+        fill_random(buf, payload, &seed);
+        Status ret = write_all_at(fd, buf, payload, 0);
+        free(buf);
+        if (ret != e_success) goto fail;
+    }
+    return fd;
+
+fail:
+    close(fd);
+    return -1;
+}
+
+static int cmp_long(const void *a, const void *b)
+{
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+static void usage(void)
+{
+    printf("Usage: ./stego_loadgen --socket PATH [--op encode|decode|probe] [--clients N]\n");
+    printf("                       [--requests N] [--pipeline N] [--payload BYTES]\n");
+    printf("                       [--dir DIR] [--fd]\n");
+    printf("--requests is per client. Covers are written to DIR (default /tmp) so the\n");
+    printf("daemon caches them; --fd sends the cover as a memfd instead (no cache).\n");
+}
+
+/************************************************************
+ * Function: main
+ ************************************************************/
+int main(int argc, char *argv[])
+{
+    const char *socket_path = NULL, *op = "encode", *dir = "/tmp";
+    int clients = 4, requests = 1000, pipeline = 4, send_cover = 0;
+    long payload = 4096;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!strcmp(argv[i], "--fd")) send_cover = 1;
+        else if (!val) { usage(); return 1; }
+        else if (!strcmp(argv[i], "--socket")) socket_path = argv[++i];
+        else if (!strcmp(argv[i], "--op")) op = argv[++i];
+        else if (!strcmp(argv[i], "--dir")) dir = argv[++i];
+        else if (!strcmp(argv[i], "--clients")) clients = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--requests")) requests = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--pipeline")) pipeline = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--payload")) payload = atol(argv[++i]);
+        else { usage(); return 1; }
+    }
+    if (!socket_path || clients < 1 || requests < 1 || pipeline < 1 || pipeline > LOADGEN_PIPELINE_MAX ||
+        payload < 0 || (strcmp(op, "encode") && strcmp(op, "decode") && strcmp(op, "probe")))
+    {
+        usage();
+        return 1;
+    }
+
+    /* the cover on disk, and for decode / probe a stego image made from it once */
+    char cover[512], stego[512], request[LOADGEN_MSG_MAX];
+    snprintf(cover, sizeof(cover), "%s/stego_loadgen_%d_cover.bmp", dir, (int)getpid());
+    snprintf(stego, sizeof(stego), "%s/stego_loadgen_%d_stego.bmp", dir, (int)getpid());
+    int cover_fd = open(cover, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (cover_fd < 0 || write_cover(cover_fd, payload) != e_success)
+    {
+        fprintf(stderr, "[ERROR] Cannot write %s\n", cover);
+        return 1;
+    }
+
+    Client *cl = calloc(clients, sizeof(*cl));
+    pthread_t *tid = calloc(clients, sizeof(*tid));
+    int ret = 0;
+    if (!cl || !tid) return 1;
+
+    if (strcmp(op, "encode") != 0)
+    {
+        Client setup = { .socket_path = socket_path, .request = request, .requests = 1, .pipeline = 1 };
+        long latency;
+        setup.latency_ns = &latency;
+        setup.fds[setup.nfds++] = memfd_with(payload, 0);
+        snprintf(request, sizeof(request), "-e %s @0 %s", cover, stego);
+        client_main(&setup);
+        close(setup.fds[0]);
+        if (setup.errors)
+        {
+            fprintf(stderr, "[ERROR] Cannot make the stego image\n");
+            unlink(cover);
+            return 1;
+        }
+    }
+
+    /* request lines: encode sends [secret, output] (+ cover with --fd), decode [output] */
+    for (int i = 0; i < clients; i++)
+    {
+        Client *c = &cl[i];
+        c->socket_path = socket_path;
+        c->request = request;
+        c->requests = requests;
+        c->pipeline = pipeline;
+        c->latency_ns = calloc(requests, sizeof(long));
+        if (!strcmp(op, "encode"))
+        {
+            c->fds[c->nfds++] = memfd_with(payload, 0);
+            c->fds[c->nfds++] = memfd_create("out", MFD_CLOEXEC);
+            if (send_cover) c->fds[c->nfds++] = memfd_with(payload, 1);
+        }
+        else if (!strcmp(op, "decode"))
+        {
+            c->fds[c->nfds++] = memfd_create("out", MFD_CLOEXEC);
+        }
+        for (int k = 0; k < c->nfds; k++) if (c->fds[k] < 0) ret = 1;
+        if (!c->latency_ns) ret = 1;
+    }
+    if (!strcmp(op, "encode"))
+        snprintf(request, sizeof(request), send_cover ? "-e @2 @0 @1" : "-e %s @0 @1", cover);
+    else if (!strcmp(op, "decode"))
+        snprintf(request, sizeof(request), "-d %s @0", stego);
+    else
+        snprintf(request, sizeof(request), "-p %s", stego);
+
+    int64_t start = now_ns();
+    int started = 0;
+    while (!ret && started < clients && pthread_create(&tid[started], NULL, client_main, &cl[started]) == 0)
+        started++;
+    for (int i = 0; i < started; i++) pthread_join(tid[i], NULL);
+    double seconds = (now_ns() - start) / 1e9;
+
+    /* every latency of every client, sorted for the percentiles */
+    long total = (long)started * requests, errors = 0;
+    long *all = malloc((total ? total : 1) * sizeof(long));
+    for (int i = 0; all && i < started; i++)
+    {
+        memcpy(all + (long)i * requests, cl[i].latency_ns, requests * sizeof(long));
+        errors += cl[i].errors;
+    }
+    if (all && total)
+    {
+        qsort(all, total, sizeof(long), cmp_long);
+        printf("{\"op\":\"%s\",\"clients\":%d,\"pipeline\":%d,\"payload\":%ld,\"cover_fd\":%d,"
+               "\"requests\":%ld,\"errors\":%ld,\"seconds\":%.3f,\"rps\":%.1f,"
+               "\"p50_us\":%.1f,\"p90_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f}\n",
+               op, clients, pipeline, payload, send_cover, total, errors, seconds, total / seconds,
+               all[total / 2] / 1e3, all[total * 9 / 10] / 1e3, all[total * 99 / 100] / 1e3,
+               all[total - 1] / 1e3);
+    }
+    if (!all || !total || errors) ret = 1;
+
+    for (int i = 0; i < clients; i++)
+    {
+        for (int k = 0; k < cl[i].nfds; k++) if (cl[i].fds[k] >= 0) close(cl[i].fds[k]);
+        free(cl[i].latency_ns);
+    }
+    free(all);
+    free(cl);
+    free(tid);
+    close(cover_fd);
+    unlink(cover);
+    unlink(stego);
+    return ret;
+}
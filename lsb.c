@@ -0,0 +1,526 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "lsb.h"
+#include "types.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LSB_X86 1
+#include <immintrin.h>
+#endif
+
+/* ===================== SCALAR REFERENCE KERNEL ===================== */
+static void embed_scalar(unsigned char *out, const unsigned char *cover,
+                         const unsigned char *payload, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        for (int j = 0; j < 8; j++)
+        {
+            out[i * 8 + j] = (cover[i * 8 + j] & ~1) | ((payload[i] >> j) & 1);
+        }
+    }
+}
+
+static void extract_scalar(unsigned char *out, const unsigned char *cover, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        unsigned char ch = 0;
+        for (int j = 0; j < 8; j++)
+        {
+            ch |= (cover[i * 8 + j] & 1) << j;
+        }
+        out[i] = ch;
+    }
+}
+
+/* ===================== SWAR / LOOKUP TABLE KERNEL ===================== */
+/* lsb_spread[p] holds the 8 bits of p spread over 8 bytes (bit j → byte j),
+   laid out in memory order so it works on any endianness */
+static uint64_t lsb_spread[256];
+
+static void build_spread_table(void)
+{
+    for (int p = 0; p < 256; p++)
+    {
+        unsigned char bytes[8];
+        for (int j = 0; j < 8; j++)
+            bytes[j] = (p >> j) & 1;
+        memcpy(&lsb_spread[p], bytes, 8);
+    }
+}
+
+static void embed_swar(unsigned char *out, const unsigned char *cover,
+                       const unsigned char *payload, size_t n)
+{
+    const uint64_t keep = 0xFEFEFEFEFEFEFEFEULL;   // clear LSB of every byte
+
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t c;
+        memcpy(&c, cover + i * 8, 8);
+        c = (c & keep) | lsb_spread[payload[i]];
+        memcpy(out + i * 8, &c, 8);
+    }
+}
+
+static void extract_swar(unsigned char *out, const unsigned char *cover, size_t n)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    /* gather the LSB of byte j into bit 56+j with one multiply */
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t c;
+        memcpy(&c, cover + i * 8, 8);
+        c &= 0x0101010101010101ULL;
+        out[i] = (unsigned char)((c * 0x0102040810204080ULL) >> 56);
+    }
+#else
+    extract_scalar(out, cover, n);
+#endif
+}
+
+#ifdef LSB_X86
+/* ===================== SSE2 KERNEL: 8 payload bytes → 64 cover bytes ===================== */
+__attribute__((target("sse2")))
+static void embed_sse2(unsigned char *out, const unsigned char *cover,
+                       const unsigned char *payload, size_t n)
+{
+    const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                       1, 2, 4, 8, 16, 32, 64, -128);
+    const __m128i keep = _mm_set1_epi8((char)0xFE);
+    const __m128i one  = _mm_set1_epi8(1);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        /* widen every payload byte to 8 copies: p0p0p1p1.. → p0x4.. → p0x8.. */
+        __m128i p  = _mm_loadl_epi64((const __m128i *)(payload + i));
+        __m128i a  = _mm_unpacklo_epi8(p, p);
+        __m128i lo = _mm_unpacklo_epi16(a, a);
+        __m128i hi = _mm_unpackhi_epi16(a, a);
+        __m128i v[4] = {
+            _mm_unpacklo_epi32(lo, lo), _mm_unpackhi_epi32(lo, lo),
+            _mm_unpacklo_epi32(hi, hi), _mm_unpackhi_epi32(hi, hi)
+        };
+
+        for (int k = 0; k < 4; k++)
+        {
+            /* byte j keeps only bit j of its payload byte, as 0 or 1 */
+            __m128i b = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(v[k], bits), bits), one);
+            __m128i c = _mm_loadu_si128((const __m128i *)(cover + i * 8 + k * 16));
+            _mm_storeu_si128((__m128i *)(out + i * 8 + k * 16),
+                             _mm_or_si128(_mm_and_si128(c, keep), b));
+        }
+    }
+
+    embed_swar(out + i * 8, cover + i * 8, payload + i, n - i);
+}
+
+/* shift every LSB up to bit 7 and collect the top bits: 64 cover bytes → 8 payload bytes */
+__attribute__((target("sse2")))
+static void extract_sse2(unsigned char *out, const unsigned char *cover, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        for (int k = 0; k < 4; k++)
+        {
+            __m128i c = _mm_loadu_si128((const __m128i *)(cover + i * 8 + k * 16));
+            uint16_t m = (uint16_t)_mm_movemask_epi8(_mm_slli_epi16(c, 7));
+            memcpy(out + i + k * 2, &m, 2);
+        }
+    }
+
+    extract_swar(out + i, cover + i * 8, n - i);
+}
+
+/* ===================== AVX2 KERNEL: 8 payload bytes → 64 cover bytes ===================== */
+__attribute__((target("avx2")))
+static void embed_avx2(unsigned char *out, const unsigned char *cover,
+                       const unsigned char *payload, size_t n)
+{
+    /* pshufb works per 128-bit lane; broadcasting 4 payload bytes
+       lets the low lane pick bytes 0,1 and the high lane bytes 2,3 */
+    const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0,
+                                            1, 1, 1, 1, 1, 1, 1, 1,
+                                            2, 2, 2, 2, 2, 2, 2, 2,
+                                            3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128);
+    const __m256i keep = _mm256_set1_epi8((char)0xFE);
+    const __m256i one  = _mm256_set1_epi8(1);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        for (int k = 0; k < 2; k++)
+        {
+            int32_t w;
+            memcpy(&w, payload + i + k * 4, 4);
+
+            __m256i v = _mm256_shuffle_epi8(_mm256_set1_epi32(w), spread);
+            __m256i b = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(v, bits), bits), one);
+            __m256i c = _mm256_loadu_si256((const __m256i *)(cover + i * 8 + k * 32));
+            _mm256_storeu_si256((__m256i *)(out + i * 8 + k * 32),
+                                _mm256_or_si256(_mm256_and_si256(c, keep), b));
+        }
+    }
+
+    embed_swar(out + i * 8, cover + i * 8, payload + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void extract_avx2(unsigned char *out, const unsigned char *cover, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(cover + i * 8));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(cover + i * 8 + 32));
+        uint32_t lo = (uint32_t)_mm256_movemask_epi8(_mm256_slli_epi16(a, 7));
+        uint32_t hi = (uint32_t)_mm256_movemask_epi8(_mm256_slli_epi16(b, 7));
+        memcpy(out + i, &lo, 4);
+        memcpy(out + i + 4, &hi, 4);
+    }
+
+    extract_swar(out + i, cover + i * 8, n - i);
+}
+#endif
+
+/* ===================== DEPTH 2..4: SEVERAL LSBs PER COVER BYTE ===================== */
+/* Payload byte i uses LSB_CARRIERS(depth) cover bytes; cover byte j holds bits
+   [j*depth, j*depth + depth) of it (depth 3: 3 + 3 + 2 bits) */
+static void embed_depth_scalar(int depth, unsigned char *out, const unsigned char *cover,
+                               const unsigned char *payload, size_t n)
+{
+    int per = LSB_CARRIERS(depth);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        for (int j = 0; j < per; j++)
+        {
+            int shift = j * depth;
+            int bits = (8 - shift < depth) ? 8 - shift : depth;
+            unsigned char mask = (1 << bits) - 1;
+            out[i * per + j] = (cover[i * per + j] & ~mask) | ((payload[i] >> shift) & mask);
+        }
+    }
+}
+
+static void extract_depth_scalar(int depth, unsigned char *out, const unsigned char *cover,
+                                 size_t n)
+{
+    int per = LSB_CARRIERS(depth);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        unsigned char ch = 0;
+        for (int j = 0; j < per; j++)
+        {
+            int shift = j * depth;
+            int bits = (8 - shift < depth) ? 8 - shift : depth;
+            ch |= (cover[i * per + j] & ((1 << bits) - 1)) << shift;
+        }
+        out[i] = ch;
+    }
+}
+
+/* lsb_spread2[p]: the 4 bit pairs of p in 4 bytes, memory order */
+static uint32_t lsb_spread2[256];
+
+static void build_spread2_table(void)
+{
+    for (int p = 0; p < 256; p++)
+    {
+        unsigned char bytes[4];
+        for (int j = 0; j < 4; j++)
+            bytes[j] = (p >> (j * 2)) & 3;
+        memcpy(&lsb_spread2[p], bytes, 4);
+    }
+}
+
+/* depth 2: one 32-bit word of cover per payload byte */
+static void embed_d2(unsigned char *out, const unsigned char *cover,
+                     const unsigned char *payload, size_t n)
+{
+    const uint32_t keep = 0xFCFCFCFCu;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        uint32_t c;
+        memcpy(&c, cover + i * 4, 4);
+        c = (c & keep) | lsb_spread2[payload[i]];
+        memcpy(out + i * 4, &c, 4);
+    }
+}
+
+static void extract_d2(unsigned char *out, const unsigned char *cover, size_t n)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (size_t i = 0; i < n; i++)
+    {
+        uint32_t c;
+        memcpy(&c, cover + i * 4, 4);
+        c &= 0x03030303u;
+        c = (c | (c >> 6)) & 0x000F000Fu;      // pairs → nibbles
+        out[i] = (unsigned char)(c | (c >> 12));
+    }
+#else
+    extract_depth_scalar(2, out, cover, n);
+#endif
+}
+
+/* depth 3: 3 + 3 + 2 bits, unrolled */
+static void embed_d3(unsigned char *out, const unsigned char *cover,
+                     const unsigned char *payload, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        unsigned char p = payload[i];
+        out[i * 3]     = (cover[i * 3] & ~7) | (p & 7);
+        out[i * 3 + 1] = (cover[i * 3 + 1] & ~7) | ((p >> 3) & 7);
+        out[i * 3 + 2] = (cover[i * 3 + 2] & ~3) | (p >> 6);
+    }
+}
+
+static void extract_d3(unsigned char *out, const unsigned char *cover, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = (cover[i * 3] & 7) | ((cover[i * 3 + 1] & 7) << 3) | ((cover[i * 3 + 2] & 3) << 6);
+}
+
+/* depth 4: low nibble, then high nibble */
+static void embed_d4(unsigned char *out, const unsigned char *cover,
+                     const unsigned char *payload, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i * 2]     = (cover[i * 2] & 0xF0) | (payload[i] & 0x0F);
+        out[i * 2 + 1] = (cover[i * 2 + 1] & 0xF0) | (payload[i] >> 4);
+    }
+}
+
+static void extract_d4(unsigned char *out, const unsigned char *cover, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = (cover[i * 2] & 0x0F) | (cover[i * 2 + 1] << 4);
+}
+
+#ifdef LSB_X86
+/* 16 payload bytes → 32 cover bytes: split nibbles, interleave */
+__attribute__((target("sse2")))
+static void embed_d4_sse2(unsigned char *out, const unsigned char *cover,
+                          const unsigned char *payload, size_t n)
+{
+    const __m128i low = _mm_set1_epi8(0x0F);
+    const __m128i high = _mm_set1_epi8((char)0xF0);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i p = _mm_loadu_si128((const __m128i *)(payload + i));
+        __m128i lo = _mm_and_si128(p, low);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(p, 4), low);
+        __m128i c0 = _mm_loadu_si128((const __m128i *)(cover + i * 2));
+        __m128i c1 = _mm_loadu_si128((const __m128i *)(cover + i * 2 + 16));
+        _mm_storeu_si128((__m128i *)(out + i * 2),
+                         _mm_or_si128(_mm_and_si128(c0, high), _mm_unpacklo_epi8(lo, hi)));
+        _mm_storeu_si128((__m128i *)(out + i * 2 + 16),
+                         _mm_or_si128(_mm_and_si128(c1, high), _mm_unpackhi_epi8(lo, hi)));
+    }
+
+    embed_d4(out + i * 2, cover + i * 2, payload + i, n - i);
+}
+
+/* each 16-bit lane holds (odd << 8 | even) nibbles; fold to even | odd << 4 and pack */
+__attribute__((target("sse2")))
+static void extract_d4_sse2(unsigned char *out, const unsigned char *cover, size_t n)
+{
+    const __m128i low = _mm_set1_epi8(0x0F);
+    const __m128i byte = _mm_set1_epi16(0x00FF);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i *)(cover + i * 2)), low);
+        __m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i *)(cover + i * 2 + 16)), low);
+        a = _mm_and_si128(_mm_or_si128(a, _mm_srli_epi16(a, 4)), byte);
+        b = _mm_and_si128(_mm_or_si128(b, _mm_srli_epi16(b, 4)), byte);
+        _mm_storeu_si128((__m128i *)(out + i), _mm_packus_epi16(a, b));
+    }
+
+    extract_d4(out + i, cover + i * 2, n - i);
+}
+#endif
+
+/* ===================== KERNEL SELECTION AT STARTUP ===================== */
+typedef void (*embed_fn)(unsigned char *, const unsigned char *, const unsigned char *, size_t);
+typedef void (*extract_fn)(unsigned char *, const unsigned char *, size_t);
+
+typedef struct
+{
+    const char *name;
+    embed_fn embed;
+    extract_fn extract;
+} LsbImpl;
+
+static const LsbImpl impl_scalar = { "scalar", embed_scalar, extract_scalar };
+static const LsbImpl impl_swar   = { "swar",   embed_swar,   extract_swar };
+#ifdef LSB_X86
+static const LsbImpl impl_sse2   = { "sse2",   embed_sse2,   extract_sse2 };
+static const LsbImpl impl_avx2   = { "avx2",   embed_avx2,   extract_avx2 };
+#endif
+
+static const LsbImpl *impl = &impl_scalar;
+
+/* Kernels for depth 1..4; depth 1 is whatever impl picked */
+static embed_fn depth_embed[LSB_MAX_DEPTH + 1] = { NULL, NULL, embed_d2, embed_d3, embed_d4 };
+static extract_fn depth_extract[LSB_MAX_DEPTH + 1] = { NULL, NULL, extract_d2, extract_d3, extract_d4 };
+
+/* Same check for the depth 2..4 kernels */
+static Status check_depths(void)
+{
+    enum { N = 259 };
+    unsigned char payload[N], cover[N * 8];
+    unsigned char want[N * 8], got[N * 8];
+    unsigned char got_x[N];
+    uint32_t seed = 0x85EBCA6Bu;
+
+    for (size_t i = 0; i < sizeof(cover); i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        cover[i] = seed >> 24;
+        if (i < N) payload[i] = seed >> 16;
+    }
+
+    for (int depth = 2; depth <= LSB_MAX_DEPTH; depth++)
+    {
+        size_t span = (size_t)N * LSB_CARRIERS(depth);
+        embed_depth_scalar(depth, want, cover, payload, N);
+        depth_embed[depth](got, cover, payload, N);
+        if (memcmp(want, got, span) != 0) return e_failure;
+
+        depth_extract[depth](got_x, got, N);
+        if (memcmp(payload, got_x, N) != 0) return e_failure;
+        extract_depth_scalar(depth, got_x, want, N);
+        if (memcmp(payload, got_x, N) != 0) return e_failure;
+    }
+    return e_success;
+}
+
+/* Run one implementation against the scalar reference on a fixed pseudo-random block */
+static Status check_impl(const LsbImpl *candidate)
+{
+    enum { N = 259 };                  // odd size so the tail paths run too
+    unsigned char payload[N], cover[N * 8];
+    unsigned char want[N * 8], got[N * 8];
+    unsigned char want_x[N], got_x[N];
+    uint32_t seed = 0x9E3779B9u;
+
+    for (size_t i = 0; i < sizeof(cover); i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        cover[i] = seed >> 24;
+        if (i < N) payload[i] = seed >> 16;
+    }
+
+    embed_scalar(want, cover, payload, N);
+    candidate->embed(got, cover, payload, N);
+    if (memcmp(want, got, sizeof(want)) != 0) return e_failure;
+
+    extract_scalar(want_x, cover, N);
+    candidate->extract(got_x, cover, N);
+    if (memcmp(want_x, got_x, sizeof(want_x)) != 0) return e_failure;
+
+    candidate->extract(got_x, got, N);   // round trip must give the payload back
+    if (memcmp(payload, got_x, sizeof(payload)) != 0) return e_failure;
+
+    return e_success;
+}
+
+__attribute__((constructor))
+static void lsb_select(void)
+{
+    const char *force = getenv("STEGO_LSB");
+
+    build_spread_table();
+    build_spread2_table();
+    impl = &impl_swar;
+
+#ifdef LSB_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) impl = &impl_sse2;
+    if (__builtin_cpu_supports("avx2")) impl = &impl_avx2;
+    if (__builtin_cpu_supports("sse2") && (!force || !strcmp(force, "sse2")))
+    {
+        depth_embed[4] = embed_d4_sse2;
+        depth_extract[4] = extract_d4_sse2;
+    }
+#endif
+
+    if (force)
+    {
+        if (!strcmp(force, "scalar")) impl = &impl_scalar;
+        else if (!strcmp(force, "swar")) impl = &impl_swar;
+#ifdef LSB_X86
+        else if (!strcmp(force, "sse2") && __builtin_cpu_supports("sse2")) impl = &impl_sse2;
+#endif
+    }
+
+#ifndef NDEBUG
+    if (check_impl(impl) != e_success)
+    {
+        fprintf(stderr, "[WARN] LSB kernel '%s' failed self check, using scalar\n", impl->name);
+        impl = &impl_scalar;
+    }
+    if (check_depths() != e_success)
+    {
+        fprintf(stderr, "[WARN] LSB depth kernels failed self check, using scalar\n");
+        depth_embed[4] = embed_d4;
+        depth_extract[4] = extract_d4;
+    }
+#endif
+}
+
+/* ===================== PUBLIC ENTRY POINTS ===================== */
+void lsb_embed(unsigned char *out, const unsigned char *cover,
+               const unsigned char *payload, size_t n)
+{
+    impl->embed(out, cover, payload, n);
+}
+
+void lsb_extract(unsigned char *out, const unsigned char *cover, size_t n)
+{
+    impl->extract(out, cover, n);
+}
+
+void lsb_embed_depth(int depth, unsigned char *out, const unsigned char *cover,
+                     const unsigned char *payload, size_t n)
+{
+    if (depth <= 1) impl->embed(out, cover, payload, n);
+    else depth_embed[depth](out, cover, payload, n);
+}
+
+void lsb_extract_depth(int depth, unsigned char *out, const unsigned char *cover, size_t n)
+{
+    if (depth <= 1) impl->extract(out, cover, n);
+    else depth_extract[depth](out, cover, n);
+}
+
+const char *lsb_impl_name(void)
+{
+    return impl->name;
+}
+
+Status lsb_self_check(void)
+{
+    if (check_impl(impl) != e_success) return e_failure;
+    return check_depths();
+}
@@ -0,0 +1,46 @@
+#ifndef LSB_H
+#define LSB_H
+
+#include <stddef.h>   // size_t
+#include "types.h"    // Status
+
+/* Number of secret bytes handled per block by the encode/decode loops
+   (the matching cover block is 8 times larger) */
+#define LSB_BLOCK_SIZE 4096
+
+/*----------------------------------------------------------
+    LSB embed / extract kernels
+    The implementation (avx2, sse2, swar or scalar) is picked once at
+    startup from CPUID. Setting STEGO_LSB=<name> in the environment
+    forces a specific one, which is handy for comparing outputs.
+----------------------------------------------------------*/
+
+/* Hide n payload bytes in the LSBs of 8*n cover bytes, bit 0 first.
+   out and cover may point to the same buffer. */
+void lsb_embed(unsigned char *out, const unsigned char *cover,
+               const unsigned char *payload, size_t n);
+
+/* Rebuild n payload bytes from the LSBs of 8*n cover bytes */
+void lsb_extract(unsigned char *out, const unsigned char *cover, size_t n);
+
+/* Deepest setting of lsb_embed_depth: LSBs used in every cover byte */
+#define LSB_MAX_DEPTH 4
+
+/* Cover bytes per payload byte at a depth: 8, 4, 3 (3 + 3 + 2 bits), 2 */
+#define LSB_CARRIERS(depth) ((8 + (depth) - 1) / (depth))
+
+/* Like lsb_embed / lsb_extract with depth (1..LSB_MAX_DEPTH) low bits per
+   cover byte; payload byte i uses cover bytes [i*c, i*c + c) with
+   c = LSB_CARRIERS(depth), low bits first. Depth 1 is lsb_embed. */
+void lsb_embed_depth(int depth, unsigned char *out, const unsigned char *cover,
+                     const unsigned char *payload, size_t n);
+void lsb_extract_depth(int depth, unsigned char *out, const unsigned char *cover, size_t n);
+
+/* Name of the kernel currently in use */
+const char *lsb_impl_name(void);
+
+/* Compare the kernel in use with the scalar reference (also run at
+   startup unless built with -DNDEBUG) */
+Status lsb_self_check(void);
+
+#endif // LSB_H
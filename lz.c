@@ -0,0 +1,347 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "lz.h"
+
+#define LZ_HASH_BITS 16             // match finder: one position per 4-byte hash
+#define LZ_SKIP_SHIFT 6             // after 2^6 misses in a row, start skipping ahead
+#define LZ_FLUSH (1 << 16)          // decoder output gathered before each sink call
+#define LZ_SLACK 16                 // decoder history tail written over by wild copies
+
+/* ===================== COMPRESSOR ===================== */
+static uint32_t read32(const unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static uint64_t read64(const unsigned char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static uint32_t hash4(uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* Rest of a length that did not fit its nibble: 255s, then the remainder */
+static unsigned char *put_length(unsigned char *op, unsigned char *end, size_t len)
+{
+    for (; len >= 255; len -= 255)
+    {
+        if (op >= end) return NULL;
+        *op++ = 255;
+    }
+    if (op >= end) return NULL;
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+/* One sequence; match_len 0 ends the stream after the literals */
+static unsigned char *put_sequence(unsigned char *op, unsigned char *end,
+                                   const unsigned char *lit, size_t lit_len,
+                                   size_t offset, size_t match_len)
+{
+    size_t extra = match_len ? match_len - LZ_MIN_MATCH : 0;
+
+    if (op >= end) return NULL;
+    *op++ = (unsigned char)(((lit_len < 15 ? lit_len : 15) << 4) | (extra < 15 ? extra : 15));
+    if (lit_len >= 15 && !(op = put_length(op, end, lit_len - 15))) return NULL;
+    if ((size_t)(end - op) < lit_len) return NULL;
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+    if (!match_len) return op;
+
+    if (end - op < 2) return NULL;
+    *op++ = offset & 0xFF;
+    *op++ = offset >> 8;
+    if (extra >= 15 && !(op = put_length(op, end, extra - 15))) return NULL;
+    return op;
+}
+
+/* Length of the common prefix of a and b, at most max bytes; 8 at a time */
+static size_t common_length(const unsigned char *a, const unsigned char *b, size_t max)
+{
+    size_t len = 0;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; len + 8 <= max; len += 8)
+    {
+        uint64_t diff = read64(a + len) ^ read64(b + len);
+        if (diff) return len + (__builtin_ctzll(diff) >> 3);   // first differing byte
+    }
+#endif
+    while (len < max && a[len] == b[len]) len++;
+    return len;
+}
+
+size_t lz_compress(const unsigned char *src, size_t n, unsigned char *dst, size_t cap)
+{
+    /* low 32 bits of positions: only distances below LZ_WINDOW are ever used */
+    uint32_t *table = calloc((size_t)1 << LZ_HASH_BITS, sizeof(*table));
+    unsigned char *op = dst, *end = dst + cap;
+    size_t anchor = 0, i = 0, misses = 0;
+
+    if (!table) return 0;
+
+    /* greedy: take the first earlier match of at least 4 bytes and extend it */
+    while (op && i + LZ_MIN_MATCH <= n)
+    {
+        uint32_t seq = read32(src + i);
+        uint32_t h = hash4(seq);
+        size_t dist = (uint32_t)i - table[h];
+        table[h] = (uint32_t)i;
+
+        if (dist > 0 && dist < LZ_WINDOW && dist <= i && read32(src + i - dist) == seq)
+        {
+            size_t len = LZ_MIN_MATCH + common_length(src + i - dist + LZ_MIN_MATCH,
+                                                      src + i + LZ_MIN_MATCH,
+                                                      n - i - LZ_MIN_MATCH);
+
+            op = put_sequence(op, end, src + anchor, i - anchor, dist, len);
+            i += len;
+            anchor = i;
+            misses = 0;
+            if (i + 2 <= n) table[hash4(read32(src + i - 2))] = (uint32_t)(i - 2);   // seed the next search
+        }
+        else
+        {
+            i += 1 + (misses++ >> LZ_SKIP_SHIFT);   // incompressible input: look less often
+        }
+    }
+    if (op) op = put_sequence(op, end, src + anchor, n - anchor, 0, 0);
+
+    free(table);
+    return op ? (size_t)(op - dst) : 0;
+}
+
+/* ===================== STREAMING DECODER ===================== */
+enum { LZ_TOKEN, LZ_LITERAL_LEN, LZ_LITERALS, LZ_OFFSET_LO, LZ_OFFSET_HI, LZ_MATCH_LEN };
+
+Status lz_decoder_init(LzDecoder *d, int64_t limit, LzSink sink, void *ctx)
+{
+    memset(d, 0, sizeof(*d));
+    d->hist = malloc(LZ_WINDOW + LZ_FLUSH + LZ_SLACK);
+    if (!d->hist) return e_failure;
+
+    d->state = LZ_TOKEN;
+    d->limit = limit;
+    d->sink = sink;
+    d->ctx = ctx;
+    return e_success;
+}
+
+/* Room for n (<= LZ_FLUSH) more bytes: hand new output to the sink, keep the window */
+static Status make_room(LzDecoder *d, size_t n)
+{
+    if (d->have + n <= LZ_WINDOW + LZ_FLUSH) return e_success;
+
+    Status ret = d->sink(d->ctx, d->hist + d->sent, d->have - d->sent);
+    if (ret != e_success) return ret;
+    memmove(d->hist, d->hist + d->have - LZ_WINDOW, LZ_WINDOW);
+    d->have = d->sent = LZ_WINDOW;
+    return e_success;
+}
+
+static Status put_literals(LzDecoder *d, const unsigned char *in, size_t n)
+{
+    while (n > 0)
+    {
+        size_t piece = (n > LZ_FLUSH) ? LZ_FLUSH : n;
+        Status ret = make_room(d, piece);
+        if (ret != e_success) return ret;
+
+        memcpy(d->hist + d->have, in, piece);
+        d->have += piece;
+        d->produced += piece;
+        in += piece;
+        n -= piece;
+    }
+    return e_success;
+}
+
+/* Copy len bytes 16 at a time: may read and write up to 15 bytes past len */
+static void wild_copy(unsigned char *dst, const unsigned char *src, size_t len)
+{
+    for (size_t i = 0; i < len; i += 16) memcpy(dst + i, src + i, 16);
+}
+
+/* Copy len bytes from offset back, which may overlap the bytes being written
+   (a run with period offset). Writes up to 15 bytes past len. */
+static void match_copy(unsigned char *op, size_t offset, size_t len)
+{
+    if (offset >= 16)
+    {
+        wild_copy(op, op - offset, len);
+        return;
+    }
+
+    /* short period: lay down 16 bytes, then copy from a multiple of the period >= 16 back */
+    for (size_t i = 0; i < 16; i++) op[i] = op[i - offset];
+    if (len > 16)
+    {
+        size_t step = (16 + offset - 1) / offset * offset;
+        wild_copy(op + 16, op + 16 - step, len - 16);
+    }
+}
+
+static Status copy_match(LzDecoder *d)
+{
+    size_t len = d->match;
+
+    if (d->offset == 0 || (int64_t)d->offset > d->produced) return e_bad_data;
+    if (d->produced + (int64_t)len > d->limit) return e_bad_data;
+
+    while (len > 0)
+    {
+        size_t piece = (len > LZ_FLUSH) ? LZ_FLUSH : len;
+        Status ret = make_room(d, piece);
+        if (ret != e_success) return ret;
+
+        match_copy(d->hist + d->have, d->offset, piece);
+
+        d->have += piece;
+        d->produced += piece;
+        len -= piece;
+    }
+    d->state = LZ_TOKEN;
+    return e_success;
+}
+
+/* Whole sequences while the input holds them, without the per-byte states;
+   stops at the first one that is split (or the last one, which has no offset) */
+static Status decode_sequences(LzDecoder *d, const unsigned char **pin, const unsigned char *end)
+{
+    const unsigned char *in = *pin;
+    Status ret = e_success;
+
+    while (ret == e_success && end - in >= 16)
+    {
+        const unsigned char *p = in;
+        size_t literals = *p >> 4, match = (*p & 15) + LZ_MIN_MATCH;
+        unsigned b;
+
+        p++;
+        if (literals == 15)
+            do { if (p >= end) goto split; literals += b = *p++; } while (b == 255);
+        if ((size_t)(end - p) < literals + 2) break;
+
+        const unsigned char *lit = p;
+        p += literals;
+        d->offset = p[0] | (size_t)p[1] << 8;
+        p += 2;
+        if (match == 15 + LZ_MIN_MATCH)
+            do { if (p >= end) goto split; match += b = *p++; } while (b == 255);
+
+        in = p;
+        if (d->have + literals + match > LZ_WINDOW + LZ_FLUSH)
+        {
+            /* needs a flush first: take the careful route */
+            if (d->produced + (int64_t)literals > d->limit) return e_bad_data;
+            if ((ret = put_literals(d, lit, literals)) != e_success) break;
+            d->match = match;
+            ret = copy_match(d);
+            continue;
+        }
+
+        if (d->offset == 0 || (int64_t)d->offset > d->produced + (int64_t)literals ||
+            d->produced + (int64_t)(literals + match) > d->limit)
+            return e_bad_data;
+
+        unsigned char *op = d->hist + d->have;
+        if (literals + 16 <= (size_t)(end - lit)) wild_copy(op, lit, literals);
+        else memcpy(op, lit, literals);
+        op += literals;
+
+        match_copy(op, d->offset, match);
+
+        d->have += literals + match;
+        d->produced += literals + match;
+    }
+split:
+    *pin = in;
+    return ret;
+}
+
+Status lz_decode(LzDecoder *d, const unsigned char *in, size_t n)
+{
+    const unsigned char *end = in + n;
+    Status ret;
+
+    while (in < end)
+    {
+        if (d->state == LZ_TOKEN)
+        {
+            if ((ret = decode_sequences(d, &in, end)) != e_success) return ret;
+            if (in == end) break;
+        }
+
+        switch (d->state)
+        {
+            case LZ_TOKEN:
+                d->literals = *in >> 4;
+                d->match = (*in & 15) + LZ_MIN_MATCH;
+                in++;
+                d->state = (d->literals == 15) ? LZ_LITERAL_LEN
+                         : d->literals ? LZ_LITERALS : LZ_OFFSET_LO;
+                break;
+
+            case LZ_LITERAL_LEN:
+                d->literals += *in;
+                if (d->produced + (int64_t)d->literals > d->limit) return e_bad_data;
+                if (*in++ != 255) d->state = LZ_LITERALS;
+                break;
+
+            case LZ_LITERALS:
+            {
+                size_t take = (d->literals < (size_t)(end - in)) ? d->literals : (size_t)(end - in);
+                if (d->produced + (int64_t)take > d->limit) return e_bad_data;
+                if ((ret = put_literals(d, in, take)) != e_success) return ret;
+                in += take;
+                d->literals -= take;
+                if (d->literals == 0) d->state = LZ_OFFSET_LO;
+                break;
+            }
+
+            case LZ_OFFSET_LO:
+                d->offset = *in++;
+                d->state = LZ_OFFSET_HI;
+                break;
+
+            case LZ_OFFSET_HI:
+                d->offset |= (size_t)*in++ << 8;
+                if (d->match == 15 + LZ_MIN_MATCH)
+                    d->state = LZ_MATCH_LEN;
+                else if ((ret = copy_match(d)) != e_success)
+                    return ret;
+                break;
+
+            case LZ_MATCH_LEN:
+                d->match += *in;
+                if (d->produced + (int64_t)d->match > d->limit) return e_bad_data;
+                if (*in++ != 255 && (ret = copy_match(d)) != e_success) return ret;
+                break;
+        }
+    }
+    return e_success;
+}
+
+Status lz_decoder_finish(LzDecoder *d)
+{
+    if (d->state != LZ_OFFSET_LO) return e_bad_data;     // the last sequence ends after its literals
+    if (d->have == d->sent) return e_success;
+
+    Status ret = d->sink(d->ctx, d->hist + d->sent, d->have - d->sent);
+    d->sent = d->have;
+    return ret;
+}
+
+void lz_decoder_free(LzDecoder *d)
+{
+    free(d->hist);
+    d->hist = NULL;
+}
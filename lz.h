@@ -0,0 +1,63 @@
+#ifndef LZ_H
+#define LZ_H
+
+#include <stddef.h>   // size_t
+#include <stdint.h>   // int64_t
+#include "types.h"    // Status
+
+/*----------------------------------------------------------
+    Small LZ77 codec for the secret (part of libstego)
+
+    The format is a series of sequences, LZ4 style:
+        token | [literal length bytes] | literals | offset (LE16) | [match length bytes]
+    The high nibble of the token counts literals. The low nibble
+    counts match bytes minus LZ_MIN_MATCH. A nibble of 15 continues
+    in extra bytes that are added until one is not 255. The last
+    sequence stops after its literals. Offsets reach back at most
+    LZ_WINDOW - 1 bytes, so the decoder only keeps that much output.
+----------------------------------------------------------*/
+
+#define LZ_MIN_MATCH 4
+#define LZ_WINDOW 65536
+
+/* Largest output lz_compress can produce for n input bytes */
+#define LZ_COMPRESS_BOUND(n) ((n) + (n) / 255 + 16)
+
+/* Compress n bytes of src into dst (cap bytes). Returns the compressed
+   length, or 0 if it would not fit in cap (or memory ran out). */
+size_t lz_compress(const unsigned char *src, size_t n, unsigned char *dst, size_t cap);
+
+/* Where the decoder hands its output, in order, in pieces of any size */
+typedef Status (*LzSink)(void *ctx, const unsigned char *data, size_t n);
+
+/* Streaming decoder: feed compressed bytes in pieces of any size */
+typedef struct _LzDecoder
+{
+    int state;                       // which part of a sequence comes next
+    size_t literals;                 // literal bytes still to copy
+    size_t match;                    // match length of the current sequence
+    size_t offset;                   // match offset being read
+    unsigned char *hist;             // recent output: LZ_WINDOW history + flush room
+    size_t have;                     // bytes in hist
+    size_t sent;                     // bytes of hist already given to the sink
+    int64_t produced;                // bytes decoded so far
+    int64_t limit;                   // more output than this is corrupt data
+    LzSink sink;
+    void *ctx;
+} LzDecoder;
+
+/* Start decoding a stream that must expand to at most limit bytes */
+Status lz_decoder_init(LzDecoder *d, int64_t limit, LzSink sink, void *ctx);
+
+/* Decode the next n compressed bytes. e_bad_data on a corrupt stream,
+   or the sink's own error. */
+Status lz_decode(LzDecoder *d, const unsigned char *in, size_t n);
+
+/* Input is complete: flush the rest to the sink. e_bad_data if the
+   stream stopped inside a sequence. */
+Status lz_decoder_finish(LzDecoder *d);
+
+/* Release the decoder (after finish, or to give up early) */
+void lz_decoder_free(LzDecoder *d);
+
+#endif // LZ_H
@@ -0,0 +1,143 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include "pool.h"
+
+/* ===================== SHARED STATE OF ONE parallel_for CALL ===================== */
+typedef struct
+{
+    RangeFn fn;
+    void *ctx;
+    int64_t total;
+    int64_t grain;
+    _Atomic int64_t next;       // start of the next slice nobody took yet
+    atomic_int failed;          // set once any slice fails; others stop early
+} RangeJob;
+
+/* ===================== WORKER LOOP ===================== */
+static void *range_worker(void *arg)
+{
+    RangeJob *job = arg;
+
+    while (!atomic_load(&job->failed))
+    {
+        int64_t begin = atomic_fetch_add(&job->next, job->grain);
+        if (begin >= job->total) break;
+
+        int64_t end = begin + job->grain;
+        if (end > job->total) end = job->total;
+
+        if (job->fn(job->ctx, begin, end) != e_success)
+            atomic_store(&job->failed, 1);
+    }
+    return NULL;
+}
+
+/* ===================== RUN [0, total) ON N THREADS ===================== */
+Status parallel_for(int threads, int64_t total, int64_t grain, RangeFn fn, void *ctx)
+{
+    RangeJob job = { .fn = fn, .ctx = ctx, .total = total, .grain = grain > 0 ? grain : 1 };
+    atomic_init(&job.next, 0);
+    atomic_init(&job.failed, 0);
+
+    int64_t slices = (total + job.grain - 1) / job.grain;
+    if (threads > slices) threads = (int)slices;      // no idle threads
+    if (threads < 1) threads = 1;
+
+    pthread_t tid[threads];
+    int started = 0;
+    for (int i = 1; i < threads; i++)
+    {
+        if (pthread_create(&tid[started], NULL, range_worker, &job) != 0) break;
+        started++;                                   // fewer threads is still correct
+    }
+
+    range_worker(&job);                              // calling thread works too
+    for (int i = 0; i < started; i++)
+        pthread_join(tid[i], NULL);
+
+    return atomic_load(&job.failed) ? e_failure : e_success;
+}
+
+/* ===================== WORK STEALING TASK POOL ===================== */
+typedef struct
+{
+    pthread_mutex_t lock;
+    int head;                   // owner takes from here
+    int tail;                   // thieves take from here (exclusive end)
+} TaskDeque;
+
+typedef struct
+{
+    TaskFn fn;
+    void *ctx;
+    int workers;
+    TaskDeque *deques;
+} TaskPool;
+
+typedef struct
+{
+    TaskPool *pool;
+    int id;
+} TaskWorker;
+
+/* front for the owner, back for a thief; -1 when empty */
+static int deque_take(TaskDeque *d, int from_back)
+{
+    int index = -1;
+
+    pthread_mutex_lock(&d->lock);
+    if (d->head < d->tail)
+        index = from_back ? --d->tail : d->head++;
+    pthread_mutex_unlock(&d->lock);
+    return index;
+}
+
+static void *task_worker(void *arg)
+{
+    TaskWorker *self = arg;
+    TaskPool *pool = self->pool;
+
+    for (;;)
+    {
+        int index = deque_take(&pool->deques[self->id], 0);
+
+        for (int v = 1; index < 0 && v < pool->workers; v++)   // own share done: steal
+            index = deque_take(&pool->deques[(self->id + v) % pool->workers], 1);
+
+        if (index < 0) break;      // nothing left anywhere (tasks never get added)
+        pool->fn(pool->ctx, index);
+    }
+    return NULL;
+}
+
+void run_tasks(int workers, int count, TaskFn fn, void *ctx)
+{
+    if (count <= 0) return;
+    if (workers > count) workers = count;
+    if (workers < 1) workers = 1;
+
+    TaskDeque deques[workers];
+    TaskWorker self[workers];
+    pthread_t tid[workers];
+    TaskPool pool = { fn, ctx, workers, deques };
+
+    for (int w = 0; w < workers; w++)
+    {
+        pthread_mutex_init(&deques[w].lock, NULL);
+        deques[w].head = (int)((long)count * w / workers);
+        deques[w].tail = (int)((long)count * (w + 1) / workers);
+        self[w].pool = &pool;
+        self[w].id = w;
+    }
+
+    int started[workers];
+    for (int w = 1; w < workers; w++)
+        started[w] = (pthread_create(&tid[w], NULL, task_worker, &self[w]) == 0);
+
+    task_worker(&self[0]);     // calling thread is worker 0 and steals the rest if a thread failed to start
+    for (int w = 1; w < workers; w++)
+        if (started[w]) pthread_join(tid[w], NULL);
+
+    for (int w = 0; w < workers; w++)
+        pthread_mutex_destroy(&deques[w].lock);
+}
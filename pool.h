@@ -0,0 +1,28 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdint.h>   // int64_t
+#include "types.h"    // Status
+
+/* Payload bytes handed to a worker at a time by parallel_for */
+#define POOL_GRAIN (256 * 1024)
+
+/* Work function for one slice [begin, end) of a job split across threads */
+typedef Status (*RangeFn)(void *ctx, int64_t begin, int64_t end);
+
+/* Split [0, total) into slices of grain bytes and run fn on them with
+   `threads` workers (the calling thread is one of them). Slices are handed
+   out in order from a shared counter, so fast workers simply take more.
+   Returns e_failure if any slice failed. */
+Status parallel_for(int threads, int64_t total, int64_t grain, RangeFn fn, void *ctx);
+
+/* One task of run_tasks: index is in [0, count) */
+typedef void (*TaskFn)(void *ctx, int index);
+
+/* Run fn(ctx, i) for every i in [0, count) on `workers` threads. Each worker
+   owns a contiguous share of the indexes and takes them from the front; a
+   worker that runs dry steals from the back of another worker's share, so a
+   few slow tasks never leave the rest of the pool idle. */
+void run_tasks(int workers, int count, TaskFn fn, void *ctx);
+
+#endif // POOL_H
@@ -0,0 +1,245 @@
+#define _DEFAULT_SOURCE      // d_type, MUST be first line
+#define _FILE_OFFSET_BITS 64 // same off_t as fileio.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <inttypes.h>        // PRId64
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include "probe.h"
+#include "stego.h"
+#include "console.h"
+#include "pool.h"
+
+#define PROBE_RECORD 1024    // one output line, file name included
+
+/* ===================== FILES TO PROBE ===================== */
+typedef struct
+{
+    char **paths;
+    int count;
+    int cap;
+} PathList;
+
+static Status add_path(PathList *list, const char *path)
+{
+    if (list->count == list->cap)
+    {
+        int cap = list->cap ? list->cap * 2 : 256;
+        char **grown = realloc(list->paths, cap * sizeof(*grown));
+        if (!grown) return e_failure;
+        list->paths = grown;
+        list->cap = cap;
+    }
+    if (!(list->paths[list->count] = strdup(path))) return e_failure;
+    list->count++;
+    return e_success;
+}
+
+static int is_bmp_name(const char *name)
+{
+    size_t len = strlen(name);
+    return len > 4 && !strcasecmp(name + len - 4, ".bmp");
+}
+
+/* Every *.bmp below dir; symlinks are not followed, so loops cannot happen */
+static void walk_dir(const char *dir, PathList *list)
+{
+    DIR *d = opendir(dir);
+    struct dirent *e;
+
+    if (!d)
+    {
+        fprintf(stderr, "[WARN] Cannot open directory: %s\n", dir);
+        return;
+    }
+    while ((e = readdir(d)) != NULL)
+    {
+        if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) continue;
+
+        size_t len = strlen(dir) + strlen(e->d_name) + 2;
+        char *path = malloc(len);
+        if (!path) break;
+        snprintf(path, len, "%s/%s", dir, e->d_name);
+
+        unsigned char type = e->d_type;
+        struct stat st;
+        if (type == DT_UNKNOWN && lstat(path, &st) == 0)    // some filesystems leave d_type out
+            type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+
+        if (type == DT_DIR)
+            walk_dir(path, list);
+        else if (type == DT_REG && is_bmp_name(e->d_name))
+            add_path(list, path);
+        free(path);
+    }
+    closedir(d);
+}
+
+/* ===================== ONE RECORD ===================== */
+/* Append s as a JSON string; returns the new length (capped at cap - 1) */
+static size_t put_json_string(char *rec, size_t len, size_t cap, const char *s)
+{
+    if (len < cap - 1) rec[len++] = '"';
+    for (; *s && len < cap - 8; s++)
+    {
+        unsigned char c = *s;
+        if (c == '"' || c == '\\')
+            len += snprintf(rec + len, cap - len, "\\%c", c);
+        else if (c < 0x20)
+            len += snprintf(rec + len, cap - len, "\\u%04x", c);
+        else
+            rec[len++] = c;
+    }
+    if (len < cap - 1) rec[len++] = '"';
+    rec[len] = '\0';
+    return len;
+}
+
+/* Read the headers of one file and describe it in rec; *hidden is set for
+   "stego" records. Returns e_failure for the "error" records. */
+static Status probe_file(const char *fname, char *rec, size_t cap, int *hidden)
+{
+    unsigned char buf[PROBE_READ], late[STEGO_HEADER_MAX];
+    const unsigned char *region;
+    size_t region_len = 0, need;
+    PixelView view;
+    StegoInfo info;
+    struct stat st;
+    Status ret = e_failure;
+    const char *error = "cannot read file";
+
+    *hidden = 0;
+    size_t len = put_json_string(rec, snprintf(rec, cap, "{\"file\":"), cap, fname);
+
+    int fd = open(fname, O_RDONLY | O_CLOEXEC);
+    ssize_t got = -1;
+    if (fd >= 0 && fstat(fd, &st) == 0)
+    {
+        got = S_ISREG(st.st_mode) ? pread(fd, buf, sizeof(buf), 0) : -1;
+        error = S_ISREG(st.st_mode) ? "cannot read file" : "not a regular file";
+    }
+
+    if (got >= 0)
+    {
+        ret = stego_parse_bmp(buf, got, st.st_size, &view, &need);
+        error = stego_strerror(ret);
+    }
+    if (ret == e_success)
+    {
+        /* the hidden header is usually in the same read; a late pixel array costs a second one */
+        region = buf + view.offset;
+        if (view.offset + STEGO_HEADER_MAX <= got || got == st.st_size)
+        {
+            region_len = (view.offset < got) ? got - view.offset : 0;
+        }
+        else
+        {
+            ssize_t n = pread(fd, late, sizeof(late), view.offset);
+            region = late;
+            region_len = n > 0 ? n : 0;
+        }
+
+        ret = stego_read_header(&view, region, region_len, &info, &need);
+        if (ret == e_short_buffer) ret = e_bad_image;             // file ends inside the header
+        error = stego_strerror(ret);
+    }
+    if (fd >= 0) close(fd);
+
+    if (ret == e_success)
+    {
+        StegoOptions opts = { .depth = info.depth, .flags = info.flags,
+                              .original_size = info.original_size, .ecc = info.ecc };
+        int64_t capacity = 0;
+        stego_capacity(&view, info.extn_len, &opts, &capacity);
+
+        static const struct { unsigned flag; const char *name; } names[] = {
+            { STEGO_FLAG_LZ, "lz" }, { STEGO_FLAG_SIZE64, "size64" },
+            { STEGO_FLAG_CRC, "crc" }, { STEGO_FLAG_CHACHA, "chacha" },
+            { STEGO_FLAG_CONTAINER, "container" }, { STEGO_FLAG_SEGMENT, "segment" },
+            { STEGO_FLAG_SCATTER, "scatter" }, { STEGO_FLAG_RS, "rs" } };
+        char flags[96] = "";
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+            if (info.flags & names[i].flag)
+                snprintf(flags + strlen(flags), sizeof(flags) - strlen(flags), "%s\"%s\"",
+                         flags[0] ? "," : "", names[i].name);
+
+        len += snprintf(rec + len, cap - len, ",\"status\":\"stego\",\"extn\":");
+        len = put_json_string(rec, len, cap, info.extn);
+        snprintf(rec + len, cap - len,
+                 ",\"size\":%" PRId64 ",\"original_size\":%" PRId64 ",\"depth\":%d,\"flags\":[%s],"
+                 "\"capacity\":%" PRId64 "}\n",
+                 info.size, info.original_size, info.depth, flags, capacity);
+        *hidden = 1;
+        return e_success;
+    }
+    if (ret == e_no_secret)
+    {
+        /* room for a new secret with the CLI defaults: depth 1, CRC, 4 character extension */
+        StegoOptions opts = { .depth = 1, .flags = STEGO_FLAG_CRC };
+        int64_t capacity = 0;
+        stego_capacity(&view, MAX_FILE_SUFFIX, &opts, &capacity);
+        snprintf(rec + len, cap - len, ",\"status\":\"clean\",\"capacity\":%" PRId64 "}\n", capacity);
+        return e_success;
+    }
+
+    len += snprintf(rec + len, cap - len, ",\"status\":\"error\",\"error\":");
+    len = put_json_string(rec, len, cap, error);
+    snprintf(rec + len, cap - len, "}\n");
+    return e_failure;
+}
+
+/* ===================== RUN ON THE POOL ===================== */
+typedef struct
+{
+    char **paths;
+    atomic_int stego;
+    atomic_int failed;
+} ProbeRun;
+
+static void probe_task(void *ctx, int index)
+{
+    ProbeRun *run = ctx;
+    char rec[PROBE_RECORD];
+    int hidden;
+
+    if (probe_file(run->paths[index], rec, sizeof(rec), &hidden) != e_success)
+        atomic_fetch_add(&run->failed, 1);
+    if (hidden) atomic_fetch_add(&run->stego, 1);
+    fputs(rec, stdout);                      // one call per line: stdio keeps lines whole
+}
+
+Status run_probe(char *paths[], int count, int workers)
+{
+    PathList list = { 0 };
+    struct stat st;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (stat(paths[i], &st) == 0 && S_ISDIR(st.st_mode))
+            walk_dir(paths[i], &list);
+        else
+            add_path(&list, paths[i]);       // named files are probed whatever their name
+    }
+
+    if (workers < 1) workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    ProbeRun run = { .paths = list.paths };
+    atomic_init(&run.stego, 0);
+    atomic_init(&run.failed, 0);
+    run_tasks(workers, list.count, probe_task, &run);
+    fflush(stdout);
+
+    int failed = atomic_load(&run.failed);
+    if (!console_quiet)                      // stdout carries only the records
+        fprintf(stderr, "[INFO] Probe: %d file(s) on %d worker(s), %d with hidden data, %d error(s)\n",
+                list.count, workers, atomic_load(&run.stego), failed);
+
+    for (int i = 0; i < list.count; i++) free(list.paths[i]);
+    free(list.paths);
+    return failed ? e_failure : e_success;
+}
@@ -0,0 +1,22 @@
+#ifndef PROBE_H
+#define PROBE_H
+
+#include "types.h"
+
+/* Bytes read from the start of each file: the BMP headers plus the hidden
+   header fields of any image whose pixels start within the first 3 KB */
+#define PROBE_READ 4096
+
+/* Check files for hidden data without decoding anything. paths are files
+   or directories; directories are walked recursively and every *.bmp in
+   them is probed. Each file costs one pread (two if its pixel array starts
+   late) and prints one JSON line on stdout:
+       {"file":..,"status":"stego","extn":..,"size":..,"original_size":..,
+        "depth":..,"flags":[..],"capacity":..}
+       {"file":..,"status":"clean","capacity":..}
+       {"file":..,"status":"error","error":..}
+   Lines come in the order the workers finish. Returns e_success unless a
+   file could not be read or parsed. */
+Status run_probe(char *paths[], int count, int workers);
+
+#endif // PROBE_H
@@ -0,0 +1,147 @@
+#define _XOPEN_SOURCE 700   // clock_gettime, pthread_cond_timedwait, MUST be first line
+#include <inttypes.h>       // PRId64
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "progress.h"
+#include "console.h"        // console_quiet
+
+/* ===================== COLOR CODES FOR PROGRESS BAR ===================== */
+#define GREEN  "\033[0;32m"
+#define GRAY   "\033[0;90m"
+#define RESET  "\033[0m"
+
+/* ===================== MODE NAMES ===================== */
+Status progress_parse_mode(const char *name, ProgressMode *mode)
+{
+    if (!strcmp(name, "none")) *mode = e_progress_none;
+    else if (!strcmp(name, "bar")) *mode = e_progress_bar;
+    else if (!strcmp(name, "json")) *mode = e_progress_json;
+    else return e_failure;
+    return e_success;
+}
+
+/* ===================== ONE SAMPLE ON STDERR ===================== */
+static double elapsed_since(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void draw(const Progress *p, int64_t done, double seconds)
+{
+    if (p->mode == e_progress_json)
+    {
+        fprintf(stderr, "{\"op\":\"%s\",\"done\":%" PRId64 ",\"total\":%" PRId64 ",\"seconds\":%.3f}\n",
+                p->label, done, p->total, seconds);
+        return;
+    }
+
+    /* bar: build the whole line first so it goes out in one write */
+    char line[64 + 50 * (sizeof(GREEN "■" RESET) - 1)];
+    int barWidth = 50;
+    float progress = (p->total > 0) ? ((float)done / p->total) : 1.0f;
+    int fill = (int)(progress * barWidth);
+    size_t len = 0;
+
+    line[len++] = '\r';
+    line[len++] = '[';
+    for (int i = 0; i < barWidth; i++)
+    {
+        const char *cell = (i < fill) ? GREEN "■" RESET : GRAY "□" RESET;
+        size_t n = strlen(cell);
+        memcpy(line + len, cell, n);
+        len += n;
+    }
+    len += snprintf(line + len, sizeof(line) - len, "] %3d%%", (int)(progress * 100));
+    fwrite(line, 1, len, stderr);
+}
+
+/* ===================== REPORTER THREAD ===================== */
+static void *reporter(void *arg)
+{
+    Progress *p = arg;
+    struct timespec start, wake;
+    int64_t shown = -1;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pthread_mutex_lock(&p->lock);
+    while (!p->stop)
+    {
+        int64_t done = atomic_load_explicit(&p->done, memory_order_relaxed);
+        if (done != shown)   // draw outside the lock, finish must not wait on the terminal
+        {
+            pthread_mutex_unlock(&p->lock);
+            draw(p, done, elapsed_since(&start));
+            shown = done;
+            pthread_mutex_lock(&p->lock);
+            if (p->stop) break;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &wake);
+        wake.tv_nsec += PROGRESS_INTERVAL_MS * 1000000L;
+        if (wake.tv_nsec >= 1000000000L)
+        {
+            wake.tv_sec++;
+            wake.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&p->cond, &p->lock, &wake);
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    /* final sample, so the last line always shows the finished count */
+    draw(p, atomic_load(&p->done), elapsed_since(&start));
+    if (p->mode == e_progress_bar) fputc('\n', stderr);
+    return NULL;
+}
+
+/* ===================== START / FINISH ===================== */
+void progress_start(Progress *p, ProgressMode mode, const char *label, int64_t total)
+{
+    atomic_init(&p->done, 0);
+    p->total = total;
+    p->label = label;
+    p->stop = 0;
+    p->running = 0;
+
+    if (console_quiet) mode = e_progress_none;                    // batch worker
+    if (mode == e_progress_bar && !isatty(STDERR_FILENO)) mode = e_progress_none;
+    p->mode = mode;
+    if (mode == e_progress_none) return;
+
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);   // timed waits ignore clock jumps
+    pthread_cond_init(&p->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&p->thread, NULL, reporter, p) == 0)
+    {
+        p->running = 1;
+    }
+    else
+    {
+        pthread_cond_destroy(&p->cond);         // no progress is better than no job
+        pthread_mutex_destroy(&p->lock);
+        p->mode = e_progress_none;
+    }
+}
+
+void progress_finish(Progress *p)
+{
+    if (!p->running) return;
+
+    pthread_mutex_lock(&p->lock);
+    p->stop = 1;
+    pthread_cond_signal(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+    pthread_join(p->thread, NULL);
+
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->lock);
+    p->running = 0;
+}
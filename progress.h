@@ -0,0 +1,57 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>   // int64_t
+#include "types.h"    // Status
+
+/* How often the reporter samples the byte counter */
+#define PROGRESS_INTERVAL_MS 100
+
+/* What the reporter prints (--progress=none|bar|json, --quiet = none) */
+typedef enum
+{
+    e_progress_none,          // no reporter thread, no terminal I/O
+    e_progress_bar,           // redrawn bar on stderr, only if stderr is a TTY
+    e_progress_json           // one JSON object per line on stderr
+} ProgressMode;
+
+/*----------------------------------------------------------
+    Progress of one encode / decode job
+
+    The data loops (any number of threads) only add to `done`;
+    a separate reporter thread samples it every PROGRESS_INTERVAL_MS
+    and does all the printing, so the hot path never touches the
+    terminal.
+----------------------------------------------------------*/
+typedef struct _Progress
+{
+    _Atomic int64_t done;            // bytes finished so far
+    int64_t total;                   // bytes in the whole job
+    const char *label;               // "encode" / "decode" (JSON only)
+    ProgressMode mode;               // mode actually in use
+    int running;                     // reporter thread was started
+    int stop;                        // set by progress_finish
+    pthread_mutex_t lock;            // guards stop, wakes the reporter early
+    pthread_cond_t cond;
+    pthread_t thread;
+} Progress;
+
+/* Parse the value of --progress= ("none", "bar", "json") */
+Status progress_parse_mode(const char *name, ProgressMode *mode);
+
+/* Start reporting a job of total bytes. Falls back to no reporter when the
+   mode has nothing to print (bar without a TTY, quiet thread). */
+void progress_start(Progress *p, ProgressMode mode, const char *label, int64_t total);
+
+/* Count n more finished bytes; cheap enough for every block */
+static inline void progress_add(Progress *p, int64_t n)
+{
+    atomic_fetch_add_explicit(&p->done, n, memory_order_relaxed);
+}
+
+/* Stop the reporter and print the final sample */
+void progress_finish(Progress *p);
+
+#endif // PROGRESS_H
@@ -0,0 +1,411 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "rs.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RS_X86 1
+#include <immintrin.h>
+#endif
+
+#define GF_POLY 0x11D               // x^8 + x^4 + x^3 + x^2 + 1
+
+/* ===================== GF(256) TABLES ===================== */
+static unsigned char gf_exp[512];   // doubled, so log sums need no reduction
+static unsigned char gf_log[256];
+static unsigned char gen[RS_PARITY_MAX + 1][RS_PARITY_MAX + 1];   // generator of each nsym, x^nsym first
+
+/* Split-nibble products: c * x = nib_lo[c][x & 15] ^ nib_hi[c][x >> 4] */
+static unsigned char nib_lo[256][16] __attribute__((aligned(16)));
+static unsigned char nib_hi[256][16] __attribute__((aligned(16)));
+
+static unsigned char gf_mul(unsigned char a, unsigned char b)
+{
+    return (a && b) ? gf_exp[gf_log[a] + gf_log[b]] : 0;
+}
+
+static unsigned char gf_div(unsigned char a, unsigned char b)
+{
+    return a ? gf_exp[gf_log[a] + 255 - gf_log[b]] : 0;
+}
+
+static void build_tables(void)
+{
+    unsigned x = 1;
+    for (int i = 0; i < 255; i++)
+    {
+        gf_exp[i] = gf_exp[i + 255] = (unsigned char)x;
+        gf_log[x] = (unsigned char)i;
+        x <<= 1;
+        if (x & 0x100) x ^= GF_POLY;
+    }
+    gf_exp[510] = gf_exp[0];
+    gf_exp[511] = gf_exp[1];
+
+    for (int c = 0; c < 256; c++)
+        for (int i = 0; i < 16; i++)
+        {
+            nib_lo[c][i] = gf_mul(c, i);
+            nib_hi[c][i] = gf_mul(c, i << 4);
+        }
+
+    /* g(x) = (x + a^0)(x + a^1)...(x + a^(nsym-1)) */
+    gen[0][0] = 1;
+    for (int n = 1; n <= RS_PARITY_MAX; n++)
+    {
+        unsigned char root = gf_exp[n - 1];
+        gen[n][0] = 1;
+        for (int j = 1; j < n; j++) gen[n][j] = gen[n - 1][j] ^ gf_mul(root, gen[n - 1][j - 1]);
+        gen[n][n] = gf_mul(root, gen[n - 1][n - 1]);
+    }
+}
+
+/* ===================== ONE CODEWORD (table version) ===================== */
+static void encode_scalar(const unsigned char *data, size_t n, int nsym, unsigned char *parity)
+{
+    const unsigned char *g = gen[nsym];
+
+    memset(parity, 0, nsym);
+    for (size_t i = 0; i < n; i++)
+    {
+        unsigned char fb = data[i] ^ parity[0];
+        memmove(parity, parity + 1, nsym - 1);
+        parity[nsym - 1] = 0;
+        if (fb)
+            for (int t = 0; t < nsym; t++) parity[t] ^= gf_mul(g[t + 1], fb);
+    }
+}
+
+/* Bad bytes of a codeword (len bytes, data then parity): positions and the
+   values to xor in. Returns their count, 0 for a clean codeword, -1 if
+   there are too many to tell. */
+static int locate(const unsigned char *cw, int len, int nsym, int *pos, unsigned char *mag)
+{
+    unsigned char synd[RS_PARITY_MAX], lambda[RS_PARITY_MAX + 1] = { 1 }, prev[RS_PARITY_MAX + 1] = { 1 };
+    unsigned char omega[RS_PARITY_MAX];
+    int any = 0;
+
+    for (int i = 0; i < nsym; i++)
+    {
+        unsigned char s = 0, root = gf_exp[i];
+        for (int p = 0; p < len; p++) s = gf_mul(s, root) ^ cw[p];
+        synd[i] = s;
+        any |= s;
+    }
+    if (!any) return 0;
+
+    /* Berlekamp-Massey: shortest LFSR (error locator, lowest degree first) */
+    int errs = 0, shift = 1;
+    unsigned char last = 1;
+    for (int n = 0; n < nsym; n++)
+    {
+        unsigned char d = synd[n];
+        for (int i = 1; i <= errs; i++) d ^= gf_mul(lambda[i], synd[n - i]);
+        if (!d)
+        {
+            shift++;
+            continue;
+        }
+
+        unsigned char keep[RS_PARITY_MAX + 1], f = gf_div(d, last);
+        memcpy(keep, lambda, sizeof(keep));
+        for (int i = 0; i + shift <= nsym; i++) lambda[i + shift] ^= gf_mul(f, prev[i]);
+        if (2 * errs <= n)
+        {
+            errs = n + 1 - errs;
+            memcpy(prev, keep, sizeof(prev));
+            last = d;
+            shift = 1;
+        }
+        else
+            shift++;
+    }
+    if (2 * errs > nsym) return -1;
+
+    /* Omega = S * Lambda mod x^nsym */
+    for (int i = 0; i < nsym; i++)
+    {
+        unsigned char o = 0;
+        for (int j = 0; j <= i && j <= errs; j++) o ^= gf_mul(lambda[j], synd[i - j]);
+        omega[i] = o;
+    }
+
+    /* Chien search over the positions that exist, Forney for the values */
+    int found = 0;
+    for (int p = 0; p < len && found <= errs; p++)
+    {
+        int e = len - 1 - p;                               // degree of byte p
+        unsigned char xinv = gf_exp[(255 - e) % 255], pw = 1, v = 0;
+        for (int i = 0; i <= errs; i++)
+        {
+            v ^= gf_mul(lambda[i], pw);
+            pw = gf_mul(pw, xinv);
+        }
+        if (v) continue;
+
+        unsigned char num = 0, den = 0;
+        pw = 1;
+        for (int i = 0; i < nsym; i++)
+        {
+            num ^= gf_mul(omega[i], pw);
+            if (i & 1) den ^= gf_mul(lambda[i], gf_mul(pw, gf_exp[255 - gf_log[xinv]]));   // x^(i-1)
+            pw = gf_mul(pw, xinv);
+        }
+        if (!den) return -1;
+        pos[found] = p;
+        mag[found] = gf_mul(gf_exp[e], gf_div(num, den));
+        found++;
+    }
+    return found == errs ? found : -1;
+}
+
+/* ===================== BLOCK ROWS: one row of RS_LANES bytes feeds every codeword ===================== */
+/* state is the parity so far, row t at state + t * RS_LANES */
+static void rows_table(unsigned char *state, const unsigned char *data, size_t rows, int nsym)
+{
+    const unsigned char *g = gen[nsym];
+
+    for (size_t r = 0; r < rows; r++, data += RS_LANES)
+        for (int l = 0; l < RS_LANES; l++)
+        {
+            unsigned char fb = data[l] ^ state[l];
+            for (int t = 0; t < nsym - 1; t++)
+                state[t * RS_LANES + l] = state[(t + 1) * RS_LANES + l] ^ gf_mul(g[t + 1], fb);
+            state[(nsym - 1) * RS_LANES + l] = gf_mul(g[nsym], fb);
+        }
+}
+
+#ifdef RS_X86
+__attribute__((target("ssse3")))
+static void rows_ssse3(unsigned char *state, const unsigned char *data, size_t rows, int nsym)
+{
+    const unsigned char *g = gen[nsym];
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    __m128i s[RS_PARITY_MAX + 1], tlo[RS_PARITY_MAX], thi[RS_PARITY_MAX];
+
+    for (int t = 0; t < nsym; t++)
+    {
+        tlo[t] = _mm_load_si128((const __m128i *)nib_lo[g[t + 1]]);
+        thi[t] = _mm_load_si128((const __m128i *)nib_hi[g[t + 1]]);
+    }
+    s[nsym] = _mm_setzero_si128();                     // shifted in below the last parity byte
+    for (int half = 0; half < RS_LANES; half += 16)
+    {
+        for (int t = 0; t < nsym; t++) s[t] = _mm_loadu_si128((const __m128i *)(state + t * RS_LANES + half));
+        for (size_t r = 0; r < rows; r++)
+        {
+            __m128i fb = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(data + r * RS_LANES + half)), s[0]);
+            __m128i lo = _mm_and_si128(fb, mask);
+            __m128i hi = _mm_and_si128(_mm_srli_epi16(fb, 4), mask);
+            for (int t = 0; t < nsym; t++)
+            {
+                __m128i prod = _mm_xor_si128(_mm_shuffle_epi8(tlo[t], lo), _mm_shuffle_epi8(thi[t], hi));
+                s[t] = _mm_xor_si128(s[t + 1], prod);
+            }
+        }
+        for (int t = 0; t < nsym; t++) _mm_storeu_si128((__m128i *)(state + t * RS_LANES + half), s[t]);
+    }
+}
+
+__attribute__((target("avx2")))
+static void rows_avx2(unsigned char *state, const unsigned char *data, size_t rows, int nsym)
+{
+    const unsigned char *g = gen[nsym];
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    __m256i s[RS_PARITY_MAX + 1], tlo[RS_PARITY_MAX], thi[RS_PARITY_MAX];
+
+    /* pshufb looks up within each 128-bit half: every table goes in both */
+    for (int t = 0; t < nsym; t++)
+    {
+        tlo[t] = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)nib_lo[g[t + 1]]));
+        thi[t] = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)nib_hi[g[t + 1]]));
+        s[t] = _mm256_loadu_si256((const __m256i *)(state + t * RS_LANES));
+    }
+    s[nsym] = _mm256_setzero_si256();                  // shifted in below the last parity byte
+    for (size_t r = 0; r < rows; r++)
+    {
+        __m256i fb = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(data + r * RS_LANES)), s[0]);
+        __m256i lo = _mm256_and_si256(fb, mask);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(fb, 4), mask);
+        for (int t = 0; t < nsym; t++)
+        {
+            __m256i prod = _mm256_xor_si256(_mm256_shuffle_epi8(tlo[t], lo), _mm256_shuffle_epi8(thi[t], hi));
+            s[t] = _mm256_xor_si256(s[t + 1], prod);
+        }
+    }
+    for (int t = 0; t < nsym; t++) _mm256_storeu_si256((__m256i *)(state + t * RS_LANES), s[t]);
+}
+#endif // RS_X86
+
+/* ===================== IMPLEMENTATION TABLE (chosen once) ===================== */
+typedef struct
+{
+    const char *name;
+    void (*rows)(unsigned char *state, const unsigned char *data, size_t rows, int nsym);
+} RsImpl;
+
+static const RsImpl impl_table = { "table", rows_table };
+#ifdef RS_X86
+static const RsImpl impl_ssse3 = { "ssse3", rows_ssse3 };
+static const RsImpl impl_avx2 = { "avx2", rows_avx2 };
+#endif
+
+static const RsImpl *impl = &impl_table;
+
+static void encode_block_with(const RsImpl *with, const unsigned char *data, size_t n, int nsym,
+                              unsigned char *parity)
+{
+    size_t full = n / RS_LANES;
+
+    memset(parity, 0, (size_t)RS_LANES * nsym);
+    with->rows(parity, data, full, nsym);
+    if (n % RS_LANES)
+    {
+        unsigned char last[RS_LANES] = { 0 };             // short last row: zero padded
+        memcpy(last, data + full * RS_LANES, n % RS_LANES);
+        with->rows(parity, last, 1, nsym);
+    }
+}
+
+__attribute__((constructor))
+static void rs_select(void)
+{
+    const char *force = getenv("STEGO_RS");
+
+    build_tables();
+
+#ifdef RS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3")) impl = &impl_ssse3;
+    if (__builtin_cpu_supports("avx2")) impl = &impl_avx2;
+#endif
+
+    if (force)
+    {
+        if (!strcmp(force, "table")) impl = &impl_table;
+#ifdef RS_X86
+        else if (!strcmp(force, "ssse3") && __builtin_cpu_supports("ssse3")) impl = &impl_ssse3;
+#endif
+    }
+
+#ifndef NDEBUG
+    if (rs_self_check() != e_success)
+    {
+        fprintf(stderr, "[WARN] Reed-Solomon kernel '%s' failed self check, using table\n", impl->name);
+        impl = &impl_table;
+    }
+#endif
+}
+
+/* ===================== PUBLIC ENTRY POINTS ===================== */
+void rs_encode(const unsigned char *data, size_t n, int nsym, unsigned char *parity)
+{
+    encode_scalar(data, n, nsym, parity);
+}
+
+int rs_decode(unsigned char *data, size_t n, int nsym, unsigned char *parity)
+{
+    unsigned char cw[RS_CODEWORD_MAX], mag[RS_PARITY_MAX];
+    int pos[RS_PARITY_MAX];
+
+    memcpy(cw, data, n);
+    memcpy(cw + n, parity, nsym);
+    int count = locate(cw, (int)n + nsym, nsym, pos, mag);
+    for (int i = 0; i < count; i++)
+    {
+        if ((size_t)pos[i] < n) data[pos[i]] ^= mag[i];
+        else parity[pos[i] - n] ^= mag[i];
+    }
+    return count;
+}
+
+void rs_encode_block(const unsigned char *data, size_t n, int nsym, unsigned char *parity)
+{
+    encode_block_with(impl, data, n, nsym, parity);
+}
+
+int rs_decode_block(unsigned char *data, size_t n, int nsym, unsigned char *parity)
+{
+    unsigned char check[RS_LANES * RS_PARITY_MAX];
+    size_t rows = (n + RS_LANES - 1) / RS_LANES;
+    int fixed = 0, failed = 0;
+
+    /* a clean block re-encodes to the parity it carries: no syndromes needed */
+    rs_encode_block(data, n, nsym, check);
+    if (!memcmp(check, parity, (size_t)RS_LANES * nsym)) return 0;
+
+    for (int l = 0; l < RS_LANES; l++)
+    {
+        int differs = 0;
+        for (int t = 0; t < nsym && !differs; t++) differs = check[t * RS_LANES + l] != parity[t * RS_LANES + l];
+        if (!differs) continue;
+
+        unsigned char cw[RS_CODEWORD_MAX], mag[RS_PARITY_MAX];
+        int pos[RS_PARITY_MAX];
+        for (size_t j = 0; j < rows; j++) cw[j] = (j * RS_LANES + l < n) ? data[j * RS_LANES + l] : 0;
+        for (int t = 0; t < nsym; t++) cw[rows + t] = parity[t * RS_LANES + l];
+
+        int count = locate(cw, (int)rows + nsym, nsym, pos, mag);
+        for (int i = 0; i < count; i++)
+            if ((size_t)pos[i] < rows && (size_t)pos[i] * RS_LANES + l >= n) count = -1;   // "error" in the padding
+        if (count < 0)
+        {
+            failed = 1;
+            continue;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            if ((size_t)pos[i] < rows) data[pos[i] * RS_LANES + l] ^= mag[i];
+            else parity[(pos[i] - rows) * RS_LANES + l] ^= mag[i];
+        }
+        fixed += count;
+    }
+    return failed ? -1 : fixed;
+}
+
+const char *rs_impl_name(void)
+{
+    return impl->name;
+}
+
+Status rs_self_check(void)
+{
+    enum { N = RS_LANES * 128 };
+    static unsigned char data[N], copy[N];
+    unsigned char parity[RS_LANES * RS_PARITY_MAX], ref[RS_LANES * RS_PARITY_MAX];
+    uint32_t seed = 0x9E3779B9u;
+
+    for (size_t i = 0; i < N; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = seed >> 24;
+    }
+
+    /* the kernel in use matches the table on full and short rows */
+    int nsyms[] = { 1, 2, 16, 33, RS_PARITY_MAX };
+    size_t sizes[] = { 1, 31, 32, 1000, N };
+    for (size_t a = 0; a < sizeof(nsyms) / sizeof(nsyms[0]); a++)
+        for (size_t b = 0; b < sizeof(sizes) / sizeof(sizes[0]); b++)
+        {
+            encode_block_with(&impl_table, data, sizes[b], nsyms[a], ref);
+            encode_block_with(impl, data, sizes[b], nsyms[a], parity);
+            if (memcmp(ref, parity, (size_t)RS_LANES * nsyms[a])) return e_failure;
+        }
+
+    /* nsym / 2 bad bytes in every codeword come back; one more is refused */
+    rs_encode_block(data, 1000, 16, parity);
+    memcpy(copy, data, 1000);
+    for (int l = 0; l < RS_LANES; l++)
+        for (int e = 0; e < 8; e++) copy[(e * 3 + l % 3) * RS_LANES + l] ^= 0x5A + e;
+    if (rs_decode_block(copy, 1000, 16, parity) < 0 || memcmp(copy, data, 1000)) return e_failure;
+
+    unsigned char cw[64], par[16];
+    memcpy(cw, data, sizeof(cw));
+    rs_encode(cw, sizeof(cw), 16, par);
+    for (int e = 0; e < 8; e++) cw[e * 7] ^= 0xFF;
+    if (rs_decode(cw, sizeof(cw), 16, par) != 8 || memcmp(cw, data, sizeof(cw))) return e_failure;
+    for (int e = 0; e < 9; e++) cw[e * 7] ^= 0xFF;
+    if (rs_decode(cw, sizeof(cw), 16, par) >= 0) return e_failure;
+    return e_success;
+}
@@ -0,0 +1,55 @@
+#ifndef RS_H
+#define RS_H
+
+#include <stddef.h>   // size_t
+#include "types.h"    // Status
+
+/*----------------------------------------------------------
+    Reed-Solomon codes over GF(256) (part of libstego)
+
+    Systematic RS(n, n - nsym) with generator roots alpha^0 ..
+    alpha^(nsym-1), polynomial 0x11D. A codeword is at most 255
+    bytes; the data comes first, highest degree first, then the
+    nsym parity bytes. nsym parity bytes correct nsym / 2 bad bytes.
+
+    Blocks interleave RS_LANES codewords byte by byte: byte i of a
+    block belongs to codeword i % RS_LANES, so one row of RS_LANES
+    bytes feeds every codeword at once and a burst of bad bytes is
+    spread over many codewords. Rows are encoded with split-nibble
+    GF(256) products (two 16-entry tables per constant, looked up
+    with pshufb). The implementation (avx2, ssse3 or table) is
+    picked once at startup from CPUID; STEGO_RS=<name> forces one.
+    Decoding re-encodes the data the same way and compares parity;
+    only codewords that differ go through syndromes, Berlekamp-
+    Massey, Chien search and Forney.
+----------------------------------------------------------*/
+
+#define RS_LANES 32                 // codewords per block
+#define RS_PARITY_MAX 64            // nsym limit for blocks
+#define RS_CODEWORD_MAX 255
+
+/* One codeword: parity (nsym bytes) of n data bytes, n + nsym <= 255 */
+void rs_encode(const unsigned char *data, size_t n, int nsym, unsigned char *parity);
+
+/* Repair one codeword in place: bad bytes corrected, or -1 if there are
+   more than nsym / 2 of them (data and parity are then left alone) */
+int rs_decode(unsigned char *data, size_t n, int nsym, unsigned char *parity);
+
+/* Block of n data bytes, n <= RS_LANES * (255 - nsym), nsym <= RS_PARITY_MAX:
+   RS_LANES * nsym parity bytes, parity byte t of codeword l at
+   parity[t * RS_LANES + l]. A short last row counts as zero padded. */
+void rs_encode_block(const unsigned char *data, size_t n, int nsym, unsigned char *parity);
+
+/* Repair a block in place: bad bytes corrected, or -1 if some codeword
+   could not be repaired (the others still are) */
+int rs_decode_block(unsigned char *data, size_t n, int nsym, unsigned char *parity);
+
+/* Name of the block implementation currently in use */
+const char *rs_impl_name(void);
+
+/* Compare the implementation in use with the table version, and check
+   that injected errors are repaired (also run at startup unless built
+   with -DNDEBUG) */
+Status rs_self_check(void);
+
+#endif // RS_H
@@ -0,0 +1,580 @@
+#define _FILE_OFFSET_BITS 64 // pread / pwrite past 2 GB, MUST be first line
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>        // PRId64
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "span.h"
+#include "stego.h"           // where each segment byte sits in its image
+#include "lsb.h"             // LSB_BLOCK_SIZE
+#include "crc32c.h"          // checksum of each segment
+#include "cipher.h"          // set id
+#include "fileio.h"          // mapping, pread / pwrite helpers
+#include "pool.h"            // run_tasks: one task per image
+#include "progress.h"        // byte counter + background reporter
+#include "stream.h"          // STREAM_NAME
+#include "console.h"         // cprintf (silent in batch workers)
+
+#define GREEN  "\033[0;32m"
+#define RESET  "\033[0m"
+
+#define SPAN_READ 4096       // first read of an image: the BMP headers
+
+/* ===================== SMALL LITTLE ENDIAN HELPERS ===================== */
+static void put_le(unsigned char *p, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) p[i] = (v >> (i * 8)) & 0xFF;
+}
+
+static uint64_t get_le(const unsigned char *p, int bytes)
+{
+    uint64_t v = 0;
+    for (int i = bytes - 1; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+/* ===================== SEQUENCE HEADER ===================== */
+typedef struct
+{
+    int index;                       // 0-based position in the set
+    int count;                       // segments in the set
+    uint64_t set_id;                 // random, the same for every segment of a run
+    int64_t total;                   // size of the whole secret
+    int64_t offset;                  // first secret byte in this segment
+} SpanHeader;
+
+static void write_span_header(const SpanHeader *h, unsigned char out[SPAN_HEADER_SIZE])
+{
+    memcpy(out, SPAN_MAGIC, 4);
+    out[4] = SPAN_VERSION;
+    out[5] = 0;
+    put_le(out + 6, h->index, 2);
+    put_le(out + 8, h->count, 2);
+    put_le(out + 10, 0, 2);
+    put_le(out + 12, h->set_id, 8);
+    put_le(out + 20, h->total, 8);
+    put_le(out + 28, h->offset, 8);
+    put_le(out + 36, crc32c(0, out, 36), 4);
+}
+
+static Status read_span_header(const unsigned char in[SPAN_HEADER_SIZE], SpanHeader *h)
+{
+    if (memcmp(in, SPAN_MAGIC, 4) != 0 || in[4] != SPAN_VERSION ||
+        get_le(in + 36, 4) != crc32c(0, in, 36))
+        return e_bad_header;
+    h->index = (int)get_le(in + 6, 2);
+    h->count = (int)get_le(in + 8, 2);
+    h->set_id = get_le(in + 12, 8);
+    h->total = (int64_t)get_le(in + 20, 8);
+    h->offset = (int64_t)get_le(in + 28, 8);
+    return (h->count > 0 && h->index < h->count && h->total >= 0 && h->offset >= 0) ? e_success
+                                                                                     : e_bad_header;
+}
+
+/* ===================== ONE SEGMENT PER COVER ===================== */
+typedef struct
+{
+    const char *cover_fname;
+    char *out_fname;                 // <prefix>_<n>.bmp
+    MappedFile cover;
+    PixelView view;
+    SpanHeader header;
+    int64_t length;                  // secret bytes in this segment
+    StegoInfo stego;                 // layout, worked out by the task
+    Status status;
+} SpanSegment;
+
+typedef struct
+{
+    SpanSegment *segs;
+    const unsigned char *secret;     // mapped secret
+    const char *extn;
+    StegoOptions opts;
+    Progress *progress;
+} SpanEncodeRun;
+
+/* Segment byte k: the sequence header first, then the secret slice */
+static Status embed_segment(SpanSegment *seg, const unsigned char *slice, int out_fd, Progress *progress)
+{
+    const StegoInfo *info = &seg->stego;
+    const unsigned char *cover = seg->cover.data;
+    unsigned char header[SPAN_HEADER_SIZE];
+    unsigned char block[STEGO_SPAN_MAX(LSB_BLOCK_SIZE)];
+
+    write_span_header(&seg->header, header);
+    stego_embed_header(info, cover + info->header_offset, block);
+    if (write_all_at(out_fd, block, info->data_offset - info->header_offset, info->header_offset) != e_success)
+        return e_failure;
+
+    stego_embed_data(info, 0, header, SPAN_HEADER_SIZE, cover + stego_data_pos(info, 0), block);
+    if (write_all_at(out_fd, block, stego_data_span(info, 0, SPAN_HEADER_SIZE), stego_data_pos(info, 0)) != e_success)
+        return e_failure;
+    uint32_t crc = crc32c(0, header, SPAN_HEADER_SIZE);
+
+    for (int64_t done = 0; done < seg->length; done += LSB_BLOCK_SIZE)
+    {
+        size_t n = (seg->length - done > LSB_BLOCK_SIZE) ? LSB_BLOCK_SIZE : (size_t)(seg->length - done);
+        int64_t k = SPAN_HEADER_SIZE + done;
+        int64_t pos = stego_data_pos(info, k);
+
+        stego_embed_data(info, k, slice + done, n, cover + pos, block);
+        crc = crc32c(crc, slice + done, n);
+        if (write_all_at(out_fd, block, stego_data_span(info, k, n), pos) != e_success) return e_failure;
+        progress_add(progress, n);
+    }
+
+    if (info->flags & STEGO_FLAG_CRC)
+    {
+        stego_embed_crc(info, crc, cover + info->crc_offset, block);
+        if (write_all_at(out_fd, block, info->end_offset - info->crc_offset, info->crc_offset) != e_success)
+            return e_failure;
+    }
+    return e_success;
+}
+
+static void encode_segment_task(void *ctx, int index)
+{
+    SpanEncodeRun *run = ctx;
+    SpanSegment *seg = &run->segs[index];
+
+    /* stego_plan derives a key per image with a passphrase: that runs in parallel too */
+    seg->status = stego_plan(&seg->view, run->extn, SPAN_HEADER_SIZE + seg->length, &run->opts, &seg->stego);
+    if (seg->status != e_success) return;
+
+    int out_fd = open(seg->out_fname, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out_fd < 0)
+    {
+        seg->status = e_failure;
+        return;
+    }
+    int cloned = (clone_file(seg->cover.fd, out_fd) == e_success);
+    const StegoInfo *info = &seg->stego;
+
+    seg->status = embed_segment(seg, run->secret + seg->header.offset, out_fd, run->progress);
+    if (seg->status == e_success && !cloned &&
+        (write_all_at(out_fd, seg->cover.data, info->header_offset, 0) != e_success ||
+         copy_file_tail(seg->cover.fd, out_fd, info->end_offset, seg->cover.size - info->end_offset) != e_success))
+        seg->status = e_failure;
+    if (close(out_fd) != 0) seg->status = e_failure;
+}
+
+/* ===================== -s: ONE SECRET, MANY COVERS ===================== */
+Status do_span_encoding(EncodeInfo *encInfo, const char *prefix, char *covers[], int count)
+{
+    MappedFile secret;
+    SpanSegment *segs = calloc(count, sizeof(*segs));
+    int used = 0;
+    Status ret = segs ? e_success : e_failure;
+
+    /* only the extension is stored, from the same list as -e */
+    const char *slash = strrchr(encInfo->secret_fname, '/');
+    const char *dot = strrchr(slash ? slash + 1 : encInfo->secret_fname, '.');
+    const char *extn = dot ? dot : "";
+
+    StegoOptions opts = { .depth = encInfo->depth, .flags = STEGO_FLAG_SEGMENT };
+    if (encInfo->crc) opts.flags |= STEGO_FLAG_CRC;
+    if (encInfo->passphrase)
+    {
+        opts.flags |= STEGO_FLAG_CHACHA;
+        opts.passphrase = encInfo->passphrase;
+    }
+
+    cprintf("\n───────────────────────────────────────────────\n");
+    cprintf("🕵️  STEGANOGRAPHY TOOL - SPANNED ENCODING STARTED\n");
+    cprintf("───────────────────────────────────────────────\n");
+    cprintf("📁 Secret File : %s\n", encInfo->secret_fname);
+    cprintf("📁 Covers      : %d\n\n", count);
+
+    /* Step 1: Map the secret */
+    cprintf("   1️⃣  Mapping secret file ............... ");
+    if (ret == e_success && !stego_extn_supported(extn))
+    {
+        cprintf("✖️\n\n🎯 STATUS: FAILED — Secret file type not supported (.txt, .c, .h, .sh)\n");
+        ret = e_failure;
+    }
+    else if (ret == e_success && map_file(encInfo->secret_fname, &secret) != e_success)
+    {
+        cprintf("✖️\n\n🎯 STATUS: FAILED — Cannot map secret file: %s\n", encInfo->secret_fname);
+        ret = e_failure;
+    }
+    else if (ret == e_success && secret.size == 0)
+    {
+        cprintf("✖️\n\n🎯 STATUS: FAILED — Secret file is empty.\n");
+        unmap_file(&secret);
+        ret = e_failure;
+    }
+    if (ret != e_success)
+    {
+        cprintf("───────────────────────────────────────────────\n");
+        free(segs);
+        return e_failure;
+    }
+    cprintf("✔️  (%" PRId64 " bytes)\n", (int64_t)secret.size);
+
+    /* Step 2: Cut the secret into segments, each as large as its cover holds */
+    cprintf("   2️⃣  Sizing segments to the covers ..... ");
+    int64_t placed = 0;
+    for (int i = 0; i < count && placed < secret.size && ret == e_success; i++)
+    {
+        SpanSegment *seg = &segs[used];
+        int64_t capacity = 0;
+        size_t need;
+
+        if (map_file(covers[i], &seg->cover) != e_success)
+        {
+            cprintf("✖️\n\n🎯 STATUS: FAILED — Cannot map image: %s\n", covers[i]);
+            ret = e_failure;
+            break;
+        }
+        if (stego_parse_bmp(seg->cover.data, seg->cover.size, seg->cover.size, &seg->view, &need) != e_success)
+        {
+            unmap_file(&seg->cover);
+            memset(seg, 0, sizeof(*seg));
+            cprintf("✖️\n\n🎯 STATUS: FAILED — Not a usable BMP cover: %s\n", covers[i]);
+            ret = e_failure;
+            break;
+        }
+        stego_capacity(&seg->view, strlen(extn), &opts, &capacity);
+        if (capacity <= SPAN_HEADER_SIZE)
+        {
+            unmap_file(&seg->cover);            // too small to carry anything, skipped
+            memset(seg, 0, sizeof(*seg));
+            continue;
+        }
+
+        seg->cover_fname = covers[i];
+        seg->header.offset = placed;
+        seg->length = (secret.size - placed < capacity - SPAN_HEADER_SIZE) ? secret.size - placed
+                                                                           : capacity - SPAN_HEADER_SIZE;
+        placed += seg->length;
+        used++;
+    }
+    if (ret == e_success && placed < secret.size)
+    {
+        cprintf("✖️\n\n🎯 STATUS: FAILED — The covers hold %" PRId64 " of %" PRId64 " bytes.\n",
+                placed, (int64_t)secret.size);
+        ret = e_failure;
+    }
+    if (ret == e_success && used > SPAN_SEGMENTS_MAX)
+    {
+        cprintf("✖️\n\n🎯 STATUS: FAILED — More than %d segments.\n", SPAN_SEGMENTS_MAX);
+        ret = e_failure;
+    }
+
+    uint64_t set_id = 0;
+    if (ret == e_success && cipher_random((unsigned char *)&set_id, sizeof(set_id)) != e_success)
+    {
+        cprintf("✖️\n\n🎯 STATUS: FAILED — No random bytes for the set id.\n");
+        ret = e_failure;
+    }
+    for (int s = 0; ret == e_success && s < used; s++)
+    {
+        size_t len = strlen(prefix) + 16;
+        segs[s].out_fname = malloc(len);
+        if (!segs[s].out_fname)
+        {
+            ret = e_failure;
+            break;
+        }
+        snprintf(segs[s].out_fname, len, "%s_%d.bmp", prefix, s + 1);
+        segs[s].header.index = s;
+        segs[s].header.count = used;
+        segs[s].header.set_id = set_id;
+        segs[s].header.total = secret.size;
+    }
+    if (ret == e_success)
+        cprintf("✔️  (%d segment(s), %d cover(s) not needed)\n", used, count - used);
+
+    /* Step 3: Every segment at once, one task per cover */
+    if (ret == e_success)
+    {
+        Progress progress;
+        SpanEncodeRun run = { segs, secret.data, extn, opts, &progress };
+        int workers = encInfo->threads > 0 ? encInfo->threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+        cprintf("   3️⃣  Embedding %d segment(s) ........... ⏳\n\n", used);
+        cprintf("⚙️  Encoding Secret Data...\n");
+        progress_start(&progress, encInfo->progress, "encode", secret.size);
+        run_tasks(workers, used, encode_segment_task, &run);
+        progress_finish(&progress);
+
+        for (int s = 0; s < used; s++)
+        {
+            if (segs[s].status != e_success)
+            {
+                cprintf("[ERROR] %s (from %s): %s\n", segs[s].out_fname, segs[s].cover_fname,
+                        stego_strerror(segs[s].status));
+                ret = e_failure;
+            }
+        }
+        if (ret == e_success)
+            cprintf(GREEN "✔ Encoding Completed Successfully!" RESET "\n");
+        else
+            cprintf("\n🎯 STATUS: FAILED — Error while encoding the segments.\n");
+    }
+
+    if (ret == e_success)
+    {
+        cprintf("\n🎯 STATUS: SUCCESS — Secret spread over %d image(s)!\n", used);
+        for (int s = 0; s < used; s++)
+            cprintf("📌 %s ← %s : bytes %" PRId64 "..%" PRId64 "\n", segs[s].out_fname, segs[s].cover_fname,
+                    segs[s].header.offset, segs[s].header.offset + segs[s].length);
+    }
+    cprintf("───────────────────────────────────────────────\n");
+
+    for (int s = 0; s < used; s++)
+    {
+        unmap_file(&segs[s].cover);
+        free(segs[s].out_fname);
+    }
+    free(segs);
+    unmap_file(&secret);
+    return ret;
+}
+
+/* ===================== READ EVERY SEQUENCE HEADER ===================== */
+typedef struct
+{
+    const char *fname;
+    int fd;
+    StegoInfo stego;
+    unsigned char raw[SPAN_HEADER_SIZE];  // sequence header as stored (the CRC covers it)
+    SpanHeader header;
+    int64_t length;                  // secret bytes in this segment
+    Status status;
+} SpanImage;
+
+typedef struct
+{
+    SpanImage *images;
+    const char *passphrase;
+    int out_fd;                      // reassembled secret, written with pwrite
+    Progress *progress;
+} SpanDecodeRun;
+
+/* Hidden header, key and sequence header of one image: a few small preads */
+static Status read_segment_header(SpanImage *img, const char *passphrase)
+{
+    unsigned char buf[SPAN_READ];
+    unsigned char region[STEGO_HEADER_MAX];
+    struct stat st;
+    PixelView view;
+    size_t need;
+
+    if ((img->fd = open(img->fname, O_RDONLY | O_CLOEXEC)) < 0 || fstat(img->fd, &st) != 0 ||
+        !S_ISREG(st.st_mode))
+        return e_failure;
+    ssize_t got = pread(img->fd, buf, sizeof(buf), 0);
+    if (got < 0 || stego_parse_bmp(buf, got, st.st_size, &view, &need) != e_success) return e_bad_image;
+
+    got = pread(img->fd, region, sizeof(region), view.offset);
+    Status ret = stego_read_header(&view, region, got > 0 ? got : 0, &img->stego, &need);
+    if (ret == e_short_buffer) ret = e_bad_image;
+    if (ret != e_success) return ret;
+    if (!(img->stego.flags & STEGO_FLAG_SEGMENT) || img->stego.size < SPAN_HEADER_SIZE) return e_bad_header;
+
+    ret = stego_unlock(&img->stego, passphrase);
+    if (ret != e_success) return ret;
+
+    size_t span = stego_data_span(&img->stego, 0, SPAN_HEADER_SIZE);
+    if (read_all_at(img->fd, buf, span, stego_data_pos(&img->stego, 0)) != e_success) return e_bad_image;
+    if (stego_extract_data(&img->stego, 0, buf, SPAN_HEADER_SIZE, img->raw) != e_success) return e_bad_header;
+    img->length = img->stego.size - SPAN_HEADER_SIZE;
+    return read_span_header(img->raw, &img->header);
+}
+
+static void read_header_task(void *ctx, int index)
+{
+    SpanDecodeRun *run = ctx;
+    run->images[index].status = read_segment_header(&run->images[index], run->passphrase);
+}
+
+/* ===================== EXTRACT ONE SEGMENT PER TASK ===================== */
+static Status extract_segment(SpanImage *img, int out_fd, Progress *progress)
+{
+    const StegoInfo *info = &img->stego;
+    unsigned char block[STEGO_SPAN_MAX(LSB_BLOCK_SIZE)];
+    unsigned char data[LSB_BLOCK_SIZE];
+    uint32_t crc = crc32c(0, img->raw, SPAN_HEADER_SIZE);     // the CRC covers the sequence header too
+
+    for (int64_t done = 0; done < img->length; done += LSB_BLOCK_SIZE)
+    {
+        size_t n = (img->length - done > LSB_BLOCK_SIZE) ? LSB_BLOCK_SIZE : (size_t)(img->length - done);
+        int64_t k = SPAN_HEADER_SIZE + done;
+
+        if (read_all_at(img->fd, block, stego_data_span(info, k, n), stego_data_pos(info, k)) != e_success)
+            return e_bad_image;
+        if (stego_extract_data(info, k, block, n, data) != e_success) return e_bad_crc;
+        crc = crc32c(crc, data, n);
+        if (write_all_at(out_fd, data, n, img->header.offset + done) != e_success) return e_failure;
+        progress_add(progress, n);
+    }
+
+    if (info->flags & STEGO_FLAG_CRC)
+    {
+        if (read_all_at(img->fd, block, info->end_offset - info->crc_offset, info->crc_offset) != e_success)
+            return e_bad_image;
+        if (stego_extract_crc(info, block) != crc) return e_bad_crc;
+    }
+    return e_success;
+}
+
+static void extract_segment_task(void *ctx, int index)
+{
+    SpanDecodeRun *run = ctx;
+    run->images[index].status = extract_segment(&run->images[index], run->out_fd, run->progress);
+}
+
+/* ===================== ORDER AND COMPLETENESS ===================== */
+/* order[i] = image holding segment i; the set must be whole and consistent */
+static Status order_segments(SpanImage *images, int count, int *order)
+{
+    const SpanHeader *first = &images[0].header;
+
+    if (first->count != count)
+    {
+        cprintf("✖️\n\n🎯 STATUS: FAILED — The set has %d segment(s), %d image(s) given.\n", first->count, count);
+        return e_failure;
+    }
+    for (int i = 0; i < count; i++) order[i] = -1;
+    for (int i = 0; i < count; i++)
+    {
+        const SpanHeader *h = &images[i].header;
+        if (h->set_id != first->set_id || h->count != first->count || h->total != first->total)
+        {
+            cprintf("✖️\n\n🎯 STATUS: FAILED — %s belongs to another set.\n", images[i].fname);
+            return e_failure;
+        }
+        if (order[h->index] >= 0)
+        {
+            cprintf("✖️\n\n🎯 STATUS: FAILED — Segment %d given twice (%s, %s).\n", h->index + 1,
+                    images[order[h->index]].fname, images[i].fname);
+            return e_failure;
+        }
+        order[h->index] = i;
+    }
+
+    int64_t offset = 0;
+    for (int s = 0; s < count; s++)
+    {
+        const SpanImage *img = &images[order[s]];
+        if (img->header.offset != offset || img->length > first->total - offset)
+        {
+            cprintf("✖️\n\n🎯 STATUS: FAILED — Segment %d (%s) does not follow on.\n", s + 1, img->fname);
+            return e_failure;
+        }
+        offset += img->length;
+    }
+    if (offset != first->total)
+    {
+        cprintf("✖️\n\n🎯 STATUS: FAILED — Segments hold %" PRId64 " of %" PRId64 " bytes.\n", offset, first->total);
+        return e_failure;
+    }
+    return e_success;
+}
+
+/* ===================== -m: PUT A SPANNED SECRET BACK TOGETHER ===================== */
+Status do_span_decoding(DecodeInfo *decInfo, char *images[], int count)
+{
+    SpanImage *imgs = calloc(count, sizeof(*imgs));
+    int *order = calloc(count, sizeof(*order));
+    int workers = decInfo->threads > 0 ? decInfo->threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    char *out_fname = NULL;
+    Status ret = (imgs && order) ? e_success : e_failure;
+
+    cprintf("\n───────────────────────────────────────────────\n");
+    cprintf("🕵️  STEGANOGRAPHY TOOL - SPANNED DECODING STARTED\n");
+    cprintf("───────────────────────────────────────────────\n");
+    cprintf("📁 Images      : %d\n\n", count);
+
+    for (int i = 0; imgs && i < count; i++)
+    {
+        imgs[i].fname = images[i];
+        imgs[i].fd = -1;
+    }
+
+    /* Step 1: Sequence headers of every image, in parallel (each may derive a key) */
+    cprintf("   1️⃣  Reading sequence headers .......... ");
+    SpanDecodeRun run = { imgs, decInfo->passphrase, -1, NULL };
+    if (ret == e_success && !strcmp(decInfo->secret_fname, STREAM_NAME))
+    {
+        cprintf("✖️\n\n🎯 STATUS: FAILED — A spanned secret is written with pwrite, not to stdout.\n");
+        ret = e_failure;
+    }
+    if (ret == e_success)
+    {
+        run_tasks(workers, count, read_header_task, &run);
+        for (int i = 0; i < count; i++)
+        {
+            if (imgs[i].status == e_success) continue;
+            if (ret == e_success) cprintf("✖️\n\n");
+            cprintf("[ERROR] %s: %s\n", imgs[i].fname,
+                    imgs[i].status == e_failure ? "cannot open file" :
+                    imgs[i].status == e_bad_header ? "not a segment of a spanned secret"
+                                                   : stego_strerror(imgs[i].status));
+            ret = e_failure;
+        }
+        if (ret != e_success) cprintf("\n🎯 STATUS: FAILED — Unreadable segment image(s).\n");
+    }
+    if (ret == e_success) ret = order_segments(imgs, count, order);
+    if (ret == e_success)
+        cprintf("✔️  (%d segment(s), %" PRId64 " bytes%s)\n", count, imgs[0].header.total,
+                (imgs[0].stego.flags & STEGO_FLAG_CHACHA) ? ", ChaCha20" : "");
+
+    /* Step 2: Output file, sized up front so segments land at their offsets */
+    if (ret == e_success)
+    {
+        cprintf("   2️⃣  Creating output file .............. ");
+        size_t len = strlen(decInfo->secret_fname) + strlen(imgs[order[0]].stego.extn) + 1;
+        out_fname = malloc(len);
+        if (out_fname) snprintf(out_fname, len, "%s%s", decInfo->secret_fname, imgs[order[0]].stego.extn);
+        run.out_fd = out_fname ? open(out_fname, O_WRONLY | O_CREAT | O_TRUNC, 0644) : -1;
+        if (run.out_fd < 0 || ftruncate(run.out_fd, imgs[0].header.total) != 0)
+        {
+            cprintf("✖️\n\n🎯 STATUS: FAILED — Could not create the output file.\n");
+            ret = e_failure;
+        }
+        else
+        {
+            cprintf("✔️  (%s)\n", out_fname);
+        }
+    }
+
+    /* Step 3: Every image at once */
+    if (ret == e_success)
+    {
+        Progress progress;
+        run.progress = &progress;
+
+        cprintf("   3️⃣  Extracting %d segment(s) .......... ⏳\n", count);
+        cprintf("\n⚙️  Extracting Secret Data...\n");
+        progress_start(&progress, decInfo->progress, "decode", imgs[0].header.total);
+        run_tasks(workers, count, extract_segment_task, &run);
+        progress_finish(&progress);
+
+        for (int s = 0; s < count; s++)
+        {
+            const SpanImage *img = &imgs[order[s]];
+            if (img->status == e_success) continue;
+            cprintf("[ERROR] Segment %d (%s): %s\n", s + 1, img->fname,
+                    stego_strerror(img->status));
+            ret = e_failure;
+        }
+        if (ret == e_success)
+            cprintf(GREEN "✔ Secret Data Extracted Successfully!" RESET "\n");
+        cprintf("\n🎯 STATUS: %s\n", ret == e_success ? "SUCCESS — Secret restored!"
+                                                     : "FAILED — Segment data is corrupt or truncated.");
+        if (ret == e_success) cprintf("📌 Extracted File: %s\n", out_fname);
+    }
+    cprintf("───────────────────────────────────────────────\n\n");
+
+    if (run.out_fd >= 0 && close(run.out_fd) != 0) ret = e_failure;
+    for (int i = 0; imgs && i < count; i++)
+        if (imgs[i].fd >= 0) close(imgs[i].fd);
+    free(out_fname);
+    free(order);
+    free(imgs);
+    return ret;
+}
@@ -0,0 +1,40 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include "types.h"
+#include "encode.h"
+#include "decode.h"
+
+/*----------------------------------------------------------
+    Spanning: one secret across several cover images
+
+    -s cuts the secret into ordered segments, each as large as its
+    cover can hold, and embeds them all at once on -j threads. Every
+    segment is the hidden data of a "#*" image flagged
+    STEGO_FLAG_SEGMENT and starts with a sequence header, little endian:
+        magic "STGS" | version | 0 | index (16) | count (16) | 0 (16)
+        | set id (64) | secret size (64) | segment offset (64)
+        | CRC32C of bytes 0..35
+    followed by the segment's bytes of the secret. -m reads only these
+    headers to put the images back in order, whatever order they are
+    given in, then extracts every image in parallel with pwrite at its
+    offset. The set id is random, so images of two different runs are
+    never mixed.
+----------------------------------------------------------*/
+
+#define SPAN_MAGIC "STGS"
+#define SPAN_VERSION 1
+#define SPAN_HEADER_SIZE 40
+#define SPAN_SEGMENTS_MAX 65535
+
+/* Hide encInfo->secret_fname across covers[0..count), in that order,
+   writing <prefix>_1.bmp, <prefix>_2.bmp, ... (one per cover used).
+   depth, crc, passphrase, threads and progress come from encInfo. */
+Status do_span_encoding(EncodeInfo *encInfo, const char *prefix, char *covers[], int count);
+
+/* Put the secret of images[0..count) back together into
+   decInfo->secret_fname plus the stored extension (passphrase, threads
+   and progress come from decInfo) */
+Status do_span_decoding(DecodeInfo *decInfo, char *images[], int count);
+
+#endif // SPAN_H
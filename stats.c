@@ -0,0 +1,79 @@
+#define _XOPEN_SOURCE 700   // clock_gettime, MUST be first line
+#include <inttypes.h>       // PRId64
+#include <string.h>
+#include <time.h>
+#include "stats.h"
+
+/* ===================== PHASE NAMES (JSON keys, same order as StatsPhase) ===================== */
+static const char *const phase_names[STATS_PHASES] = {
+    "open", "plan", "header", "fields", "unlock", "data", "tail", "close"
+};
+
+/* ===================== JOB CLOCK ===================== */
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void stats_begin(StegoStats *s, const char *op)
+{
+#if STATS_ENABLED
+    if (!s) return;
+    memset(s, 0, sizeof(*s));
+    s->op = op;
+    s->phase = -1;
+    s->start = now_ns();
+#else
+    (void)s;
+    (void)op;
+#endif
+}
+
+void stats_phase_switch(StegoStats *s, StatsPhase phase)
+{
+    int64_t now = now_ns();
+
+    if (s->phase >= 0) s->phase_ns[s->phase] += now - s->phase_start;
+    s->phase = phase;
+    s->phase_start = now;
+}
+
+void stats_end(StegoStats *s, int ok)
+{
+#if STATS_ENABLED
+    if (!s) return;
+    int64_t now = now_ns();
+    if (s->phase >= 0) s->phase_ns[s->phase] += now - s->phase_start;
+    s->phase = -1;
+    s->total_ns = now - s->start;
+    s->ok = ok;
+#else
+    (void)s;
+    (void)ok;
+#endif
+}
+
+/* ===================== ONE JSON LINE ===================== */
+static double mb_per_s(int64_t bytes, int64_t ns)
+{
+    return ns > 0 ? bytes / (ns / 1e9) / 1e6 : 0.0;
+}
+
+void stats_print(const StegoStats *s, FILE *fp)
+{
+    int64_t rd = atomic_load(&s->bytes_read), wr = atomic_load(&s->bytes_written);
+
+    fprintf(fp, "{\"op\":\"%s\",\"ok\":%s,\"seconds\":%.6f,\"phases\":{", s->op ? s->op : "",
+            s->ok ? "true" : "false", s->total_ns / 1e9);
+    for (int i = 0; i < STATS_PHASES; i++)
+        fprintf(fp, "%s\"%s\":%.6f", i ? "," : "", phase_names[i], s->phase_ns[i] / 1e9);
+    fprintf(fp, "},\"data_bytes\":%" PRId64 ",\"bytes_read\":%" PRId64 ",\"bytes_written\":%" PRId64
+                ",\"bytes_copied\":%" PRId64 ",\"read_calls\":%" PRId64 ",\"write_calls\":%" PRId64
+                ",\"copy_calls\":%" PRId64 ",\"data_mb_s\":%.2f,\"io_mb_s\":%.2f}\n",
+            s->data_bytes, rd, wr, atomic_load(&s->bytes_copied), atomic_load(&s->read_calls),
+            atomic_load(&s->write_calls), atomic_load(&s->copy_calls),
+            mb_per_s(s->data_bytes, s->phase_ns[e_phase_data]), mb_per_s(rd + wr, s->total_ns));
+    fflush(fp);
+}
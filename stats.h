@@ -0,0 +1,137 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <stdint.h>      // int64_t
+#include <stdatomic.h>
+
+/*----------------------------------------------------------
+    Per-job instrumentation (--stats)
+
+    An encode or decode job with EncodeInfo.stats / DecodeInfo.stats
+    set fills the caller's StegoStats: monotonic time per phase,
+    bytes read, written and copied in the kernel, and the number
+    of I/O calls behind them. A NULL pointer turns every hook
+    into one predicted branch. Building with -DSTEGO_NO_STATS
+    removes the hooks altogether (the struct stays, so callers
+    still compile; it is left zeroed).
+
+    Calls count the reads and writes the job issues (fread /
+    fwrite on the sequential path, pread / pwrite on the mapped
+    and threaded ones, one per copy_file_tail). Retries of short
+    transfers and stdio refills underneath are not counted.
+    Bytes taken from a mapped file count as read, with no call.
+----------------------------------------------------------*/
+
+#ifdef STEGO_NO_STATS
+#define STATS_ENABLED 0
+#else
+#define STATS_ENABLED 1
+#endif
+
+typedef enum
+{
+    e_phase_open,                     // opening / mapping files, BMP headers
+    e_phase_plan,                     // capacity check, layout, packing the secret
+    e_phase_header,                   // copying the BMP headers (or cloning the cover)
+    e_phase_fields,                   // hidden magic, extension and size
+    e_phase_unlock,                   // key derivation for an encrypted secret
+    e_phase_data,                     // the secret data and its CRC
+    e_phase_tail,                     // copying the untouched rest of the image
+    e_phase_close,                    // flushing and closing the outputs
+    STATS_PHASES
+} StatsPhase;
+
+typedef struct _StegoStats
+{
+    const char *op;                   // "encode" / "decode"
+    int ok;                           // the job succeeded
+    int64_t phase_ns[STATS_PHASES];   // time spent in each phase
+    int64_t total_ns;                 // stats_begin to stats_end
+    int64_t data_bytes;               // secret bytes embedded / extracted
+    _Atomic int64_t bytes_read;       // from the cover / stego image and the secret
+    _Atomic int64_t bytes_written;    // to the output image / secret
+    _Atomic int64_t bytes_copied;     // moved inside the kernel (copy_file_range, sendfile)
+    _Atomic int64_t read_calls;
+    _Atomic int64_t write_calls;
+    _Atomic int64_t copy_calls;
+
+    /* internal: the phase being timed */
+    int phase;                        // -1 = none
+    int64_t phase_start;
+    int64_t start;
+} StegoStats;
+
+/* Zero s and start the job clock */
+void stats_begin(StegoStats *s, const char *op);
+
+/* Close the phase being timed; the clock now runs for `phase` */
+void stats_phase_switch(StegoStats *s, StatsPhase phase);
+
+/* Close the last phase and stop the job clock */
+void stats_end(StegoStats *s, int ok);
+
+/* One JSON object (and a newline) for s on fp */
+void stats_print(const StegoStats *s, FILE *fp);
+
+static inline void stats_phase(StegoStats *s, StatsPhase phase)
+{
+#if STATS_ENABLED
+    if (s) stats_phase_switch(s, phase);
+#else
+    (void)s;
+    (void)phase;
+#endif
+}
+
+/* Secret bytes the data phase got through */
+static inline void stats_data(StegoStats *s, int64_t n)
+{
+#if STATS_ENABLED
+    if (s) s->data_bytes = n;
+#else
+    (void)s;
+    (void)n;
+#endif
+}
+
+/* calls I/O calls moving n bytes in total; thread safe */
+static inline void stats_read(StegoStats *s, int64_t n, int64_t calls)
+{
+#if STATS_ENABLED
+    if (!s) return;
+    atomic_fetch_add_explicit(&s->bytes_read, n, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->read_calls, calls, memory_order_relaxed);
+#else
+    (void)s;
+    (void)n;
+    (void)calls;
+#endif
+}
+
+static inline void stats_write(StegoStats *s, int64_t n, int64_t calls)
+{
+#if STATS_ENABLED
+    if (!s) return;
+    atomic_fetch_add_explicit(&s->bytes_written, n, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->write_calls, calls, memory_order_relaxed);
+#else
+    (void)s;
+    (void)n;
+    (void)calls;
+#endif
+}
+
+static inline void stats_copy(StegoStats *s, int64_t n)
+{
+#if STATS_ENABLED
+    if (!s) return;
+    atomic_fetch_add_explicit(&s->bytes_copied, n, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->copy_calls, 1, memory_order_relaxed);
+#else
+    (void)s;
+    (void)n;
+#endif
+}
+
+#endif // STATS_H
@@ -0,0 +1,969 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "stego.h"
+#include "common.h"
+#include "lsb.h"
+#include "lz.h"
+#include "crc32c.h"
+#include "cipher.h"
+#include "rs.h"
+
+#define RS_FLAG_COPY 0x100          // second copy of STEGO_FLAG_RS in the stored flags
+
+/* ===================== SMALL LITTLE ENDIAN HELPERS ===================== */
+static void put_le32(unsigned char *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) p[i] = (v >> (i * 8)) & 0xFF;
+}
+
+static uint32_t get_le32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put_le64(unsigned char *p, uint64_t v)
+{
+    put_le32(p, (uint32_t)v);
+    put_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint64_t get_le64(const unsigned char *p)
+{
+    return get_le32(p) | ((uint64_t)get_le32(p + 4) << 32);
+}
+
+/* ===================== ERROR TEXT ===================== */
+const char *stego_strerror(Status status)
+{
+    switch (status)
+    {
+        case e_success:      return "success";
+        case e_bad_image:    return "not a usable BMP image";
+        case e_no_capacity:  return "image too small to hide secret";
+        case e_no_secret:    return "no hidden data (magic signature not found)";
+        case e_bad_header:   return "hidden header is corrupt";
+        case e_short_buffer: return "buffer too small";
+        case e_bad_data:     return "hidden data is corrupt";
+        case e_bad_crc:      return "hidden data failed its CRC32C or ECC check";
+        case e_bad_key:      return "wrong or missing passphrase";
+        default:             return "failure";
+    }
+}
+
+/* ===================== SECRET FILE EXTENSIONS ===================== */
+int stego_extn_supported(const char *extn)
+{
+    static const char *const allowed[] = { ".txt", ".c", ".h", ".sh", "" };
+
+    for (size_t i = 0; i < sizeof(allowed) / sizeof(allowed[0]); i++)
+        if (!strcmp(extn, allowed[i])) return 1;
+    return 0;
+}
+
+/* ===================== BMP HEADER -> PIXEL VIEW ===================== */
+Status stego_parse_bmp(const unsigned char *header, size_t header_len, size_t image_len,
+                       PixelView *view, size_t *need)
+{
+    *need = STEGO_BMP_HEADER;
+    if (header_len < *need) return (image_len < *need) ? e_bad_image : e_short_buffer;
+    if (header[0] != 'B' || header[1] != 'M') return e_bad_image;
+
+    uint32_t info_size = get_le32(header + 14);
+    int bpp = header[28] | (header[29] << 8);
+    uint32_t compression = get_le32(header + 30);
+
+    /* INFO (40), V2 (52), V3 (56), V4 (108), V5 (124); OS/2 core headers are not supported */
+    if (info_size != 40 && info_size != 52 && info_size != 56 &&
+        info_size != 108 && info_size != 124)
+        return e_bad_image;
+    if (bpp != 24 && bpp != 32) return e_bad_image;        // palettes have no room for LSBs
+    if (compression != 0 && !(compression == 3 && bpp == 32)) return e_bad_image;
+
+    /* BI_BITFIELDS masks follow a 40 byte header, or sit inside a longer one */
+    *need = 14 + info_size;
+    if (compression == 3 && *need < 14 + 40 + 12) *need = 14 + 40 + 12;
+    if (header_len < *need) return (image_len < *need) ? e_bad_image : e_short_buffer;
+    if (compression == 3 &&
+        (get_le32(header + 54) != 0x00FF0000 || get_le32(header + 58) != 0x0000FF00 ||
+         get_le32(header + 62) != 0x000000FF))
+        return e_bad_image;                                // only plain BGR(A/X) byte order
+
+    int32_t width = (int32_t)get_le32(header + 18);
+    int32_t height = (int32_t)get_le32(header + 22);
+    int64_t offset = get_le32(header + 10);
+    if (width <= 0 || height == 0 || height == INT32_MIN) return e_bad_image;
+    if (offset < (int64_t)*need) return e_bad_image;       // pixels overlap the headers
+
+    view->offset = offset;
+    view->bytes_per_pixel = bpp / 8;
+    view->channels = 3;                                    // B, G, R; alpha is left alone
+    view->width = width;
+    view->top_down = height < 0;
+    view->height = height < 0 ? -(int64_t)height : height;
+    view->stride = ((int64_t)width * bpp + 31) / 32 * 4;   // rows are padded to 4 bytes
+    view->row_bytes = (int64_t)width * view->channels;
+    view->rows = view->height;
+
+    /* a truncated file only offers its complete rows */
+    if (image_len != STEGO_LEN_UNKNOWN)
+    {
+        if ((uint64_t)image_len < (uint64_t)offset) return e_bad_image;
+        int64_t present = (int64_t)((image_len - offset) / view->stride);
+        if (present < view->rows) view->rows = present;
+    }
+
+    /* all offset math below is int64_t: the pixel array has to fit in it */
+    if (view->rows > (INT64_MAX - offset) / view->stride) return e_bad_image;
+    return e_success;
+}
+
+/* ===================== CARRIER BYTES ===================== */
+int64_t stego_carrier_offset(const PixelView *view, int64_t carrier)
+{
+    int64_t row = carrier / view->row_bytes;
+    int64_t col = carrier % view->row_bytes;
+
+    return view->offset + row * view->stride
+           + (col / view->channels) * view->bytes_per_pixel + col % view->channels;
+}
+
+static int64_t view_carriers(const PixelView *view)
+{
+    return view->rows * view->row_bytes;
+}
+
+/* 24-bit rows without padding: carrier c is simply image byte offset + c */
+static int view_contiguous(const PixelView *view)
+{
+    return view->channels == view->bytes_per_pixel && view->stride == view->row_bytes;
+}
+
+/* Pack count carriers starting at carrier c out of an image window holding
+   the image bytes from win_off on. Works one row run at a time. */
+static void gather(const PixelView *view, int64_t c, size_t count,
+                   const unsigned char *win, int64_t win_off, unsigned char *packed)
+{
+    while (count > 0)
+    {
+        int64_t col = c % view->row_bytes;
+        size_t run = view->row_bytes - col;
+        if (run > count) run = count;
+        const unsigned char *p = win + (stego_carrier_offset(view, c) - win_off);
+
+        if (view->channels == view->bytes_per_pixel)
+        {
+            memcpy(packed, p, run);                        // the row run is contiguous
+        }
+        else
+        {
+            int ch = col % view->channels;
+            for (size_t i = 0; i < run; i++)
+            {
+                packed[i] = *p++;
+                if (++ch == view->channels)                // skip the alpha byte
+                {
+                    ch = 0;
+                    p += view->bytes_per_pixel - view->channels;
+                }
+            }
+        }
+        packed += run;
+        c += run;
+        count -= run;
+    }
+}
+
+/* Reverse of gather: put packed carriers back into the image window */
+static void scatter(const PixelView *view, int64_t c, size_t count,
+                    const unsigned char *packed, unsigned char *win, int64_t win_off)
+{
+    while (count > 0)
+    {
+        int64_t col = c % view->row_bytes;
+        size_t run = view->row_bytes - col;
+        if (run > count) run = count;
+        unsigned char *p = win + (stego_carrier_offset(view, c) - win_off);
+
+        if (view->channels == view->bytes_per_pixel)
+        {
+            memcpy(p, packed, run);
+        }
+        else
+        {
+            int ch = col % view->channels;
+            for (size_t i = 0; i < run; i++)
+            {
+                *p++ = packed[i];
+                if (++ch == view->channels)
+                {
+                    ch = 0;
+                    p += view->bytes_per_pixel - view->channels;
+                }
+            }
+        }
+        packed += run;
+        c += run;
+        count -= run;
+    }
+}
+
+/* Embed n payload bytes at depth bits per carrier into the carriers from c */
+static void embed_carriers(const PixelView *view, int64_t c, const unsigned char *payload,
+                           size_t n, int depth, const unsigned char *cover,
+                           unsigned char *out, int64_t win_off)
+{
+    size_t per = LSB_CARRIERS(depth);
+
+    if (view_contiguous(view))
+    {
+        int64_t at = stego_carrier_offset(view, c) - win_off;
+        lsb_embed_depth(depth, out + at, cover + at, payload, n);   // straight on the image bytes
+        return;
+    }
+
+    unsigned char packed[LSB_BLOCK_SIZE * 8];
+    while (n > 0)
+    {
+        size_t m = (n > LSB_BLOCK_SIZE) ? LSB_BLOCK_SIZE : n;
+        gather(view, c, per * m, cover, win_off, packed);
+        lsb_embed_depth(depth, packed, packed, payload, m);
+        scatter(view, c, per * m, packed, out, win_off);
+        c += per * m;
+        payload += m;
+        n -= m;
+    }
+}
+
+/* Extract n payload bytes at depth bits per carrier from the carriers from c */
+static void extract_carriers(const PixelView *view, int64_t c, unsigned char *payload,
+                             size_t n, int depth, const unsigned char *cover, int64_t win_off)
+{
+    size_t per = LSB_CARRIERS(depth);
+
+    if (view_contiguous(view))
+    {
+        lsb_extract_depth(depth, payload, cover + (stego_carrier_offset(view, c) - win_off), n);
+        return;
+    }
+
+    unsigned char packed[LSB_BLOCK_SIZE * 8];
+    while (n > 0)
+    {
+        size_t m = (n > LSB_BLOCK_SIZE) ? LSB_BLOCK_SIZE : n;
+        gather(view, c, per * m, cover, win_off, packed);
+        lsb_extract_depth(depth, payload, packed, m);
+        c += per * m;
+        payload += m;
+        n -= m;
+    }
+}
+
+/* ===================== CAPACITY ===================== */
+static int64_t field_bytes(int64_t extn_len, unsigned flags)
+{
+    int64_t size_len = (flags & STEGO_FLAG_SIZE64) ? 8 : 4;
+    int64_t len = strlen(MAGIC_STRING) + 4 + extn_len + size_len;   // header bytes before the data
+    if (flags & STEGO_FLAG_LZ) len += size_len;                      // original size
+    if (flags & STEGO_FLAG_CHACHA) len += CIPHER_SALT_SIZE + CIPHER_NONCE_SIZE + 4;
+    if (flags & STEGO_FLAG_SCATTER) len += 8;                        // permutation seed
+    if (flags & STEGO_FLAG_RS) len += 1 + STEGO_RS_HEADER_PARITY;    // ecc, parity of all the above
+    return len;
+}
+
+/* Carriers after the data: the CRC32C, at depth 1 like the header */
+static int64_t trailer_carriers(unsigned flags)
+{
+    if (!(flags & STEGO_FLAG_CRC)) return 0;
+    return 8 * (4 + ((flags & STEGO_FLAG_RS) ? STEGO_RS_HEADER_PARITY : 0));
+}
+
+/* Bytes one data block takes in the image, Reed-Solomon parity included */
+static int64_t block_stored(int ecc)
+{
+    return LSB_BLOCK_SIZE + (int64_t)RS_LANES * ecc;
+}
+
+/* Stored bytes of size data bytes: each block, the last one too, has its parity */
+static int64_t data_stored(int64_t size, int ecc)
+{
+    return size + (size + LSB_BLOCK_SIZE - 1) / LSB_BLOCK_SIZE * RS_LANES * ecc;
+}
+
+/* Carriers of one scatter slot: a whole stored block */
+static int64_t slot_carriers(int depth, int ecc)
+{
+    return (int64_t)LSB_CARRIERS(depth) * block_stored(ecc);
+}
+
+/* Data bytes that fit in room carriers; scattered data only fills whole slots */
+static int64_t data_capacity(int64_t room, int depth, unsigned flags, int ecc)
+{
+    if (room <= 0) return 0;
+    if (flags & STEGO_FLAG_SCATTER) return room / slot_carriers(depth, ecc) * LSB_BLOCK_SIZE;
+
+    int64_t stored = room / LSB_CARRIERS(depth), rest = stored % block_stored(ecc);
+    int64_t parity = (int64_t)RS_LANES * ecc;
+    return stored / block_stored(ecc) * LSB_BLOCK_SIZE + (rest > parity ? rest - parity : 0);
+}
+
+/* 64-bit size fields only when a size needs them */
+static unsigned size_flag(int64_t size, unsigned flags, int64_t original_size)
+{
+    if (size > INT32_MAX || ((flags & STEGO_FLAG_LZ) && original_size > INT32_MAX))
+        return STEGO_FLAG_SIZE64;
+    return 0;
+}
+
+/* Zeroed (or missing) options are the classic format */
+static Status check_options(const StegoOptions *opts, int *depth, unsigned *flags, int *ecc)
+{
+    *depth = (opts && opts->depth) ? opts->depth : 1;
+    *flags = opts ? opts->flags & ~STEGO_FLAG_SIZE64 : 0;     // picked by stego_plan
+    *ecc = !(*flags & STEGO_FLAG_RS) ? 0 : opts->ecc ? opts->ecc : STEGO_ECC_DEFAULT;
+    if (*depth < 1 || *depth > LSB_MAX_DEPTH || (*flags & ~STEGO_FLAGS_KNOWN)) return e_failure;
+    if ((*flags & STEGO_FLAG_RS) && (*ecc < STEGO_ECC_MIN || *ecc > STEGO_ECC_MAX)) return e_failure;
+    return e_success;
+}
+
+Status stego_capacity(const PixelView *view, int extn_len, const StegoOptions *opts,
+                      int64_t *capacity)
+{
+    int depth, ecc;
+    unsigned flags;
+
+    if (check_options(opts, &depth, &flags, &ecc) != e_success) return e_failure;
+
+    /* room for the 32-bit header first; past 2 GB the 64-bit fields cost a few carriers more */
+    int64_t carriers = view_carriers(view) - trailer_carriers(flags);
+    int64_t cap = data_capacity(carriers - 8 * field_bytes(extn_len, flags), depth, flags, ecc);
+    if (cap > INT32_MAX || ((flags & STEGO_FLAG_LZ) && opts->original_size > INT32_MAX))
+        cap = data_capacity(carriers - 8 * field_bytes(extn_len, flags | STEGO_FLAG_SIZE64), depth, flags, ecc);
+    *capacity = cap;
+    return e_success;
+}
+
+/* ===================== LAYOUT FOR A NEW SECRET ===================== */
+/* Carrier of the CRC32C: after the data, or the last ones of the image when scattered */
+static int64_t crc_carrier(const StegoInfo *info)
+{
+    if (info->flags & STEGO_FLAG_SCATTER) return view_carriers(&info->view) - trailer_carriers(info->flags);
+    return info->data_carrier + LSB_CARRIERS(info->depth) * data_stored(info->size, info->ecc);
+}
+
+static void set_layout(const PixelView *view, int64_t fields, StegoInfo *info)
+{
+    info->view = *view;
+    info->data_carrier = 8 * fields;                       // header fields are always depth 1
+    info->header_offset = view->offset;
+    info->data_offset = stego_carrier_offset(view, info->data_carrier);
+    if (info->flags & STEGO_FLAG_SCATTER)
+        info->scatter_slots = (crc_carrier(info) - info->data_carrier) / slot_carriers(info->depth, info->ecc);
+    info->crc_offset = stego_carrier_offset(view, crc_carrier(info));
+    info->end_offset = stego_carrier_offset(view, crc_carrier(info) + trailer_carriers(info->flags));
+}
+
+Status stego_plan(const PixelView *view, const char *extn, int64_t secret_len,
+                  const StegoOptions *opts, StegoInfo *info)
+{
+    size_t extn_len = strlen(extn);
+    int64_t capacity;
+    int depth, ecc;
+    unsigned flags;
+
+    if (extn_len > MAX_FILE_SUFFIX || secret_len < 0) return e_failure;
+    if (check_options(opts, &depth, &flags, &ecc) != e_success) return e_failure;
+    if ((flags & STEGO_FLAG_LZ) && opts->original_size < 0) return e_failure;
+    if ((flags & STEGO_FLAG_CHACHA) && (!opts->passphrase || secret_len > CIPHER_MAX_BYTES - 4))
+        return e_failure;                                  // the CRC is encrypted after the data
+    stego_capacity(view, (int)extn_len, opts, &capacity);
+    if (secret_len > capacity) return e_no_capacity;
+    flags |= size_flag(secret_len, flags, (flags & STEGO_FLAG_LZ) ? opts->original_size : 0);
+
+    memset(info, 0, sizeof(*info));
+    memcpy(info->extn, extn, extn_len);
+    info->extn_len = (int)extn_len;
+    info->depth = depth;
+    info->flags = flags;
+    info->size = secret_len;
+    info->original_size = (flags & STEGO_FLAG_LZ) ? opts->original_size : secret_len;
+    info->ecc = ecc;
+    set_layout(view, field_bytes(extn_len, flags), info);
+
+    if (flags & STEGO_FLAG_CHACHA)
+    {
+        if (cipher_random(info->salt, sizeof(info->salt)) != e_success ||
+            cipher_random(info->nonce, sizeof(info->nonce)) != e_success)
+            return e_failure;
+        cipher_derive_key(opts->passphrase, info->salt, info->key);
+        info->key_check = cipher_key_check(info->key);
+    }
+    if ((flags & STEGO_FLAG_SCATTER) &&
+        cipher_random((unsigned char *)&info->scatter_seed, sizeof(info->scatter_seed)) != e_success)
+        return e_failure;
+    return e_success;
+}
+
+/* ===================== HEADER FIELDS ===================== */
+void stego_embed_header(const StegoInfo *info, const unsigned char *cover,
+                        unsigned char *out)
+{
+    unsigned char fields[STEGO_FIELDS_MAX];
+    size_t len = strlen(MAGIC_STRING);
+
+    memcpy(fields, MAGIC_STRING, len);
+    unsigned flags = info->flags | ((info->flags & STEGO_FLAG_RS) ? RS_FLAG_COPY : 0);
+    put_le32(fields + len, (uint32_t)info->extn_len | (uint32_t)(info->depth - 1) << 8 |
+                           (uint32_t)flags << 16);
+    len += 4;
+    memcpy(fields + len, info->extn, info->extn_len);
+    len += info->extn_len;
+    if (info->flags & STEGO_FLAG_SIZE64)
+    {
+        put_le64(fields + len, (uint64_t)info->size);
+        len += 8;
+        if (info->flags & STEGO_FLAG_LZ)
+        {
+            put_le64(fields + len, (uint64_t)info->original_size);
+            len += 8;
+        }
+    }
+    else
+    {
+        put_le32(fields + len, (uint32_t)info->size);
+        len += 4;
+        if (info->flags & STEGO_FLAG_LZ)
+        {
+            put_le32(fields + len, (uint32_t)info->original_size);
+            len += 4;
+        }
+    }
+    if (info->flags & STEGO_FLAG_CHACHA)
+    {
+        memcpy(fields + len, info->salt, CIPHER_SALT_SIZE);
+        memcpy(fields + len + CIPHER_SALT_SIZE, info->nonce, CIPHER_NONCE_SIZE);
+        put_le32(fields + len + CIPHER_SALT_SIZE + CIPHER_NONCE_SIZE, info->key_check);
+        len += CIPHER_SALT_SIZE + CIPHER_NONCE_SIZE + 4;
+    }
+    if (info->flags & STEGO_FLAG_SCATTER)
+    {
+        put_le64(fields + len, info->scatter_seed);
+        len += 8;
+    }
+    if (info->flags & STEGO_FLAG_RS)
+    {
+        fields[len++] = (unsigned char)info->ecc;
+        rs_encode(fields, len, STEGO_RS_HEADER_PARITY, fields + len);
+        len += STEGO_RS_HEADER_PARITY;
+    }
+
+    if (out != cover) memcpy(out, cover, info->data_offset - info->header_offset);
+    embed_carriers(&info->view, 0, fields, len, 1, cover, out, info->header_offset);
+}
+
+/* Magic, extension length, depth and flags from the first field bytes */
+static Status parse_extn_field(const unsigned char *fields, uint32_t *extn_len, int *depth, unsigned *flags)
+{
+    size_t magic_len = strlen(MAGIC_STRING);
+
+    if (memcmp(fields, MAGIC_STRING, magic_len) != 0) return e_no_secret;
+
+    /* bytes: extension length, depth - 1, flags, 0 (older images hold just the length) */
+    uint32_t extn_field = get_le32(fields + magic_len);
+    *extn_len = extn_field & 0xFF;
+    *depth = (int)((extn_field >> 8) & 0xFF) + 1;
+    *flags = extn_field >> 16;
+
+    /* STEGO_FLAG_RS is stored twice, so one flipped bit cannot hide the parity */
+    if (!(*flags & STEGO_FLAG_RS) != !(*flags & RS_FLAG_COPY)) return e_bad_header;
+    *flags &= ~RS_FLAG_COPY;
+    if (*extn_len > MAX_FILE_SUFFIX || *depth > LSB_MAX_DEPTH || (*flags & ~STEGO_FLAGS_KNOWN))
+        return e_bad_header;
+    return e_success;
+}
+
+/* The layout from all count header field bytes */
+static Status parse_fields(const PixelView *view, const unsigned char *fields, int64_t count, StegoInfo *info)
+{
+    size_t magic_len = strlen(MAGIC_STRING);
+    uint32_t extn_len;
+    int depth, ecc = 0;
+    unsigned flags;
+
+    Status ret = parse_extn_field(fields, &extn_len, &depth, &flags);
+    if (ret != e_success) return ret;
+    if (field_bytes(extn_len, flags) != count) return e_bad_header;
+    if (flags & STEGO_FLAG_RS)
+    {
+        ecc = fields[count - STEGO_RS_HEADER_PARITY - 1];
+        if (ecc < 1 || ecc > STEGO_ECC_MAX) return e_bad_header;
+    }
+
+    /* sizes straight from the image: compare by division so nothing can overflow */
+    const unsigned char *size_field = fields + magic_len + 4 + extn_len;
+    int wide = (flags & STEGO_FLAG_SIZE64) != 0;
+    int64_t size = wide ? (int64_t)get_le64(size_field) : (int32_t)get_le32(size_field);
+    int64_t room = view_carriers(view) - 8 * count - trailer_carriers(flags);
+    if (size < 0 || room < 0 || size > data_capacity(room, depth, flags, ecc)) return e_bad_header;
+
+    /* the extension ends up in an output file name: no directories, no early end */
+    const unsigned char *extn = fields + magic_len + 4;
+    if (memchr(extn, '/', extn_len) || memchr(extn, '\0', extn_len)) return e_bad_header;
+
+    memset(info, 0, sizeof(*info));
+    memcpy(info->extn, extn, extn_len);
+    info->extn_len = (int)extn_len;
+    info->depth = depth;
+    info->flags = flags;
+    info->size = size;
+    info->original_size = size;
+    info->ecc = ecc;
+    if (flags & STEGO_FLAG_LZ)
+    {
+        int64_t original = wide ? (int64_t)get_le64(size_field + 8) : (int32_t)get_le32(size_field + 4);
+        if (original < 0) return e_bad_header;
+        info->original_size = original;
+    }
+    const unsigned char *key_fields = size_field + (wide ? 8 : 4) * ((flags & STEGO_FLAG_LZ) ? 2 : 1);
+    if (flags & STEGO_FLAG_CHACHA)
+    {
+        memcpy(info->salt, key_fields, CIPHER_SALT_SIZE);
+        memcpy(info->nonce, key_fields + CIPHER_SALT_SIZE, CIPHER_NONCE_SIZE);
+        info->key_check = get_le32(key_fields + CIPHER_SALT_SIZE + CIPHER_NONCE_SIZE);
+        key_fields += CIPHER_SALT_SIZE + CIPHER_NONCE_SIZE + 4;
+    }
+    if (flags & STEGO_FLAG_SCATTER) info->scatter_seed = get_le64(key_fields);
+    set_layout(view, count, info);
+    return e_success;
+}
+
+/* A Reed-Solomon header hit in the magic or in the fields that give its
+   length: try every length a header can have until one repairs into a
+   header of exactly that length */
+static Status recover_header(const PixelView *view, const unsigned char *region, size_t region_len,
+                             StegoInfo *info, size_t *need)
+{
+    unsigned char fields[STEGO_FIELDS_MAX], trial[STEGO_FIELDS_MAX];
+    int64_t most = STEGO_FIELDS_MAX;
+
+    if (8 * most > view_carriers(view)) most = view_carriers(view) / 8;
+    *need = stego_carrier_offset(view, 8 * most) - view->offset;
+    if (region_len < *need) return e_short_buffer;
+
+    extract_carriers(view, 0, fields, most, 1, region, view->offset);
+    for (int64_t count = field_bytes(0, STEGO_FLAG_RS); count <= most; count++)
+    {
+        int64_t data = count - STEGO_RS_HEADER_PARITY;
+        memcpy(trial, fields, count);
+        if (rs_decode(trial, data, STEGO_RS_HEADER_PARITY, trial + data) >= 0 &&
+            parse_fields(view, trial, count, info) == e_success && (info->flags & STEGO_FLAG_RS))
+            return e_success;
+    }
+    return e_bad_header;
+}
+
+Status stego_read_header(const PixelView *view, const unsigned char *region,
+                         size_t region_len, StegoInfo *info, size_t *need)
+{
+    unsigned char fields[STEGO_FIELDS_MAX];
+    size_t magic_len = strlen(MAGIC_STRING);
+    int64_t count = magic_len + 4;                         // magic + extn length first
+    uint32_t extn_len;
+    int depth;
+    unsigned flags;
+
+    if (8 * count > view_carriers(view)) return e_no_secret;
+    *need = stego_carrier_offset(view, 8 * count) - view->offset;
+    if (region_len < *need) return e_short_buffer;
+
+    extract_carriers(view, 0, fields, count, 1, region, view->offset);
+    Status ret = parse_extn_field(fields, &extn_len, &depth, &flags);
+    if (ret == e_success)
+    {
+        count = field_bytes(extn_len, flags);
+        if (8 * count > view_carriers(view)) ret = e_bad_header;
+    }
+    if (ret == e_success)
+    {
+        *need = stego_carrier_offset(view, 8 * count) - view->offset;
+        if (region_len < *need) return e_short_buffer;
+
+        extract_carriers(view, 0, fields, count, 1, region, view->offset);
+        int64_t data = count - STEGO_RS_HEADER_PARITY;
+        if ((flags & STEGO_FLAG_RS) && rs_decode(fields, data, STEGO_RS_HEADER_PARITY, fields + data) < 0)
+            ret = e_bad_header;
+        else
+            ret = parse_fields(view, fields, count, info);
+    }
+
+    /* only a magic at most one byte off can be a damaged Reed-Solomon header */
+    if (ret == e_success || (fields[0] != MAGIC_STRING[0] && fields[1] != MAGIC_STRING[1])) return ret;
+    Status found = recover_header(view, region, region_len, info, need);
+    return (found == e_bad_header) ? ret : found;
+}
+
+Status stego_unlock(StegoInfo *info, const char *passphrase)
+{
+    if (!(info->flags & STEGO_FLAG_CHACHA)) return e_success;
+    if (!passphrase) return e_bad_key;
+
+    cipher_derive_key(passphrase, info->salt, info->key);
+    if (cipher_key_check(info->key) != info->key_check)
+    {
+        memset(info->key, 0, sizeof(info->key));
+        return e_bad_key;
+    }
+    return e_success;
+}
+
+/* ===================== SCATTER PERMUTATION ===================== */
+static uint64_t mix64(uint64_t x)
+{
+    x ^= x >> 30;                              // splitmix64 finalizer
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+#define SCATTER_ROUNDS 4
+
+/* Slot of data block b: a balanced Feistel network on the smallest even
+   bit width holding every slot, walked again while it lands past the last
+   slot. That keeps it a permutation of [0, slots) at a few hashes per
+   block. The key of an encrypted image goes into the round keys, so
+   without the passphrase the positions are unknown too. */
+static int64_t scatter_slot(const StegoInfo *info, int64_t b)
+{
+    uint64_t keys[SCATTER_ROUNDS];
+    int half = 1;
+
+    while (half < 31 && ((uint64_t)1 << (2 * half)) < (uint64_t)info->scatter_slots) half++;
+    for (int r = 0; r < SCATTER_ROUNDS; r++)
+    {
+        keys[r] = mix64(info->scatter_seed + 0x9E3779B97F4A7C15ULL * (r + 1));
+        if (info->flags & STEGO_FLAG_CHACHA) keys[r] ^= get_le64(info->key + 8 * r);
+    }
+
+    uint64_t mask = ((uint64_t)1 << half) - 1, x = (uint64_t)b;
+    do
+    {
+        uint64_t left = x >> half, right = x & mask;
+        for (int r = 0; r < SCATTER_ROUNDS; r++)
+        {
+            uint64_t next = left ^ (mix64(right ^ keys[r]) & mask);
+            left = right;
+            right = next;
+        }
+        x = left << half | right;
+    } while (x >= (uint64_t)info->scatter_slots);
+    return (int64_t)x;
+}
+
+/* ===================== SECRET DATA ===================== */
+/* Carrier of secret byte k; with Reed-Solomon parity, of the block holding it */
+static int64_t data_carrier_of(const StegoInfo *info, int64_t k)
+{
+    int64_t block = k / LSB_BLOCK_SIZE, c = info->data_carrier;
+
+    if (!(info->flags & (STEGO_FLAG_SCATTER | STEGO_FLAG_RS)))
+        return c + LSB_CARRIERS(info->depth) * k;
+    if (info->flags & STEGO_FLAG_SCATTER)
+        c += slot_carriers(info->depth, info->ecc) * scatter_slot(info, block);
+    else
+        c += LSB_CARRIERS(info->depth) * block_stored(info->ecc) * block;
+    return (info->flags & STEGO_FLAG_RS) ? c : c + LSB_CARRIERS(info->depth) * (k % LSB_BLOCK_SIZE);
+}
+
+/* Data bytes in the block holding secret byte k */
+static size_t block_len(const StegoInfo *info, int64_t k)
+{
+    int64_t first = k - k % LSB_BLOCK_SIZE;
+    return (info->size - first > LSB_BLOCK_SIZE) ? LSB_BLOCK_SIZE : (size_t)(info->size - first);
+}
+
+int64_t stego_data_pos(const StegoInfo *info, int64_t k)
+{
+    return stego_carrier_offset(&info->view, data_carrier_of(info, k));
+}
+
+size_t stego_data_span(const StegoInfo *info, int64_t k, size_t n)
+{
+    int64_t c = data_carrier_of(info, k);
+    int64_t stored = (info->flags & STEGO_FLAG_RS) ? data_stored(block_len(info, k), info->ecc) : (int64_t)n;
+    return stego_carrier_offset(&info->view, c + LSB_CARRIERS(info->depth) * stored)
+           - stego_carrier_offset(&info->view, c);
+}
+
+size_t stego_data_run(const StegoInfo *info, int64_t k, size_t n)
+{
+    size_t left = LSB_BLOCK_SIZE - k % LSB_BLOCK_SIZE;
+    return ((info->flags & (STEGO_FLAG_SCATTER | STEGO_FLAG_RS)) && n > left) ? left : n;
+}
+
+void stego_embed_data(const StegoInfo *info, int64_t k, const unsigned char *secret,
+                      size_t n, const unsigned char *cover, unsigned char *out)
+{
+    int64_t win_off = stego_data_pos(info, k);
+    int64_t c = data_carrier_of(info, k);
+
+    if (out != cover && !view_contiguous(&info->view))
+        memcpy(out, cover, stego_data_span(info, k, n));  // padding / alpha pass through
+    if (info->flags & STEGO_FLAG_RS)
+    {
+        /* the block (encrypted first) and its parity go in as one stored run */
+        unsigned char block[LSB_BLOCK_SIZE + RS_LANES * STEGO_ECC_MAX];
+        if (info->flags & STEGO_FLAG_CHACHA)
+            cipher_xor(info->key, info->nonce, k, secret, block, n);
+        else
+            memcpy(block, secret, n);
+        rs_encode_block(block, n, info->ecc, block + n);
+        embed_carriers(&info->view, c, block, data_stored(n, info->ecc), info->depth, cover, out, win_off);
+        return;
+    }
+    if (!(info->flags & STEGO_FLAG_CHACHA))
+    {
+        embed_carriers(&info->view, c, secret, n, info->depth, cover, out, win_off);
+        return;
+    }
+
+    /* encrypt a block into L1, then embed it before it leaves */
+    unsigned char block[LSB_BLOCK_SIZE];
+    while (n > 0)
+    {
+        size_t m = (n > LSB_BLOCK_SIZE) ? LSB_BLOCK_SIZE : n;
+        cipher_xor(info->key, info->nonce, k, secret, block, m);
+        embed_carriers(&info->view, c, block, m, info->depth, cover, out, win_off);
+        c += LSB_CARRIERS(info->depth) * m;
+        k += m;
+        secret += m;
+        n -= m;
+    }
+}
+
+Status stego_extract_data(const StegoInfo *info, int64_t k, const unsigned char *cover,
+                          size_t n, unsigned char *secret)
+{
+    int64_t win_off = stego_data_pos(info, k);
+    int64_t c = data_carrier_of(info, k);
+
+    if (info->flags & STEGO_FLAG_RS)
+    {
+        /* the whole block is read and repaired (a clean one only costs a re-encode) */
+        unsigned char block[LSB_BLOCK_SIZE + RS_LANES * STEGO_ECC_MAX];
+        size_t len = block_len(info, k), at = k % LSB_BLOCK_SIZE;
+        extract_carriers(&info->view, c, block, data_stored(len, info->ecc), info->depth, cover, win_off);
+        if (rs_decode_block(block, len, info->ecc, block + len) < 0)
+            return e_bad_crc;                                    // beyond repair, with or without a CRC32C
+        if (info->flags & STEGO_FLAG_CHACHA)
+            cipher_xor(info->key, info->nonce, k, block + at, secret, n);
+        else
+            memcpy(secret, block + at, n);
+        return e_success;
+    }
+    if (!(info->flags & STEGO_FLAG_CHACHA))
+    {
+        extract_carriers(&info->view, c, secret, n, info->depth, cover, win_off);
+        return e_success;
+    }
+
+    while (n > 0)
+    {
+        size_t m = (n > LSB_BLOCK_SIZE) ? LSB_BLOCK_SIZE : n;
+        extract_carriers(&info->view, c, secret, m, info->depth, cover, win_off);
+        cipher_xor(info->key, info->nonce, k, secret, secret, m);   // still in L1
+        c += LSB_CARRIERS(info->depth) * m;
+        k += m;
+        secret += m;
+        n -= m;
+    }
+    return e_success;
+}
+
+/* ===================== CRC32C AFTER THE DATA ===================== */
+void stego_embed_crc(const StegoInfo *info, uint32_t crc, const unsigned char *cover,
+                     unsigned char *out)
+{
+    unsigned char field[4 + STEGO_RS_HEADER_PARITY];
+    size_t len = 4;
+
+    put_le32(field, crc);
+    if (info->flags & STEGO_FLAG_CHACHA)
+        cipher_xor(info->key, info->nonce, info->size, field, field, 4);   // keystream after the data
+    if (info->flags & STEGO_FLAG_RS)
+    {
+        rs_encode(field, 4, STEGO_RS_HEADER_PARITY, field + 4);
+        len += STEGO_RS_HEADER_PARITY;
+    }
+    if (out != cover && !view_contiguous(&info->view))
+        memcpy(out, cover, info->end_offset - info->crc_offset);
+    embed_carriers(&info->view, crc_carrier(info), field, len, 1, cover, out, info->crc_offset);
+}
+
+uint32_t stego_extract_crc(const StegoInfo *info, const unsigned char *cover)
+{
+    unsigned char field[4 + STEGO_RS_HEADER_PARITY];
+
+    if (info->flags & STEGO_FLAG_RS)
+    {
+        extract_carriers(&info->view, crc_carrier(info), field, sizeof(field), 1, cover, info->crc_offset);
+        rs_decode(field, 4, STEGO_RS_HEADER_PARITY, field + 4);
+    }
+    else
+        extract_carriers(&info->view, crc_carrier(info), field, 4, 1, cover, info->crc_offset);
+    if (info->flags & STEGO_FLAG_CHACHA)
+        cipher_xor(info->key, info->nonce, info->size, field, field, 4);
+    return get_le32(field);
+}
+
+/* ===================== WHOLE-BUFFER ENCODE / DECODE ===================== */
+Status stego_probe(const unsigned char *image, size_t image_len, StegoInfo *info)
+{
+    PixelView view;
+    size_t need;
+
+    Status ret = stego_parse_bmp(image, image_len, image_len, &view, &need);
+    if (ret != e_success) return ret;
+
+    ret = stego_read_header(&view, image + view.offset, image_len - view.offset, info, &need);
+    if (ret == e_short_buffer) return e_bad_image;           // image ends inside the header
+    return ret;
+}
+
+Status stego_encode(const unsigned char *image, unsigned char *out, size_t image_len,
+                    const unsigned char *secret, int64_t secret_len, const char *extn,
+                    const StegoOptions *opts)
+{
+    PixelView view;
+    StegoInfo info;
+    StegoOptions plan = { 0 };
+    unsigned char *packed = NULL;
+    size_t need;
+
+    if (image_len == STEGO_LEN_UNKNOWN || secret_len < 0) return e_failure;
+    if (opts) plan = *opts;
+
+    /* pack first: the header records the packed size; keep the raw data if it does not shrink */
+    if (plan.flags & STEGO_FLAG_LZ)
+    {
+        size_t packed_len = 0;
+        packed = malloc(LZ_COMPRESS_BOUND((size_t)secret_len));
+        if (packed) packed_len = lz_compress(secret, secret_len, packed, secret_len);
+        if (packed_len > 0 && packed_len < (size_t)secret_len)
+        {
+            plan.original_size = secret_len;
+            secret = packed;
+            secret_len = packed_len;
+        }
+        else
+        {
+            plan.flags &= ~STEGO_FLAG_LZ;
+        }
+    }
+
+    Status ret = stego_parse_bmp(image, image_len, image_len, &view, &need);
+    if (ret == e_success) ret = stego_plan(&view, extn, secret_len, &plan, &info);
+    if (ret == e_success)
+    {
+        if (out != image) memcpy(out, image, image_len);
+        stego_embed_header(&info, out + info.header_offset, out + info.header_offset);
+        if (info.flags & (STEGO_FLAG_CRC | STEGO_FLAG_SCATTER | STEGO_FLAG_RS))
+        {
+            /* one block at a time: its own window, checksummed while still in cache */
+            uint32_t crc = 0;
+            for (int64_t k = 0; k < secret_len; k += LSB_BLOCK_SIZE)
+            {
+                size_t n = (secret_len - k > LSB_BLOCK_SIZE) ? LSB_BLOCK_SIZE : (size_t)(secret_len - k);
+                int64_t at = stego_data_pos(&info, k);
+                stego_embed_data(&info, k, secret + k, n, out + at, out + at);
+                crc = crc32c(crc, secret + k, n);
+            }
+            if (info.flags & STEGO_FLAG_CRC)
+                stego_embed_crc(&info, crc, out + info.crc_offset, out + info.crc_offset);
+        }
+        else
+        {
+            stego_embed_data(&info, 0, secret, secret_len, out + info.data_offset,
+                             out + info.data_offset);
+        }
+    }
+    free(packed);
+    return ret;
+}
+
+/* LZ sink writing into the caller's buffer */
+typedef struct
+{
+    unsigned char *out;
+    size_t cap;
+    size_t len;
+} BufferSink;
+
+static Status buffer_sink(void *ctx, const unsigned char *data, size_t n)
+{
+    BufferSink *b = ctx;
+    if (n > b->cap - b->len) return e_bad_data;
+    memcpy(b->out + b->len, data, n);
+    b->len += n;
+    return e_success;
+}
+
+/* Extract packed data a block at a time straight into the decompressor */
+static Status unpack_data(const StegoInfo *info, const unsigned char *image,
+                          unsigned char *out, size_t out_cap)
+{
+    unsigned char block[LSB_BLOCK_SIZE];
+    BufferSink sink = { out, out_cap, 0 };
+    LzDecoder lz;
+
+    if (lz_decoder_init(&lz, info->original_size, buffer_sink, &sink) != e_success)
+        return e_failure;
+
+    Status ret = e_success;
+    uint32_t crc = 0;
+    int check = info->flags & STEGO_FLAG_CRC;
+    for (int64_t k = 0; k < info->size && (ret == e_success || check); k += LSB_BLOCK_SIZE)
+    {
+        size_t n = (info->size - k > LSB_BLOCK_SIZE) ? LSB_BLOCK_SIZE : (size_t)(info->size - k);
+        if (stego_extract_data(info, k, image + stego_data_pos(info, k), n, block) != e_success)
+        {
+            ret = e_bad_crc;
+            break;
+        }
+        if (check) crc = crc32c(crc, block, n);
+        if (ret == e_success) ret = lz_decode(&lz, block, n);
+    }
+    /* corrupt data fails the checksum first, whatever the unpacker made of it */
+    if (ret != e_bad_crc && check && stego_extract_crc(info, image + info->crc_offset) != crc)
+        ret = e_bad_crc;
+    if (ret == e_success) ret = lz_decoder_finish(&lz);
+    if (ret == e_success && sink.len != (size_t)info->original_size) ret = e_bad_data;
+    lz_decoder_free(&lz);
+    return ret;
+}
+
+Status stego_decode(const unsigned char *image, size_t image_len,
+                    unsigned char *out, size_t out_cap, const char *passphrase,
+                    StegoInfo *info)
+{
+    Status ret = stego_probe(image, image_len, info);
+    if (ret == e_success) ret = stego_unlock(info, passphrase);
+    if (ret != e_success) return ret;
+    if ((size_t)info->original_size > out_cap) return e_short_buffer;
+
+    if (info->flags & STEGO_FLAG_LZ) return unpack_data(info, image, out, out_cap);
+
+    if (!(info->flags & (STEGO_FLAG_CRC | STEGO_FLAG_SCATTER | STEGO_FLAG_RS)))
+        return stego_extract_data(info, 0, image + info->data_offset, info->size, out);
+
+    uint32_t crc = 0;
+    for (int64_t k = 0; k < info->size; k += LSB_BLOCK_SIZE)
+    {
+        size_t n = (info->size - k > LSB_BLOCK_SIZE) ? LSB_BLOCK_SIZE : (size_t)(info->size - k);
+        if (stego_extract_data(info, k, image + stego_data_pos(info, k), n, out + k) != e_success)
+            return e_bad_crc;
+        crc = crc32c(crc, out + k, n);                     // while the block is still in cache
+    }
+    if (!(info->flags & STEGO_FLAG_CRC)) return e_success;
+    return stego_extract_crc(info, image + info->crc_offset) == crc ? e_success : e_bad_crc;
+}
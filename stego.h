@@ -0,0 +1,256 @@
+#ifndef STEGO_H
+#define STEGO_H
+
+#include <stddef.h>   // size_t
+#include <stdint.h>   // int64_t: images and secrets may pass 4 GB
+#include "types.h"    // Status
+
+/*----------------------------------------------------------
+    libstego - the LSB engine without any file handling
+
+    Works only on memory the caller owns, keeps no global state
+    and prints nothing, so it can be called from many threads at
+    once. Every "image" argument is the BMP file as it sits on
+    disk (starting with the "BM" header).
+
+    Payload bits go into "carrier" bytes: the B, G and R bytes of
+    every pixel, rows in the order they are stored. Row padding,
+    alpha bytes and anything between the headers and the pixel
+    array are never touched. Hidden layout:
+        magic | extn length | extn | size | [original size]    1 bit per carrier
+        [salt | nonce | key check]                             1 bit per carrier
+        [scatter seed]                                         1 bit per carrier
+        [ecc | header parity]                                  1 bit per carrier
+        data                                                   depth bits per carrier
+        [CRC32C of the data | [parity]]                        1 bit per carrier
+    The bytes above the extension length hold depth - 1 and the
+    STEGO_FLAG_* bits. With STEGO_FLAG_LZ the data is LZ packed
+    (lz.h): size counts packed bytes, original size unpacked ones.
+    Sizes are 32-bit, or 64-bit with STEGO_FLAG_SIZE64 (set only
+    when a size needs it, so small secrets keep the old layout).
+    With STEGO_FLAG_CRC a CRC32C (crc32c.h) of the (packed) data
+    follows it; decoding checks it in the same pass as extraction.
+    With STEGO_FLAG_CHACHA the data and its CRC are encrypted
+    (cipher.h) inside stego_embed_data / stego_extract_data, one
+    cache block at a time, so encryption costs no extra pass.
+    With STEGO_FLAG_CONTAINER the data holds several files with
+    their own chunk checksums (container.h); with STEGO_FLAG_SEGMENT
+    it is one numbered piece of a secret spread over several images
+    (span.h).
+    With STEGO_FLAG_SCATTER the data does not follow the header: the
+    carriers after it are cut into slots of one LSB_BLOCK_SIZE data
+    block each, and block b goes to slot perm(b), a keyed permutation
+    of all the slots (the seed, plus the key of an encrypted image).
+    perm is a small Feistel network evaluated per block, so no table
+    is ever built, and each block is still embedded in one sequential
+    pass. The CRC32C then sits in the last carriers of the image.
+    With STEGO_FLAG_RS every LSB_BLOCK_SIZE data block is stored with
+    RS_LANES * ecc Reed-Solomon parity bytes after it (rs.h), ecc
+    being the parity bytes per codeword kept in the header. The header
+    fields and the CRC32C carry STEGO_RS_HEADER_PARITY parity bytes
+    each. A header whose magic or flags were hit is found again by
+    trying each possible header length. Extraction repairs a block as
+    it reads it; a block beyond repair comes back as stored, and the
+    CRC32C reports it.
+----------------------------------------------------------*/
+
+#define STEGO_BMP_HEADER 54                 // file header + BITMAPINFOHEADER (smallest we accept)
+#define STEGO_BMP_HEADER_MAX (14 + 124)     // file header + BITMAPV5HEADER
+#define MAX_FILE_SUFFIX 4                   // longest extension stored (".txt")
+#define STEGO_LEN_UNKNOWN ((size_t)-1)      // image length not known (e.g. a pipe)
+
+/* Upper bound on the image bytes spanned by n payload bytes: padding and
+   alpha add at most a third on top of the (at most) 8 carriers per byte */
+#define STEGO_SPAN_MAX(n) ((n) * 8 * 4 / 3 + 8)
+#define STEGO_FIELDS_MAX (2 + 4 + MAX_FILE_SUFFIX + 8 + 8 + 32 + 8 + 1 + STEGO_RS_HEADER_PARITY)
+#define STEGO_HEADER_MAX STEGO_SPAN_MAX(STEGO_FIELDS_MAX)
+
+/* Reed-Solomon parity (STEGO_FLAG_RS): per codeword of a data block, and
+   on the header fields and the CRC32C */
+#define STEGO_ECC_DEFAULT 16                // corrects 8 bad bytes in each 128
+#define STEGO_ECC_MIN 2                     // fewer parity bytes correct nothing
+#define STEGO_ECC_MAX 64                    // RS_PARITY_MAX
+#define STEGO_RS_HEADER_PARITY 16
+
+/* Image bytes spanned by one data block, Reed-Solomon parity (RS_LANES
+   codewords) included: the window of stego_embed_data / stego_extract_data */
+#define STEGO_BLOCK_SPAN STEGO_SPAN_MAX(4096 + 32 * STEGO_ECC_MAX)
+
+/* Header flags */
+#define STEGO_FLAG_LZ 0x01                  // data is LZ packed (lz.h)
+#define STEGO_FLAG_SIZE64 0x02              // size fields are 8 bytes (set by stego_plan)
+#define STEGO_FLAG_CRC 0x04                 // CRC32C of the data follows it
+#define STEGO_FLAG_CHACHA 0x08             // data is ChaCha20 encrypted with a passphrase
+#define STEGO_FLAG_CONTAINER 0x10          // data is a multi-file container (container.h)
+#define STEGO_FLAG_SEGMENT 0x20            // data is one segment of a spanned secret (span.h)
+#define STEGO_FLAG_SCATTER 0x40            // data blocks at keyed positions over the whole image
+#define STEGO_FLAG_RS 0x80                 // Reed-Solomon parity on header, data blocks and CRC
+#define STEGO_FLAGS_KNOWN (STEGO_FLAG_LZ | STEGO_FLAG_SIZE64 | STEGO_FLAG_CRC | STEGO_FLAG_CHACHA | \
+                           STEGO_FLAG_CONTAINER | STEGO_FLAG_SEGMENT | STEGO_FLAG_SCATTER | STEGO_FLAG_RS)
+
+/* Image bytes spanned by the CRC32C after the data (at most) */
+#define STEGO_CRC_SPAN STEGO_SPAN_MAX(4 + STEGO_RS_HEADER_PARITY)
+
+/* Where the pixels of a BMP sit and which of their bytes carry data */
+typedef struct _PixelView
+{
+    int64_t offset;                         // bfOffBits: file offset of the first stored row
+    int64_t stride;                         // bytes per stored row, padding included
+    int bytes_per_pixel;                    // 3 (24-bit) or 4 (32-bit BGRA / BGRX)
+    int channels;                           // leading bytes of a pixel that carry data (B, G, R)
+    int64_t width;                          // pixels per row
+    int64_t height;                         // rows in the image
+    int64_t rows;                           // rows actually present in the file
+    int top_down;                           // first stored row is the top one
+    int64_t row_bytes;                      // carrier bytes per row (width * channels)
+} PixelView;
+
+/* Where one hidden secret sits inside an image */
+typedef struct _StegoInfo
+{
+    PixelView view;                         // pixel layout of the image
+    char extn[MAX_FILE_SUFFIX + 1];         // stored extension, may be ""
+    int extn_len;                           // strlen(extn)
+    int depth;                              // data LSBs per carrier (1..LSB_MAX_DEPTH)
+    unsigned flags;                         // STEGO_FLAG_*
+    int64_t size;                           // embedded data size in bytes
+    int64_t original_size;                  // secret size once unpacked (= size unless LZ)
+    int64_t data_carrier;                   // carrier index of secret byte 0 (scatter: of slot 0)
+    int64_t header_offset;                  // image offset of the magic
+    int64_t data_offset;                    // image offset of secret byte 0 (scatter: of slot 0)
+    int64_t crc_offset;                     // image offset of the CRC32C (= end_offset without one)
+    int64_t end_offset;                     // first image offset after the secret
+    unsigned char salt[16];                 // STEGO_FLAG_CHACHA: key derivation salt
+    unsigned char nonce[12];                // STEGO_FLAG_CHACHA: ChaCha20 nonce
+    uint32_t key_check;                     // STEGO_FLAG_CHACHA: cipher_key_check of the key
+    unsigned char key[32];                  // set by stego_plan / stego_unlock
+    uint64_t scatter_seed;                  // STEGO_FLAG_SCATTER: permutation seed
+    int64_t scatter_slots;                  // STEGO_FLAG_SCATTER: slots the blocks are spread over
+    int ecc;                                // STEGO_FLAG_RS: parity bytes per codeword (0 without)
+} StegoInfo;
+
+/* How a new secret is laid out; a zeroed struct (or NULL) is the
+   classic format: depth 1, no flags */
+typedef struct _StegoOptions
+{
+    int depth;                              // data LSBs per carrier, 0 = 1
+    unsigned flags;                         // STEGO_FLAG_*
+    int64_t original_size;                  // unpacked size (stego_plan with STEGO_FLAG_LZ)
+    const char *passphrase;                 // required with STEGO_FLAG_CHACHA
+    int ecc;                                // STEGO_FLAG_RS: parity bytes per codeword (STEGO_ECC_MIN..MAX),
+                                            // 0 = STEGO_ECC_DEFAULT
+} StegoOptions;
+
+/* Human readable text for a Status returned by this library */
+const char *stego_strerror(Status status);
+
+/* Whether a secret may be hidden with extension extn: ".txt", ".c", ".h",
+   ".sh", or "" for a secret without a name (stdin, a passed descriptor).
+   Decoding takes any stored extension without '/' or NUL (e_bad_header). */
+int stego_extn_supported(const char *extn);
+
+/* Parse the BMP headers (24-bit, or 32-bit BI_RGB / BI_BITFIELDS; INFO, V4
+   and V5 headers; bottom-up or top-down). header holds the first header_len
+   bytes of the file; image_len is the whole file size or STEGO_LEN_UNKNOWN.
+   Returns e_short_buffer with *need set if more header bytes are required. */
+Status stego_parse_bmp(const unsigned char *header, size_t header_len, size_t image_len,
+                       PixelView *view, size_t *need);
+
+/* Image offset of a carrier byte (carriers = view->rows * view->row_bytes
+   is one past the last and maps to the end of the pixel array) */
+int64_t stego_carrier_offset(const PixelView *view, int64_t carrier);
+
+/*----------------------------------------------------------
+    Whole-buffer API
+----------------------------------------------------------*/
+
+/* Largest data size (in bytes) the image can hide next to an extension of
+   extn_len characters with these options */
+Status stego_capacity(const PixelView *view, int extn_len, const StegoOptions *opts,
+                      int64_t *capacity);
+
+/* Check for the magic and read extension and size without touching the data */
+Status stego_probe(const unsigned char *image, size_t image_len, StegoInfo *info);
+
+/* Hide secret in image. out receives the whole stego image (image_len
+   bytes) and may be the same buffer as image to encode in place. With
+   STEGO_FLAG_LZ the secret is packed first (and stored raw if that does
+   not make it smaller); opts->original_size is ignored. */
+Status stego_encode(const unsigned char *image, unsigned char *out, size_t image_len,
+                    const unsigned char *secret, int64_t secret_len, const char *extn,
+                    const StegoOptions *opts);
+
+/* Extract the hidden secret into out (out_cap bytes), decrypting it with
+   passphrase (may be NULL if the image is not encrypted), unpacking LZ
+   data and checking the CRC32C if there is one (e_bad_crc on a mismatch,
+   or on data the ECC parity cannot repair).
+   info gets the layout; e_short_buffer means out is smaller than
+   info->original_size, e_bad_data that packed data did not decode. */
+Status stego_decode(const unsigned char *image, size_t image_len,
+                    unsigned char *out, size_t out_cap, const char *passphrase,
+                    StegoInfo *info);
+
+/*----------------------------------------------------------
+    Building blocks for callers that stream or split the work
+----------------------------------------------------------*/
+
+/* Work out where secret_len data bytes go and check they fit. With
+   STEGO_FLAG_LZ the caller packs the data and sets opts->original_size.
+   With STEGO_FLAG_CHACHA a fresh salt and nonce are drawn and the key
+   derived from opts->passphrase (slow on purpose: PBKDF2). */
+Status stego_plan(const PixelView *view, const char *extn, int64_t secret_len,
+                  const StegoOptions *opts, StegoInfo *info);
+
+/* Embed the header fields. cover/out hold the image bytes from
+   info->header_offset to info->data_offset (out may equal cover). */
+void stego_embed_header(const StegoInfo *info, const unsigned char *cover,
+                        unsigned char *out);
+
+/* Parse the header fields from image bytes starting at view->offset.
+   If region_len is too short, returns e_short_buffer with *need set to the
+   number of bytes required; call again once that many are available. */
+Status stego_read_header(const PixelView *view, const unsigned char *region,
+                         size_t region_len, StegoInfo *info, size_t *need);
+
+/* Derive the key of an encrypted image (STEGO_FLAG_CHACHA) after
+   stego_read_header; e_bad_key if the passphrase is missing or wrong.
+   Does nothing for an image that is not encrypted. */
+Status stego_unlock(StegoInfo *info, const char *passphrase);
+
+/* Image offset of secret byte k, and image bytes spanned by secret bytes
+   [k, k+n) (at most STEGO_SPAN_MAX(n)). Spans of consecutive ranges touch,
+   except across a block boundary with STEGO_FLAG_SCATTER. With
+   STEGO_FLAG_RS both describe the whole stored block holding byte k,
+   parity included (at most STEGO_BLOCK_SPAN). */
+int64_t stego_data_pos(const StegoInfo *info, int64_t k);
+size_t stego_data_span(const StegoInfo *info, int64_t k, size_t n);
+
+/* How many of the secret bytes [k, k+n) sit in one image window: n, or
+   with STEGO_FLAG_SCATTER / STEGO_FLAG_RS up to the end of the block
+   holding byte k.
+   Ranges that start on a multiple of LSB_BLOCK_SIZE and are at most that
+   long are always one window. */
+size_t stego_data_run(const StegoInfo *info, int64_t k, size_t n);
+
+/* Embed / extract data bytes [k, k+n) (packed bytes for LZ data; plain
+   text for encrypted data, the cipher is applied here). cover/out hold the
+   image bytes from stego_data_pos(info, k), stego_data_span(info, k, n) long,
+   so n must not pass stego_data_run(info, k, n). Bytes in the span that
+   carry no data are copied from cover to out unchanged. With STEGO_FLAG_RS
+   embedding goes a whole block at a time (k a multiple of LSB_BLOCK_SIZE,
+   n the block or the rest of the data), since the parity covers all of it;
+   extraction may start anywhere, and returns e_bad_crc if the block is
+   damaged beyond what its parity repairs (e_success otherwise). */
+void stego_embed_data(const StegoInfo *info, int64_t k, const unsigned char *secret,
+                      size_t n, const unsigned char *cover, unsigned char *out);
+Status stego_extract_data(const StegoInfo *info, int64_t k, const unsigned char *cover,
+                          size_t n, unsigned char *secret);
+
+/* Embed / read the CRC32C of the stored data (STEGO_FLAG_CRC), encrypted
+   like the data with STEGO_FLAG_CHACHA. cover/out hold the image bytes from
+   crc_offset to end_offset. */
+void stego_embed_crc(const StegoInfo *info, uint32_t crc, const unsigned char *cover,
+                     unsigned char *out);
+uint32_t stego_extract_crc(const StegoInfo *info, const unsigned char *cover);
+
+#endif // STEGO_H
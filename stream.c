@@ -0,0 +1,179 @@
+#define _GNU_SOURCE          // fopencookie, MUST be first line
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include "stream.h"
+
+/* ===================== DOUBLE BUFFERED READER STATE ===================== */
+typedef struct
+{
+    int fd;
+    unsigned char *buf[2];
+    size_t len[2];           // valid bytes in each buffer (0 = end of input)
+    int ready[2];            // filled by the reader, not yet used up
+    int err[2];              // read() failed while filling this buffer
+    int cur;                 // buffer the consumer reads from
+    size_t pos;              // read position inside buf[cur]
+    int stop;                // consumer closed the stream
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+} Prefetch;
+
+/* ===================== BACKGROUND READER ===================== */
+static void *prefetch_thread(void *arg)
+{
+    Prefetch *p = arg;
+    int idx = 0;
+
+    /* only allow cancellation while blocked in read() */
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+
+    for (;;)
+    {
+        pthread_mutex_lock(&p->lock);
+        while (p->ready[idx] && !p->stop)
+            pthread_cond_wait(&p->cond, &p->lock);
+        int stop = p->stop;
+        pthread_mutex_unlock(&p->lock);
+        if (stop) break;
+
+        size_t got = 0;
+        int failed = 0;
+        while (got < STREAM_BUF_SIZE)      // fill the whole buffer unless input ends
+        {
+            pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+            ssize_t n = read(p->fd, p->buf[idx] + got, STREAM_BUF_SIZE - got);
+            pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) failed = 1;
+            if (n <= 0) break;
+            got += n;
+        }
+
+        pthread_mutex_lock(&p->lock);
+        p->len[idx] = got;
+        p->err[idx] = failed;
+        p->ready[idx] = 1;
+        pthread_cond_broadcast(&p->cond);
+        pthread_mutex_unlock(&p->lock);
+
+        if (got == 0) break;               // end of input or error was published
+        idx ^= 1;
+    }
+
+    return NULL;
+}
+
+/* ===================== COOKIE CALLBACKS ===================== */
+static ssize_t prefetch_read(void *cookie, char *dst, size_t size)
+{
+    Prefetch *p = cookie;
+    size_t copied = 0;
+
+    while (copied < size)
+    {
+        pthread_mutex_lock(&p->lock);
+        while (!p->ready[p->cur])
+            pthread_cond_wait(&p->cond, &p->lock);
+        pthread_mutex_unlock(&p->lock);
+
+        if (p->len[p->cur] == 0)           // end marker stays ready for later calls
+        {
+            if (p->err[p->cur] && copied == 0) return -1;
+            break;
+        }
+
+        size_t n = p->len[p->cur] - p->pos;
+        if (n > size - copied) n = size - copied;
+        memcpy(dst + copied, p->buf[p->cur] + p->pos, n);
+        copied += n;
+        p->pos += n;
+
+        if (p->pos == p->len[p->cur])      // hand the buffer back to the reader
+        {
+            pthread_mutex_lock(&p->lock);
+            p->ready[p->cur] = 0;
+            pthread_cond_broadcast(&p->cond);
+            pthread_mutex_unlock(&p->lock);
+            p->cur ^= 1;
+            p->pos = 0;
+        }
+    }
+
+    return copied;
+}
+
+static int prefetch_close(void *cookie)
+{
+    Prefetch *p = cookie;
+
+    pthread_mutex_lock(&p->lock);
+    p->stop = 1;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+
+    pthread_cancel(p->thread);             // in case it is blocked on an idle pipe
+    pthread_join(p->thread, NULL);
+
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->cond);
+    free(p->buf[0]);
+    free(p->buf[1]);
+    free(p);
+    return 0;
+}
+
+/* ===================== PUBLIC: OPEN PREFETCHING STREAM ===================== */
+FILE *stream_open_prefetch(int fd)
+{
+    Prefetch *p = calloc(1, sizeof(*p));
+    if (!p) return NULL;
+
+    p->fd = fd;
+    p->buf[0] = malloc(STREAM_BUF_SIZE);
+    p->buf[1] = malloc(STREAM_BUF_SIZE);
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, NULL);
+
+    if (!p->buf[0] || !p->buf[1] ||
+        pthread_create(&p->thread, NULL, prefetch_thread, p) != 0)
+    {
+        free(p->buf[0]);
+        free(p->buf[1]);
+        free(p);
+        return NULL;
+    }
+
+    cookie_io_functions_t io = { .read = prefetch_read, .close = prefetch_close };
+    FILE *fp = fopencookie(p, "rb", io);
+    if (!fp)
+    {
+        prefetch_close(p);
+        return NULL;
+    }
+    setvbuf(fp, NULL, _IOFBF, 1 << 16);    // unbuffered cookie FILEs are read a byte at a time
+    return fp;
+}
+
+/* ===================== PUBLIC: TAKE OVER STDOUT FOR DATA ===================== */
+FILE *stream_claim_stdout(void)
+{
+    fflush(stdout);
+
+    int fd = dup(STDOUT_FILENO);
+    if (fd < 0) return NULL;
+    if (dup2(STDERR_FILENO, STDOUT_FILENO) < 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    FILE *fp = fdopen(fd, "wb");
+    if (fp) setvbuf(fp, NULL, _IOFBF, STREAM_BUF_SIZE);
+    return fp;
+}
@@ -0,0 +1,21 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdio.h>
+
+/* Size of each of the two prefetch buffers used for pipes */
+#define STREAM_BUF_SIZE (1 << 20)
+
+/* Name used on the command line for stdin / stdout */
+#define STREAM_NAME "-"
+
+/* Wrap a descriptor (usually a pipe) in a read-only FILE. A background
+   thread fills one buffer while the caller consumes the other, so the
+   producer on the other end of the pipe never waits for us to embed. */
+FILE *stream_open_prefetch(int fd);
+
+/* Hand the real stdout to the caller for data and send everything printed
+   with printf from now on to stderr, so banners never mix with output. */
+FILE *stream_claim_stdout(void);
+
+#endif // STREAM_H
@@ -3,10 +3,22 @@
  ************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include "encode.h"
 #include "types.h"
 #include "decode.h"
+#include "batch.h"
+#include "probe.h"
+#include "archive.h"
+#include "span.h"
+#include "coverindex.h"
+#include "daemon.h"
+#include "console.h"
+#include "progress.h"
+#include "lsb.h"        // LSB_MAX_DEPTH
+#include "stats.h"      // StegoStats for --stats
 
 /************************************************************
  * Function: check_operation_type
@@ -21,12 +33,362 @@ OperationType check_operation_type(char *argv[])
     {
         return e_decode;   // User selected decoding mode
     }
+    else if (strcmp(argv[1], "-b") == 0)
+    {
+        return e_batch;    // User selected batch (manifest) mode
+    }
+    else if (strcmp(argv[1], "-p") == 0 || strcmp(argv[1], "--probe") == 0)
+    {
+        return e_probe;    // User selected probe (scan) mode
+    }
+    else if (strcmp(argv[1], "-c") == 0)
+    {
+        return e_container;  // User selected multi-file container mode
+    }
+    else if (strcmp(argv[1], "-i") == 0)
+    {
+        return e_index;    // User selected cover index (re)build
+    }
+    else if (strcmp(argv[1], "-s") == 0)
+    {
+        return e_span;     // User selected spanning over several covers
+    }
+    else if (strcmp(argv[1], "-m") == 0)
+    {
+        return e_merge;    // User selected reassembly of a spanned secret
+    }
+    else if (strcmp(argv[1], "-D") == 0)
+    {
+        return e_daemon;   // User selected serving requests on a socket
+    }
+    else if (strcmp(argv[1], "-C") == 0)
+    {
+        return e_client;   // User selected one request to a running daemon
+    }
     else
     {
         return e_unsupported; // Invalid operation input
     }
 }
 
+/************************************************************
+ * Options given as "--name" anywhere after the operation
+ ************************************************************/
+typedef struct
+{
+    int use_mmap;       // --mmap : map files, kernel copies the image tail
+    int64_t secret_size;   // --size N : bytes to take from a piped secret
+    int threads;        // -j N : worker threads for the secret data
+    int depth;          // --depth N : data LSBs per carrier byte (1..4), 0 = not given (1)
+    int compress;       // --compress : LZ-pack the secret before embedding
+    int crc;            // --crc / --no-crc : 1 / 0 (no CRC32C: images for older versions), -1 = not given (on)
+    int scatter;        // --scatter : data blocks in keyed random slots over the whole image
+    int ecc;            // --ecc N : Reed-Solomon parity bytes per 128 data bytes, 0 = none
+    char passphrase[256];   // --passphrase-file F : first line of F, "" = none
+    int64_t offset;     // --offset N : first secret byte to extract
+    int64_t length;     // --length N : secret bytes to extract, 0 = to the end
+    const char *only_file;  // --file NAME : extract one file of a container
+    int resume;         // --resume : keep container chunks already extracted
+    const char *cover_index;    // --cover-index F : pick the cover from index F
+    int64_t cache_mb;   // --cache-mb N : daemon cover cache budget
+    AioMode aio;        // --aio[=uring|pread] : batched whole-file I/O for -b
+    ProgressMode progress;  // --progress=none|bar|json, --quiet
+    int quiet;          // --quiet : no terminal output at all
+    const char *stats;  // --stats[=FILE] : job timings as JSON, "" = stderr, NULL = off
+} CliOptions;
+
+/************************************************************
+ * Function: read_passphrase
+ * First line of a file (without the newline) into buf
+ ************************************************************/
+static Status read_passphrase(const char *fname, char *buf, size_t cap)
+{
+    FILE *fp = fopen(fname, "r");
+    if (fp == NULL) return e_failure;
+
+    char *line = fgets(buf, cap, fp);
+    fclose(fp);
+    if (line == NULL) return e_failure;
+    buf[strcspn(buf, "\r\n")] = '\0';
+    return buf[0] ? e_success : e_failure;
+}
+
+/************************************************************
+ * Function: split_options
+ * Moves option flags out of argv so the validators still find
+ * the file names at argv[2], argv[3], argv[4]. args must have
+ * room for argc + 3 entries; unused ones are set to NULL.
+ ************************************************************/
+Status split_options(int argc, char *argv[], char *args[], CliOptions *opts)
+{
+    int n = 0;
+
+    memset(opts, 0, sizeof(*opts));
+    opts->progress = e_progress_bar;
+    opts->crc = -1;
+
+    for (int i = 0; i < argc; i++)
+    {
+        if (i >= 2 && strncmp(argv[i], "-j", 2) == 0)
+        {
+            /* accepts "-j N" and "-jN" */
+            const char *val = argv[i][2] ? argv[i] + 2 : (i + 1 < argc) ? argv[++i] : NULL;
+            char *end;
+            opts->threads = val ? (int)strtol(val, &end, 10) : 0;
+            if (!val || *end != '\0' || opts->threads < 1)
+            {
+                printf("\n[ERROR] -j needs a thread count of at least 1\n");
+                return e_failure;
+            }
+        }
+        else if (i < 2 || strncmp(argv[i], "--", 2) != 0)
+        {
+            args[n++] = argv[i];    // program name, operation, file names
+        }
+        else if (strcmp(argv[i], "--mmap") == 0)
+        {
+            opts->use_mmap = 1;
+        }
+        else if (strcmp(argv[i], "--compress") == 0)
+        {
+            opts->compress = 1;
+        }
+        else if (strcmp(argv[i], "--no-crc") == 0)
+        {
+            opts->crc = 0;
+        }
+        else if (strcmp(argv[i], "--crc") == 0)
+        {
+            opts->crc = 1;
+        }
+        else if (strcmp(argv[i], "--scatter") == 0)
+        {
+            opts->scatter = 1;
+        }
+        else if (strcmp(argv[i], "--aio") == 0 || strcmp(argv[i], "--aio=uring") == 0)
+        {
+            opts->aio = e_aio_auto;     // pread / pwrite where io_uring is unavailable
+        }
+        else if (strcmp(argv[i], "--aio=pread") == 0)
+        {
+            opts->aio = e_aio_pread;
+        }
+        else if (strcmp(argv[i], "--resume") == 0)
+        {
+            opts->resume = 1;
+        }
+        else if (strncmp(argv[i], "--file", 6) == 0 && (argv[i][6] == '=' || argv[i][6] == '\0'))
+        {
+            /* accepts "--file NAME" and "--file=NAME" */
+            opts->only_file = (argv[i][6] == '=') ? argv[i] + 7 : (i + 1 < argc) ? argv[++i] : NULL;
+            if (!opts->only_file || !opts->only_file[0])
+            {
+                printf("\n[ERROR] --file needs the name of a file in the container\n");
+                return e_failure;
+            }
+        }
+        else if (strncmp(argv[i], "--cover-index", 13) == 0 && (argv[i][13] == '=' || argv[i][13] == '\0'))
+        {
+            /* accepts "--cover-index F" and "--cover-index=F" */
+            opts->cover_index = (argv[i][13] == '=') ? argv[i] + 14 : (i + 1 < argc) ? argv[++i] : NULL;
+            if (!opts->cover_index || !opts->cover_index[0])
+            {
+                printf("\n[ERROR] --cover-index needs an index file written by -i\n");
+                return e_failure;
+            }
+        }
+        else if (strcmp(argv[i], "--quiet") == 0)
+        {
+            opts->quiet = 1;
+        }
+        else if (strncmp(argv[i], "--stats", 7) == 0 && (argv[i][7] == '=' || argv[i][7] == '\0'))
+        {
+            /* "--stats" prints to stderr, "--stats=FILE" appends to FILE */
+            opts->stats = (argv[i][7] == '=') ? argv[i] + 8 : "";
+            if (!STATS_ENABLED)
+            {
+                printf("\n[ERROR] --stats is not available: built with -DSTEGO_NO_STATS\n");
+                return e_failure;
+            }
+        }
+        else if (strncmp(argv[i], "--progress", 10) == 0)
+        {
+            /* accepts "--progress MODE" and "--progress=MODE" */
+            const char *val = (argv[i][10] == '=') ? argv[i] + 11
+                            : (argv[i][10] == '\0' && i + 1 < argc) ? argv[++i] : NULL;
+            if (!val || progress_parse_mode(val, &opts->progress) != e_success)
+            {
+                printf("\n[ERROR] --progress must be none, bar or json\n");
+                return e_failure;
+            }
+        }
+        else if (strncmp(argv[i], "--depth", 7) == 0)
+        {
+            /* accepts "--depth N" and "--depth=N" */
+            const char *val = (argv[i][7] == '=') ? argv[i] + 8
+                            : (argv[i][7] == '\0' && i + 1 < argc) ? argv[++i] : NULL;
+            char *end;
+            opts->depth = val ? (int)strtol(val, &end, 10) : 0;
+            if (!val || *end != '\0' || opts->depth < 1 || opts->depth > LSB_MAX_DEPTH)
+            {
+                printf("\n[ERROR] --depth must be 1 to %d\n", LSB_MAX_DEPTH);
+                return e_failure;
+            }
+        }
+        else if (strncmp(argv[i], "--ecc", 5) == 0 && (argv[i][5] == '=' || argv[i][5] == '\0'))
+        {
+            /* accepts "--ecc N" and "--ecc=N" */
+            const char *val = (argv[i][5] == '=') ? argv[i] + 6 : (i + 1 < argc) ? argv[++i] : NULL;
+            char *end;
+            opts->ecc = val ? (int)strtol(val, &end, 10) : 0;
+            if (!val || *end != '\0' || opts->ecc < STEGO_ECC_MIN || opts->ecc > STEGO_ECC_MAX)
+            {
+                printf("\n[ERROR] --ecc must be %d to %d parity bytes\n", STEGO_ECC_MIN, STEGO_ECC_MAX);
+                return e_failure;
+            }
+        }
+        else if (strncmp(argv[i], "--passphrase-file", 17) == 0)
+        {
+            /* accepts "--passphrase-file F" and "--passphrase-file=F"; never on the command line itself */
+            const char *val = (argv[i][17] == '=') ? argv[i] + 18
+                            : (argv[i][17] == '\0' && i + 1 < argc) ? argv[++i] : NULL;
+            if (!val || read_passphrase(val, opts->passphrase, sizeof(opts->passphrase)) != e_success)
+            {
+                printf("\n[ERROR] --passphrase-file needs a readable file with a non-empty first line\n");
+                return e_failure;
+            }
+        }
+        else if (strncmp(argv[i], "--offset", 8) == 0 || strncmp(argv[i], "--length", 8) == 0)
+        {
+            /* accepts "--offset N" and "--offset=N", same for --length */
+            int is_offset = argv[i][2] == 'o';
+            const char *val = (argv[i][8] == '=') ? argv[i] + 9
+                            : (argv[i][8] == '\0' && i + 1 < argc) ? argv[++i] : NULL;
+            char *end;
+            int64_t count = val ? strtoll(val, &end, 10) : -1;
+            if (!val || *end != '\0' || count < !is_offset)
+            {
+                printf("\n[ERROR] %s needs a byte count of %d or more\n", is_offset ? "--offset" : "--length",
+                       !is_offset);
+                return e_failure;
+            }
+            if (is_offset) opts->offset = count;
+            else opts->length = count;
+        }
+        else if (strncmp(argv[i], "--cache-mb", 10) == 0)
+        {
+            /* accepts "--cache-mb N" and "--cache-mb=N" */
+            const char *val = (argv[i][10] == '=') ? argv[i] + 11
+                            : (argv[i][10] == '\0' && i + 1 < argc) ? argv[++i] : NULL;
+            char *end;
+            opts->cache_mb = val ? strtoll(val, &end, 10) : 0;
+            if (!val || *end != '\0' || opts->cache_mb < 1)
+            {
+                printf("\n[ERROR] --cache-mb needs a size of at least 1 (MB)\n");
+                return e_failure;
+            }
+        }
+        else if (strncmp(argv[i], "--size", 6) == 0)
+        {
+            /* accepts "--size N" and "--size=N" */
+            const char *val = (argv[i][6] == '=') ? argv[i] + 7
+                            : (argv[i][6] == '\0' && i + 1 < argc) ? argv[++i] : NULL;
+            char *end;
+            opts->secret_size = val ? strtoll(val, &end, 10) : 0;
+            if (!val || *end != '\0' || opts->secret_size <= 0)
+            {
+                printf("\n[ERROR] --size needs a positive byte count\n");
+                return e_failure;
+            }
+        }
+        else
+        {
+            printf("\n[ERROR] Unknown option: %s\n", argv[i]);
+            return e_failure;
+        }
+    }
+
+    if (opts->quiet) opts->progress = e_progress_none;
+    while (n < argc + 3) args[n++] = NULL;   // validators look up to argv[4]
+    return e_success;
+}
+
+/************************************************************
+ * Function: pick_cover
+ * -e with --cover-index: args hold "-e <secret> <output.bmp>";
+ * the smallest indexed cover that fits goes in front of them
+ ************************************************************/
+static Status pick_cover(const CliOptions *cli, char *args[], char *cover, size_t cap)
+{
+    struct stat st;
+    int64_t secret_len = cli->secret_size, capacity;
+
+    if (!args[2] || !args[3])
+    {
+        printf("\n[ERROR] Usage: ./stego -e --cover-index <index> <secret.txt> <output.bmp>\n");
+        return e_failure;
+    }
+    if (strcmp(args[2], "-") && stat(args[2], &st) == 0) secret_len = st.st_size;
+
+    /* a packed secret is never larger than the raw one, so the raw size is safe */
+    const char *dot = strrchr(args[2], '.');
+    StegoOptions opts = { .depth = cli->depth, .flags = cli->crc ? STEGO_FLAG_CRC : 0 };
+    if (cli->passphrase[0]) opts.flags |= STEGO_FLAG_CHACHA;
+    if (cli->scatter) opts.flags |= STEGO_FLAG_SCATTER;
+    if (cli->ecc) opts.flags |= STEGO_FLAG_RS;
+    opts.ecc = cli->ecc;
+    if (cover_index_pick(cli->cover_index, secret_len, dot ? (int)strlen(dot) : 0, &opts,
+                         cover, cap, &capacity) != e_success)
+    {
+        printf("\n[ERROR] No cover in %s can hold %lld bytes\n", cli->cover_index, (long long)secret_len);
+        return e_failure;
+    }
+    cprintf("\n[INFO] Cover picked from %s: %s (room for %lld bytes)\n", cli->cover_index, cover,
+            (long long)capacity);
+
+    args[4] = args[3];
+    args[3] = args[2];
+    args[2] = cover;
+    return e_success;
+}
+
+/************************************************************
+ * Function: daemon_local_option
+ * A request carries only the layout options and the passphrase;
+ * returns the first option given that -D / -C would drop, or NULL
+ ************************************************************/
+static const char *daemon_local_option(const CliOptions *cli, int client)
+{
+    if (cli->use_mmap) return "--mmap";
+    if (cli->offset || cli->length) return "--offset / --length";
+    if (cli->stats) return "--stats";
+    if (cli->aio) return "--aio";
+    if (cli->secret_size) return "--size";
+    if (cli->cover_index) return "--cover-index";
+    if (cli->only_file) return "--file";
+    if (cli->resume) return "--resume";
+    if (client && cli->threads) return "-j";            // the daemon's own -j sets its workers
+    if (client && cli->cache_mb) return "--cache-mb";
+    return NULL;
+}
+
+/************************************************************
+ * Function: print_stats
+ * One JSON line for --stats: stderr, or appended to a file
+ ************************************************************/
+static void print_stats(const CliOptions *cli, const StegoStats *stats)
+{
+    FILE *fp = cli->stats[0] ? fopen(cli->stats, "a") : stderr;
+    if (fp == NULL)
+    {
+        fprintf(stderr, "[ERROR] Cannot open stats file: %s\n", cli->stats);
+        return;
+    }
+    fflush(stdout);      // banners may be on stderr too (stream_claim_stdout): keep the line last
+    stats_print(stats, fp);
+    if (fp != stderr) fclose(fp);
+}
+
 /************************************************************
  * Function: main
  * Program Entry Point
@@ -37,18 +399,73 @@ int main(int argc, char *argv[])
     {
         printf("\n[USER ERROR] Missing or invalid arguments.\n");
         printf("Usage for Encoding: ./stego -e <source.bmp> <secret.txt> <output.bmp>\n");
-        printf("Usage for Decoding: ./stego -d <encoded.bmp> <output_basename>\n\n");
+        printf("Usage for Decoding: ./stego -d <encoded.bmp> <output_basename>\n");
+        printf("Usage for Batch   : ./stego -b <manifest.txt | -> [-j workers] [--aio[=uring|pread]]\n");
+        printf("Usage for Probe   : ./stego -p <image.bmp | dir>... [-j workers]\n");
+        printf("Usage for Archive : ./stego -c <source.bmp> <output.bmp> <file>...\n");
+        printf("Usage for Spanning: ./stego -s <secret> <output_prefix> <cover.bmp>...\n");
+        printf("Usage for Index   : ./stego -i <index> <cover_dir | cover.bmp>... [-j workers]\n");
+        printf("Usage for Merging : ./stego -m <output_basename> <image.bmp>...\n");
+        printf("Usage for Daemon  : ./stego -D <socket> [-j workers] [--cache-mb N]\n");
+        printf("Usage for Client  : ./stego -C <socket> -e|-d|-p <file>...\n");
+        printf("Encoding options  : --mmap  (map files, copy untouched image tail in kernel)\n");
+        printf("                    --size N (secret length when the secret is piped)\n");
+        printf("                    --depth N (1-4 LSBs per colour byte, default 1)\n");
+        printf("                    --compress (LZ-pack the secret, unpacked on decode)\n");
+        printf("                    --no-crc (no CRC32C of the data, readable by older versions)\n");
+        printf("                    --crc (the default; overrides a daemon started with --no-crc)\n");
+        printf("                    --scatter (data blocks spread over the whole image in keyed order)\n");
+        printf("                    --ecc N (Reed-Solomon, N parity bytes per 128 data bytes; %d-%d)\n",
+               STEGO_ECC_MIN, STEGO_ECC_MAX);
+        printf("                    --passphrase-file F (encrypt with ChaCha20; also to decode)\n");
+        printf("                    --cover-index F (no source.bmp: smallest cover in index F that fits)\n");
+        printf("Decoding options  : --offset N --length N (extract only that part of the secret)\n");
+        printf("                    --file NAME (only that file of a container; output is a directory)\n");
+        printf("                    --resume (keep container chunks already extracted and intact)\n");
+        printf("Daemon options    : --cache-mb N (covers kept mapped between requests, default 256)\n");
+        printf("Options           : -j N     (split secret data across N threads)\n");
+        printf("                    --progress=none|bar|json (bar only on a terminal)\n");
+        printf("                    --quiet  (no output at all, check the exit code)\n");
+        printf("                    --stats[=FILE] (-e / -d: phase timings and I/O counts as JSON)\n");
+        printf("Use - as a file name to read from stdin or write to stdout\n\n");
         return 1;   // return error status
     }
 
+    CliOptions cli;
+    char *args[argc + 3];    // argv without the option flags
+    if (split_options(argc, argv, args, &cli) != e_success)
+    {
+        return 1;
+    }
+    argv = args;
+    console_quiet = cli.quiet;    // step banners and errors of this thread
+
     OperationType opt = check_operation_type(argv); // Identify user operation
 
     /* ======================== ENCODING MODE ======================== */
     if (opt == e_encode)
     {
         //printf("\n[INFO] Encoding mode selected.\n");
+        char cover[4096];    // picked from --cover-index
+        if (cli.cover_index && pick_cover(&cli, argv, cover, sizeof(cover)) != e_success)
+        {
+            return 1;
+        }
 
         EncodeInfo encInfo; // Object storing all encode-related data
+        memset(&encInfo, 0, sizeof(encInfo));
+        encInfo.use_mmap = cli.use_mmap;
+        encInfo.secret_size_hint = cli.secret_size;
+        encInfo.threads = cli.threads;
+        encInfo.depth = cli.depth;
+        encInfo.compress = cli.compress;
+        encInfo.crc = cli.crc != 0;
+        encInfo.scatter = cli.scatter;
+        encInfo.ecc = cli.ecc;
+        encInfo.passphrase = cli.passphrase[0] ? cli.passphrase : NULL;
+        encInfo.progress = cli.progress;
+        StegoStats stats;
+        encInfo.stats = cli.stats ? &stats : NULL;
 
        // printf("OPERATION: Validating inputs...\n");
         if (read_and_validate_encode_args(argv, &encInfo) == e_failure)
@@ -60,13 +477,16 @@ int main(int argc, char *argv[])
        // printf("[DONE] Input validation successful.\n");
         //printf("[INFO] Encoding started...\n");
 
-        if (do_encoding(&encInfo) == e_success)
+        Status ret = do_encoding(&encInfo);
+        if (cli.stats) print_stats(&cli, &stats);    // failed jobs too: where did they stop?
+        if (ret == e_success)
         {
             //printf("\n[SUCCESS] Encoding completed & output saved successfully.\n");
         }
         else
         {
             //printf("\n[ERROR] Encoding failed! Check source BMP or available space.\n");
+            return 1;   // the only signal left with --quiet
         }
     }
 
@@ -76,6 +496,16 @@ int main(int argc, char *argv[])
         //printf("\n[INFO] Decoding mode selected.\n");
 
         DecodeInfo decInfo; // Stores decode configuration
+        memset(&decInfo, 0, sizeof(decInfo));
+        decInfo.threads = cli.threads;
+        decInfo.passphrase = cli.passphrase[0] ? cli.passphrase : NULL;
+        decInfo.range_offset = cli.offset;
+        decInfo.range_length = cli.length;
+        decInfo.only_file = cli.only_file;
+        decInfo.resume = cli.resume;
+        decInfo.progress = cli.progress;
+        StegoStats stats;
+        decInfo.stats = cli.stats ? &stats : NULL;
 
         //printf("OPERATION: Validating inputs...\n");
         if (read_and_validate_decode_args(argv, &decInfo) == e_failure)
@@ -88,13 +518,203 @@ int main(int argc, char *argv[])
        // printf("[DONE] Input validation successful.\n");
         //printf("[INFO] Decoding started...\n");
 
-        if (do_decoding(&decInfo) == e_success)
+        Status ret = do_decoding(&decInfo);
+        if (cli.stats) print_stats(&cli, &stats);
+        if (ret == e_success)
         {
             //printf("\n[SUCCESS] Decoding completed & secret file extracted.\n");
         }
         else
         {
             //printf("\n[ERROR] Decoding failed! Check if BMP contains hidden data.\n");
+            return 1;   // the only signal left with --quiet
+        }
+    }
+
+    /* ======================== BATCH MODE ======================== */
+    else if (opt == e_batch)
+    {
+        EncodeInfo enc_defaults;   // global options applied to every row
+        DecodeInfo dec_defaults;
+        memset(&enc_defaults, 0, sizeof(enc_defaults));
+        memset(&dec_defaults, 0, sizeof(dec_defaults));
+        enc_defaults.use_mmap = cli.use_mmap;
+        enc_defaults.depth = cli.depth;
+        enc_defaults.compress = cli.compress;
+        enc_defaults.crc = cli.crc != 0;
+        enc_defaults.scatter = cli.scatter;
+        enc_defaults.ecc = cli.ecc;
+        enc_defaults.passphrase = cli.passphrase[0] ? cli.passphrase : NULL;
+        dec_defaults.passphrase = enc_defaults.passphrase;
+
+        /* -j is the number of concurrent jobs here; each job runs single threaded */
+        if (run_batch(argv[2], cli.threads, cli.aio, &enc_defaults, &dec_defaults) != e_success)
+        {
+            return 1;   // at least one job failed
+        }
+    }
+
+    /* ======================== PROBE MODE ======================== */
+    else if (opt == e_probe)
+    {
+        int count = 0;
+        while (argv[2 + count]) count++;
+        if (count == 0)
+        {
+            printf("\n[ERROR] Probe needs at least one file or directory\n");
+            return 1;
+        }
+
+        /* -j is the number of probing threads; any unreadable file makes the exit code 1 */
+        if (run_probe(argv + 2, count, cli.threads) != e_success)
+        {
+            return 1;
+        }
+    }
+
+    /* ======================== CONTAINER MODE ======================== */
+    else if (opt == e_container)
+    {
+        int count = 0;
+        while (argv[4 + count]) count++;
+        if (count == 0)
+        {
+            printf("\n[ERROR] Usage: ./stego -c <source.bmp> <output.bmp> <file>...\n");
+            return 1;
+        }
+        if (cli.compress || cli.scatter || cli.ecc)
+        {
+            printf("\n[ERROR] %s is not supported for containers\n",
+                   cli.compress ? "--compress" : cli.scatter ? "--scatter" : "--ecc");
+            return 1;
+        }
+
+        EncodeInfo encInfo;
+        memset(&encInfo, 0, sizeof(encInfo));
+        encInfo.src_image_fname = argv[2];
+        encInfo.stego_image_fname = argv[3];
+        encInfo.threads = cli.threads;
+        encInfo.depth = cli.depth;
+        encInfo.passphrase = cli.passphrase[0] ? cli.passphrase : NULL;
+        encInfo.progress = cli.progress;
+
+        /* each chunk carries its own CRC32C, so --no-crc changes nothing here */
+        if (do_container_encoding(&encInfo, argv + 4, count) != e_success)
+        {
+            return 1;
+        }
+    }
+
+    /* ======================== COVER INDEX MODE ======================== */
+    else if (opt == e_index)
+    {
+        int count = 0;
+        while (argv[3 + count]) count++;
+        if (count == 0)
+        {
+            printf("\n[ERROR] Usage: ./stego -i <index> <cover_dir | cover.bmp>...\n");
+            return 1;
+        }
+
+        /* -j is the number of threads reading headers of new or changed covers */
+        if (cover_index_update(argv[2], argv + 3, count, cli.threads) != e_success)
+        {
+            return 1;
+        }
+    }
+
+    /* ======================== SPANNING MODE ======================== */
+    else if (opt == e_span)
+    {
+        int count = 0;
+        while (argv[4 + count]) count++;
+        if (count == 0)
+        {
+            printf("\n[ERROR] Usage: ./stego -s <secret> <output_prefix> <cover.bmp>...\n");
+            return 1;
+        }
+        if (cli.compress || cli.scatter || cli.ecc)
+        {
+            printf("\n[ERROR] %s is not supported for spanned secrets\n",
+                   cli.compress ? "--compress" : cli.scatter ? "--scatter" : "--ecc");
+            return 1;
+        }
+
+        EncodeInfo encInfo;
+        memset(&encInfo, 0, sizeof(encInfo));
+        encInfo.secret_fname = argv[2];
+        encInfo.threads = cli.threads;
+        encInfo.depth = cli.depth;
+        encInfo.crc = cli.crc != 0;
+        encInfo.passphrase = cli.passphrase[0] ? cli.passphrase : NULL;
+        encInfo.progress = cli.progress;
+
+        /* -j is the number of covers embedded at once (default: one per CPU) */
+        if (do_span_encoding(&encInfo, argv[3], argv + 4, count) != e_success)
+        {
+            return 1;
+        }
+    }
+
+    /* ======================== MERGING MODE ======================== */
+    else if (opt == e_merge)
+    {
+        int count = 0;
+        while (argv[3 + count]) count++;
+        if (count == 0)
+        {
+            printf("\n[ERROR] Usage: ./stego -m <output_basename> <image.bmp>...\n");
+            return 1;
+        }
+
+        DecodeInfo decInfo;
+        memset(&decInfo, 0, sizeof(decInfo));
+        decInfo.secret_fname = argv[2];
+        decInfo.threads = cli.threads;
+        decInfo.passphrase = cli.passphrase[0] ? cli.passphrase : NULL;
+        decInfo.progress = cli.progress;
+
+        /* images in any order; -j is the number extracted at once */
+        if (do_span_decoding(&decInfo, argv + 3, count) != e_success)
+        {
+            return 1;
+        }
+    }
+
+    /* ======================== DAEMON MODE ======================== */
+    else if (opt == e_daemon || opt == e_client)
+    {
+        int count = 0;
+        while (argv[3 + count]) count++;
+        if (opt == e_client && count == 0)
+        {
+            printf("\n[ERROR] Usage: ./stego -C <socket> -e|-d|-p <file>...\n");
+            return 1;
+        }
+
+        const char *local = daemon_local_option(&cli, opt == e_client);
+        if (local)
+        {
+            printf("\n[ERROR] %s cannot be used with %s\n", local, opt == e_client ? "-C" : "-D");
+            return 1;
+        }
+
+        /* the daemon applies these to every request; the client forwards them with its one */
+        DaemonOptions dopts;
+        memset(&dopts, 0, sizeof(dopts));
+        dopts.workers = cli.threads;
+        dopts.cache_bytes = cli.cache_mb << 20;
+        dopts.depth = cli.depth;
+        dopts.compress = cli.compress;
+        dopts.crc = (opt == e_client) ? cli.crc : cli.crc != 0;    // -1: the daemon's default
+        dopts.scatter = cli.scatter;
+        dopts.ecc = cli.ecc;
+        dopts.passphrase = cli.passphrase[0] ? cli.passphrase : NULL;
+
+        Status ret = (opt == e_daemon) ? run_daemon(argv[2], &dopts) : run_client(argv[2], argv + 3, count, &dopts);
+        if (ret != e_success)
+        {
+            return 1;
         }
     }
 
@@ -102,7 +722,9 @@ int main(int argc, char *argv[])
     else
     {
         printf("\n[ERROR] Unsupported operation selected!\n");
-        printf("Use -e for encoding or -d for decoding\n");
+        printf("Use -e for encoding, -d for decoding, -b for a batch manifest, -p to probe, -c for a container, -i to index covers\n");
+        printf("or -s / -m to spread a secret over several images and put it back together\n");
+        printf("or -D / -C to run a daemon and send it requests\n");
         return 1; // exit with failure
     }
 
@@ -6,13 +6,29 @@ typedef unsigned int uint;    // short name for unsigned int
 typedef enum
 {
     e_success,                // function completed correctly
-    e_failure                 // function failed to complete
+    e_failure,                // function failed to complete
+    e_bad_image,              // input is not a BMP image we can use
+    e_no_capacity,            // image too small to hide the secret
+    e_no_secret,              // magic signature not found
+    e_bad_header,             // hidden header fields are corrupt
+    e_short_buffer,           // caller's buffer or input too short
+    e_bad_data,               // hidden data does not decode (corrupt)
+    e_bad_crc,                // hidden data does not match its checksum or parity
+    e_bad_key                 // passphrase missing or wrong
 } Status;                     // used as function return type
 
 typedef enum
 {
     e_encode,                 // -e user wants to perform encoding
     e_decode,                 // -d user wants to perform decoding
+    e_batch,                  // -b user wants to run a manifest of jobs
+    e_probe,                  // -p user wants to check files for hidden data
+    e_container,              // -c user wants to hide several files in one image
+    e_index,                  // -i user wants to build or update a cover index
+    e_span,                   // -s user wants to spread one secret over several images
+    e_merge,                  // -m user wants to put a spread secret back together
+    e_daemon,                 // -D user wants to serve requests on a socket
+    e_client,                 // -C user wants to send one request to a daemon
     e_unsupported             // user passed some other wrong option
 } OperationType;              // used to select steganography operation
 